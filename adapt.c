@@ -0,0 +1,289 @@
+/*
+ * ProFTPD - mod_explain: load-adaptive verbosity
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Under pressure, we would rather keep the cheap explanations and shed the
+ * expensive ones.  Thus the configured verbosity is downgraded while any of
+ * these signals are over their thresholds: the recent time taken by this
+ * session's explanations (a decaying average), the system load average,
+ * and the number of active sessions, per the scoreboard.
+ */
+
+#include "adapt.h"
+
+#define ADAPT_MAX_LEVEL			2
+
+/* The average explanation time halves every this many milliseconds, when
+ * there are no further explanations (e.g. because they are being shed).
+ */
+#define ADAPT_USECS_HALF_LIFE_MS	10000
+
+/* Signals must drop to this fraction of a threshold, before being judged to
+ * be under it again.
+ */
+#define ADAPT_HYSTERESIS		0.8
+
+static int adapt_enabled = FALSE;
+static unsigned int adapt_level = 0;
+
+static unsigned long adapt_max_usecs = 0;
+static double adapt_max_loadavg = 0.0;
+static unsigned int adapt_max_sessions = 0;
+
+static double adapt_usecs = 0.0;
+static uint64_t adapt_usecs_ms = 0;
+static double adapt_loadavg = 0.0;
+static uint64_t adapt_loadavg_ms = 0;
+static unsigned int adapt_nsessions = 0;
+static uint64_t adapt_sessions_ms = 0;
+
+/* From the most verbose, to the least. */
+static unsigned int adapt_verbosities[] = {
+  PR_ERROR_FORMAT_USE_DETAILED,
+  PR_ERROR_FORMAT_USE_TERSE,
+  PR_ERROR_FORMAT_USE_MINIMAL
+};
+
+static const char *trace_channel = "explain.adapt";
+
+static uint64_t get_now_ms(void) {
+  struct timespec now;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
+    return 0;
+  }
+
+  return ((uint64_t) now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+}
+
+static void decay_usecs(uint64_t now_ms) {
+  uint64_t elapsed_ms;
+
+  if (adapt_usecs_ms == 0 ||
+      now_ms <= adapt_usecs_ms) {
+    return;
+  }
+
+  elapsed_ms = now_ms - adapt_usecs_ms;
+  while (elapsed_ms >= ADAPT_USECS_HALF_LIFE_MS &&
+         adapt_usecs > 0.0) {
+    adapt_usecs /= 2;
+    elapsed_ms -= ADAPT_USECS_HALF_LIFE_MS;
+  }
+
+  adapt_usecs *= 1.0 - (0.5 * elapsed_ms / ADAPT_USECS_HALF_LIFE_MS);
+  adapt_usecs_ms = now_ms;
+}
+
+static unsigned int get_raw_level(double value, double threshold) {
+  if (value >= threshold * 2) {
+    return 2;
+  }
+
+  if (value >= threshold) {
+    return 1;
+  }
+
+  return 0;
+}
+
+static unsigned int get_level(double value, double threshold) {
+  unsigned int level;
+
+  if (threshold <= 0.0) {
+    return 0;
+  }
+
+  level = get_raw_level(value, threshold);
+
+  /* Only step down once clear of the threshold. */
+  if (level < adapt_level) {
+    unsigned int hyst_level;
+
+    hyst_level = get_raw_level(value / ADAPT_HYSTERESIS, threshold);
+    if (hyst_level > adapt_level) {
+      hyst_level = adapt_level;
+    }
+
+    if (hyst_level > level) {
+      level = hyst_level;
+    }
+  }
+
+  return level;
+}
+
+static unsigned int get_nsessions(uint64_t now_ms) {
+  unsigned int nsessions = 0;
+
+  if (adapt_sessions_ms != 0 &&
+      now_ms - adapt_sessions_ms < EXPLAIN_ADAPT_SESSIONS_INTERVAL * 1000) {
+    return adapt_nsessions;
+  }
+
+  adapt_sessions_ms = now_ms;
+
+  if (pr_rewind_scoreboard() < 0) {
+    pr_trace_msg(trace_channel, 9, "error rewinding scoreboard: %s",
+      strerror(errno));
+    return adapt_nsessions;
+  }
+
+  while (pr_scoreboard_entry_read() != NULL) {
+    pr_signals_handle();
+    nsessions++;
+  }
+
+  (void) pr_restore_scoreboard();
+
+  adapt_nsessions = nsessions;
+  return adapt_nsessions;
+}
+
+static double get_loadavg(uint64_t now_ms) {
+#if defined(HAVE_GETLOADAVG)
+  double loadavg[1];
+
+  if (adapt_loadavg_ms != 0 &&
+      now_ms - adapt_loadavg_ms < 1000) {
+    return adapt_loadavg;
+  }
+
+  adapt_loadavg_ms = now_ms;
+
+  if (getloadavg(loadavg, 1) == 1) {
+    adapt_loadavg = loadavg[0];
+  }
+#endif /* HAVE_GETLOADAVG */
+
+  return adapt_loadavg;
+}
+
+void explain_adapt_record(unsigned long usecs) {
+  uint64_t now_ms;
+
+  if (adapt_enabled == FALSE) {
+    return;
+  }
+
+  now_ms = get_now_ms();
+  decay_usecs(now_ms);
+
+  if (adapt_usecs_ms == 0) {
+    adapt_usecs = (double) usecs;
+
+  } else {
+    adapt_usecs = (adapt_usecs * 0.75) + (usecs * 0.25);
+  }
+
+  adapt_usecs_ms = now_ms;
+}
+
+unsigned int explain_adapt_get_verbosity(unsigned int verbosity) {
+  register unsigned int i;
+  unsigned int level = 0, signal_level, idx = 0;
+  uint64_t now_ms;
+
+  if (adapt_enabled == FALSE) {
+    return verbosity;
+  }
+
+  now_ms = get_now_ms();
+
+  decay_usecs(now_ms);
+  level = get_level(adapt_usecs, (double) adapt_max_usecs);
+
+  if (level < ADAPT_MAX_LEVEL &&
+      adapt_max_loadavg > 0.0) {
+    signal_level = get_level(get_loadavg(now_ms), adapt_max_loadavg);
+    if (signal_level > level) {
+      level = signal_level;
+    }
+  }
+
+  if (level < ADAPT_MAX_LEVEL &&
+      adapt_max_sessions > 0) {
+    signal_level = get_level((double) get_nsessions(now_ms),
+      (double) adapt_max_sessions);
+    if (signal_level > level) {
+      level = signal_level;
+    }
+  }
+
+  if (level != adapt_level) {
+    pr_trace_msg(trace_channel, 5,
+      "%s verbosity (level %u to %u): %.0f usecs average, load average %.2f, "
+      "%u sessions", level > adapt_level ? "downgrading" : "upgrading",
+      adapt_level, level, adapt_usecs, adapt_loadavg, adapt_nsessions);
+    adapt_level = level;
+  }
+
+  for (i = 0; i < 3; i++) {
+    if (adapt_verbosities[i] == verbosity) {
+      idx = i;
+      break;
+    }
+  }
+
+  idx += adapt_level;
+  if (idx > 2) {
+    idx = 2;
+  }
+
+  return adapt_verbosities[idx];
+}
+
+int explain_adapt_init(pool *p, unsigned long max_usecs, double max_loadavg,
+    unsigned int max_sessions) {
+  if (p == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  explain_adapt_free();
+
+  if (max_loadavg < 0.0) {
+    long ncpus;
+
+    ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    max_loadavg = ncpus > 0 ? (double) ncpus * 2 : 0.0;
+  }
+
+  adapt_max_usecs = max_usecs;
+  adapt_max_loadavg = max_loadavg;
+  adapt_max_sessions = max_sessions;
+  adapt_enabled = TRUE;
+
+  pr_trace_msg(trace_channel, 9,
+    "adapting verbosity to explanation time (%lu usecs), load average "
+    "(%.2f), active sessions (%u)", max_usecs, max_loadavg, max_sessions);
+  return 0;
+}
+
+void explain_adapt_free(void) {
+  adapt_enabled = FALSE;
+  adapt_level = 0;
+  adapt_usecs = adapt_loadavg = 0.0;
+  adapt_usecs_ms = adapt_loadavg_ms = adapt_sessions_ms = 0;
+  adapt_nsessions = 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * ProFTPD - mod_explain: load-adaptive verbosity
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_ADAPT_H
+#define MOD_EXPLAIN_ADAPT_H
+
+#include "mod_explain.h"
+
+/* Defaults, when enabled: the session's recent explanations averaging 2ms,
+ * or a 1-minute load average of twice the number of online CPUs.  The
+ * number of active sessions is not considered by default.
+ */
+#define EXPLAIN_ADAPT_DEFAULT_MAX_USECS		2000
+
+/* How long, in seconds, the number of active sessions is trusted, before
+ * the scoreboard is read again.
+ */
+#define EXPLAIN_ADAPT_SESSIONS_INTERVAL		5
+
+/* Thresholds of zero disable their signals; a max_loadavg below zero uses
+ * the default.
+ */
+int explain_adapt_init(pool *p, unsigned long max_usecs, double max_loadavg,
+  unsigned int max_sessions);
+void explain_adapt_free(void);
+
+/* Records the time taken by an explanation just made. */
+void explain_adapt_record(unsigned long usecs);
+
+/* Returns the verbosity to use now, in place of the given (configured)
+ * verbosity: downgraded by one level (detailed to terse, terse to minimal)
+ * when any signal crosses its threshold, and by two levels when any signal
+ * crosses twice its threshold.  Signals must drop back well below their
+ * thresholds before the verbosity is upgraded again.
+ */
+unsigned int explain_adapt_get_verbosity(unsigned int verbosity);
+
+#endif /* MOD_EXPLAIN_ADAPT_H */
@@ -0,0 +1,290 @@
+/*
+ * ProFTPD - mod_explain: batched explanations
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Recursive operations tend to fail on many paths sharing the same
+ * directories.  Explaining each failure alone would probe those directories
+ * over and over; instead, we build a trie of all of the paths, probe each
+ * node once, level by level, and then explain each failure from the
+ * recorded results.
+ */
+
+#include "batch.h"
+#include "path.h"
+#include "probe.h"
+#include "chroot.h"
+#include "lstat.h"
+#include "stat.h"
+#include "unlink.h"
+
+struct batch_node {
+  const char *path;
+  unsigned int depth;
+
+  struct batch_node *parent;
+
+  struct explain_path_probe probe;
+  int probed;
+
+  /* Next node at the same depth, for the level-by-level probing. */
+  struct batch_node *next;
+};
+
+static const char *trace_channel = "explain.batch";
+
+/* The nodes are indexed by their full paths, which are unique; thus a
+ * node's children need no index of their own.
+ */
+static struct batch_node *batch_add_node(pool *p, pr_table_t *index,
+    struct batch_node *parent, const char *path, struct batch_node **levels,
+    unsigned int *nnodes) {
+  struct batch_node *node;
+
+  node = (struct batch_node *) pr_table_get(index, path, NULL);
+  if (node != NULL) {
+    return node;
+  }
+
+  node = pcalloc(p, sizeof(struct batch_node));
+  node->path = path;
+  node->depth = parent->depth + 1;
+  node->parent = parent;
+
+  (void) pr_table_add(index, path, node, sizeof(struct batch_node *));
+
+  node->next = levels[node->depth];
+  levels[node->depth] = node;
+  (*nnodes)++;
+
+  return node;
+}
+
+/* A node needs probing only if every directory above it was found to be
+ * searchable; any failure beneath one that was not stops at that one.
+ */
+static int batch_want_probe(struct batch_node *node) {
+  struct batch_node *parent;
+
+  parent = node->parent;
+  if (parent == NULL ||
+      parent->depth == 0) {
+    return TRUE;
+  }
+
+  if (parent->probed == FALSE ||
+      parent->probe.xerrno != 0) {
+    return FALSE;
+  }
+
+  return (S_ISDIR(parent->probe.st.st_mode) ||
+    S_ISLNK(parent->probe.st.st_mode)) ? TRUE : FALSE;
+}
+
+static void batch_probe_level(pool *p, struct batch_node *level,
+    pr_table_t *memo) {
+  register unsigned int i;
+  struct batch_node *node, **nodes;
+  const char **paths;
+  struct stat *sts;
+  int *errnos;
+  unsigned int nnodes = 0;
+
+  for (node = level; node != NULL; node = node->next) {
+    if (batch_want_probe(node) == TRUE) {
+      nnodes++;
+    }
+  }
+
+  if (nnodes == 0) {
+    return;
+  }
+
+  nodes = pcalloc(p, sizeof(struct batch_node *) * nnodes);
+  paths = pcalloc(p, sizeof(char *) * nnodes);
+  sts = pcalloc(p, sizeof(struct stat) * nnodes);
+  errnos = pcalloc(p, sizeof(int) * nnodes);
+
+  i = 0;
+  for (node = level; node != NULL; node = node->next) {
+    if (batch_want_probe(node) == TRUE) {
+      nodes[i] = node;
+      paths[i] = node->path;
+      i++;
+    }
+  }
+
+  if (explain_probe_lstat_batch(p, paths, nnodes, sts, errnos) < 0) {
+    for (i = 0; i < nnodes; i++) {
+      pr_signals_handle();
+
+      errnos[i] = 0;
+      if (explain_probe_lstat(p, paths[i], &(sts[i])) < 0) {
+        errnos[i] = errno;
+      }
+    }
+  }
+
+  for (i = 0; i < nnodes; i++) {
+    node = nodes[i];
+    node->probed = TRUE;
+    node->probe.xerrno = errnos[i];
+    if (errnos[i] == 0) {
+      memcpy(&(node->probe.st), &(sts[i]), sizeof(struct stat));
+    }
+
+    (void) pr_table_add(memo, node->path, &(node->probe),
+      sizeof(struct explain_path_probe));
+  }
+}
+
+static const char *batch_explain_entry(pool *p,
+    struct explain_batch_entry *entry, unsigned int verbosity) {
+  const char *explained = NULL;
+
+  switch (entry->syscall_id) {
+    case EXPLAIN_SYSCALL_CHROOT:
+      explained = explain_chroot_error(p, entry->xerrno, entry->path,
+        verbosity, &(entry->args));
+      break;
+
+    case EXPLAIN_SYSCALL_LSTAT:
+      explained = explain_lstat_error(p, entry->xerrno, entry->path, NULL,
+        verbosity, &(entry->args));
+      break;
+
+    case EXPLAIN_SYSCALL_STAT:
+      explained = explain_stat_error(p, entry->xerrno, entry->path, NULL,
+        verbosity, &(entry->args));
+      break;
+
+    case EXPLAIN_SYSCALL_UNLINK:
+      explained = explain_unlink_error(p, entry->xerrno, entry->path,
+        verbosity, &(entry->args));
+      break;
+
+    default:
+      errno = ENOSYS;
+      break;
+  }
+
+  return explained;
+}
+
+int explain_batch_explain(pool *p, struct explain_batch_entry *entries,
+    unsigned int nentries, unsigned int verbosity) {
+  register unsigned int i;
+  pool *tmp_pool;
+  struct batch_node *root, **levels;
+  pr_table_t *index, *memo;
+  const char ***prefixes;
+  unsigned int *nprefixes, max_depth = 0, nnodes = 0, total = 0;
+  int nexplained = 0;
+
+  if (p == NULL ||
+      entries == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  tmp_pool = make_sub_pool(p);
+  pr_pool_tag(tmp_pool, "Explain batch pool");
+
+  /* First, split each path, noting the deepest, to size our per-level
+   * lists, and the number of prefixes, to size our index.
+   */
+  prefixes = pcalloc(tmp_pool, sizeof(const char **) * (nentries + 1));
+  nprefixes = pcalloc(tmp_pool, sizeof(unsigned int) * (nentries + 1));
+
+  for (i = 0; i < nentries; i++) {
+    entries[i].explained = NULL;
+    entries[i].args = NULL;
+
+    if (entries[i].path == NULL) {
+      continue;
+    }
+
+    prefixes[i] = explain_path_get_prefixes(tmp_pool, entries[i].path,
+      &(nprefixes[i]));
+    if (prefixes[i] == NULL) {
+      continue;
+    }
+
+    if (nprefixes[i] > max_depth) {
+      max_depth = nprefixes[i];
+    }
+
+    total += nprefixes[i];
+  }
+
+  index = pr_table_nalloc(tmp_pool, 0, total > 0 ? total : 1);
+  root = pcalloc(tmp_pool, sizeof(struct batch_node));
+  levels = pcalloc(tmp_pool, sizeof(struct batch_node *) * (max_depth + 1));
+
+  for (i = 0; i < nentries; i++) {
+    register unsigned int j;
+    struct batch_node *node;
+
+    node = root;
+    for (j = 0; j < nprefixes[i]; j++) {
+      node = batch_add_node(tmp_pool, index, node, prefixes[i][j], levels,
+        &nnodes);
+    }
+  }
+
+  memo = pr_table_nalloc(tmp_pool, 0, nnodes > 0 ? nnodes : 1);
+
+  /* Check the home anchor once for the whole batch, not once per entry. */
+  (void) explain_probe_check_home(tmp_pool);
+  for (i = 1; i <= max_depth; i++) {
+    pr_signals_handle();
+    batch_probe_level(tmp_pool, levels[i], memo);
+  }
+
+  pr_trace_msg(trace_channel, 15,
+    "probed trie of %u nodes, for %u paths", nnodes, nentries);
+
+  explain_path_set_memo(memo);
+
+  for (i = 0; i < nentries; i++) {
+    const char *explained;
+
+    if (entries[i].path == NULL) {
+      continue;
+    }
+
+    explained = batch_explain_entry(tmp_pool, &(entries[i]), verbosity);
+    if (explained != NULL) {
+      entries[i].explained = pstrdup(p, explained);
+      nexplained++;
+    }
+
+    if (entries[i].args != NULL) {
+      entries[i].args = pstrdup(p, entries[i].args);
+    }
+  }
+
+  explain_path_set_memo(NULL);
+  destroy_pool(tmp_pool);
+
+  return nexplained;
+}
@@ -0,0 +1,59 @@
+/*
+ * ProFTPD - mod_explain: batched explanations
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_BATCH_H
+#define MOD_EXPLAIN_BATCH_H
+
+#include "mod_explain.h"
+
+struct explain_batch_entry {
+  unsigned int syscall_id;
+  int xerrno;
+  const char *path;
+
+  /* Filled in by explain_batch_explain(); explained is NULL if the failure
+   * could not be explained.
+   */
+  const char *explained;
+  const char *args;
+};
+
+/* Explains all of the given failures (e.g. of a recursive operation)
+ * together.  The paths are gathered into a trie of their components, and
+ * each distinct directory is probed once, rather than once per failure;
+ * directories beneath one which cannot be searched are not probed at all.
+ * Only failures of path-based syscalls (chroot, lstat, stat, unlink) are
+ * explained.  Returns the number of entries explained, or -1 on error.
+ *
+ * Unlike failures explained as they happen, these do not go through
+ * mod_explain's dispatch: no ExplainSyscalls policy, rate limits, statistics,
+ * journal records, or events.  The batched failures (e.g. those replayed by
+ * ftpexplain from a journal or log) were already admitted and accounted for
+ * when they happened; accounting for them again would count them twice, and
+ * re-journal them.
+ */
+int explain_batch_explain(pool *p, struct explain_batch_entry *entries,
+  unsigned int nentries, unsigned int verbosity);
+
+#endif /* MOD_EXPLAIN_BATCH_H */
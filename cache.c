@@ -0,0 +1,339 @@
+/*
+ * ProFTPD - mod_explain: explanation cache
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Repeated failures tend to be identical: a client retrying the same
+ * missing path, say.  Thus we keep the finished explanations, keyed by the
+ * syscall, errno, path, and user, in a small LRU cache.  Each is validated
+ * by the (st_dev, st_ino, st_ctime) of the prefix upon which it depends; any
+ * change to that prefix (or its entries) changes its ctime, and so a repeated
+ * failure can be explained with one probe, rather than a full walk.
+ */
+
+#include "cache.h"
+#include "path.h"
+#include "probe.h"
+
+struct explain_cache_entry {
+  struct explain_cache_entry *prev, *next;
+  pool *pool;
+  const char *key;
+
+  const char *explained;
+  const char *args;
+
+  /* The failing component, if any, found by the explanation. */
+  int failure_idx;
+  const char *failure_path;
+  unsigned int failure_reason;
+
+  /* The prefix, and its attributes, when the explanation was made. */
+  const char *prefix;
+  dev_t dev;
+  ino_t ino;
+  time_t ctime;
+};
+
+static pool *cache_pool = NULL;
+static pr_table_t *cache_tab = NULL;
+static unsigned int cache_max_entries = 0, cache_nentries = 0;
+
+/* Most recently used first. */
+static struct explain_cache_entry *cache_head = NULL, *cache_tail = NULL;
+
+static unsigned long cache_nhits = 0, cache_nmisses = 0, cache_nevictions = 0;
+
+static const char *trace_channel = "explain.cache";
+
+static const char *cache_key(pool *p, unsigned int syscall_id, int xerrno,
+    const char *path) {
+  char buf[64];
+
+  memset(buf, '\0', sizeof(buf));
+  snprintf(buf, sizeof(buf)-1, "%u:%d:%lu:", syscall_id, xerrno,
+    (unsigned long) geteuid());
+  return pstrcat(p, buf, path, NULL);
+}
+
+static void cache_unlink(struct explain_cache_entry *entry) {
+  if (entry->prev != NULL) {
+    entry->prev->next = entry->next;
+
+  } else {
+    cache_head = entry->next;
+  }
+
+  if (entry->next != NULL) {
+    entry->next->prev = entry->prev;
+
+  } else {
+    cache_tail = entry->prev;
+  }
+
+  entry->prev = entry->next = NULL;
+}
+
+static void cache_push(struct explain_cache_entry *entry) {
+  entry->prev = NULL;
+  entry->next = cache_head;
+
+  if (cache_head != NULL) {
+    cache_head->prev = entry;
+  }
+
+  cache_head = entry;
+  if (cache_tail == NULL) {
+    cache_tail = entry;
+  }
+}
+
+static void cache_remove(struct explain_cache_entry *entry) {
+  (void) pr_table_remove(cache_tab, entry->key, NULL);
+  cache_unlink(entry);
+  destroy_pool(entry->pool);
+  cache_nentries--;
+}
+
+const char *explain_cache_get(pool *p, unsigned int syscall_id, int xerrno,
+    const char *path, const char **args) {
+  struct explain_cache_entry *entry;
+  const char *key;
+  struct stat st;
+
+  /* Whatever happens, the prefix (and failure) of any previous explanation
+   * is stale.
+   */
+  explain_path_clear_prefix();
+  explain_path_clear_failure();
+
+  if (p == NULL ||
+      path == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  if (cache_tab == NULL) {
+    errno = ENOENT;
+    return NULL;
+  }
+
+  key = cache_key(p, syscall_id, xerrno, path);
+  entry = (struct explain_cache_entry *) pr_table_get(cache_tab, key, NULL);
+  if (entry == NULL) {
+    cache_nmisses++;
+    errno = ENOENT;
+    return NULL;
+  }
+
+  if (explain_probe_lstat(p, entry->prefix, &st) < 0 ||
+      st.st_dev != entry->dev ||
+      st.st_ino != entry->ino ||
+      st.st_ctime != entry->ctime) {
+    pr_trace_msg(trace_channel, 15,
+      "cached explanation for '%s' invalidated by change to '%s'", path,
+      entry->prefix);
+    cache_remove(entry);
+    cache_nmisses++;
+    errno = ENOENT;
+    return NULL;
+  }
+
+  cache_unlink(entry);
+  cache_push(entry);
+  cache_nhits++;
+
+  pr_trace_msg(trace_channel, 19, "using cached explanation for '%s'", path);
+
+  if (entry->failure_path != NULL) {
+    (void) explain_path_set_failure(entry->failure_idx, entry->failure_path,
+      entry->failure_reason);
+  }
+
+  if (args != NULL) {
+    *args = entry->args != NULL ? pstrdup(p, entry->args) : NULL;
+  }
+
+  return pstrdup(p, entry->explained);
+}
+
+int explain_cache_add(pool *p, unsigned int syscall_id, int xerrno,
+    const char *path, const char *explained, const char **args) {
+  struct explain_cache_entry *entry;
+  const char *prefix = NULL;
+  struct stat st;
+  int have_st = FALSE;
+
+  if (p == NULL ||
+      path == NULL ||
+      explained == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (cache_tab == NULL ||
+      cache_max_entries == 0) {
+    errno = EPERM;
+    return -1;
+  }
+
+  if (explain_path_get_prefix(&prefix, &st, &have_st) < 0) {
+    pr_trace_msg(trace_channel, 19,
+      "not caching explanation for '%s': no path prefix examined", path);
+    errno = ENOENT;
+    return -1;
+  }
+
+  if (have_st == FALSE &&
+      explain_probe_lstat(p, prefix, &st) < 0) {
+    return -1;
+  }
+
+  /* A ctime of this very second might yet change again within this second,
+   * without our being able to tell; do not cache such explanations.
+   */
+  if (st.st_ctime >= time(NULL)) {
+    pr_trace_msg(trace_channel, 19,
+      "not caching explanation for '%s': '%s' changed too recently", path,
+      prefix);
+    errno = EAGAIN;
+    return -1;
+  }
+
+  entry = (struct explain_cache_entry *) pr_table_get(cache_tab,
+    cache_key(p, syscall_id, xerrno, path), NULL);
+  if (entry != NULL) {
+    cache_remove(entry);
+  }
+
+  if (cache_nentries >= cache_max_entries) {
+    pr_trace_msg(trace_channel, 17, "evicting cached explanation '%s'",
+      cache_tail->key);
+    cache_remove(cache_tail);
+    cache_nevictions++;
+  }
+
+  {
+    pool *entry_pool;
+
+    entry_pool = make_sub_pool(cache_pool);
+    pr_pool_tag(entry_pool, "Explain cache entry pool");
+
+    entry = pcalloc(entry_pool, sizeof(struct explain_cache_entry));
+    entry->pool = entry_pool;
+  }
+
+  entry->key = cache_key(entry->pool, syscall_id, xerrno, path);
+  entry->explained = pstrdup(entry->pool, explained);
+  if (args != NULL &&
+      *args != NULL) {
+    entry->args = pstrdup(entry->pool, *args);
+  }
+
+  {
+    const char *failure_path = NULL;
+
+    if (explain_path_get_failure(&(entry->failure_idx), &failure_path,
+        &(entry->failure_reason)) == 0) {
+      entry->failure_path = pstrdup(entry->pool, failure_path);
+    }
+  }
+
+  entry->prefix = pstrdup(entry->pool, prefix);
+  entry->dev = st.st_dev;
+  entry->ino = st.st_ino;
+  entry->ctime = st.st_ctime;
+
+  if (pr_table_add(cache_tab, entry->key, entry,
+      sizeof(struct explain_cache_entry)) < 0) {
+    int xerrno2 = errno;
+
+    destroy_pool(entry->pool);
+    errno = xerrno2;
+    return -1;
+  }
+
+  cache_push(entry);
+  cache_nentries++;
+
+  pr_trace_msg(trace_channel, 19,
+    "cached explanation for '%s', validated by '%s'", path, prefix);
+  return 0;
+}
+
+void explain_cache_get_counts(unsigned long *nhits, unsigned long *nmisses,
+    unsigned long *nevictions) {
+  if (nhits != NULL) {
+    *nhits = cache_nhits;
+  }
+
+  if (nmisses != NULL) {
+    *nmisses = cache_nmisses;
+  }
+
+  if (nevictions != NULL) {
+    *nevictions = cache_nevictions;
+  }
+}
+
+void explain_cache_clear(void) {
+  while (cache_tail != NULL) {
+    cache_remove(cache_tail);
+  }
+}
+
+int explain_cache_init(pool *p, unsigned int max_entries) {
+  if (p == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (cache_pool != NULL) {
+    explain_cache_free();
+  }
+
+  cache_pool = make_sub_pool(p);
+  pr_pool_tag(cache_pool, "Explain cache pool");
+
+  cache_tab = pr_table_nalloc(cache_pool, 0, (max_entries / 4) + 1);
+  if (max_entries > 0) {
+    (void) pr_table_ctl(cache_tab, PR_TABLE_CTL_SET_MAX_ENTS, &max_entries);
+  }
+
+  cache_max_entries = max_entries;
+  cache_nentries = 0;
+  cache_head = cache_tail = NULL;
+  cache_nhits = cache_nmisses = cache_nevictions = 0;
+
+  return 0;
+}
+
+void explain_cache_free(void) {
+  if (cache_pool != NULL) {
+    destroy_pool(cache_pool);
+    cache_pool = NULL;
+  }
+
+  cache_tab = NULL;
+  cache_max_entries = cache_nentries = 0;
+  cache_head = cache_tail = NULL;
+}
@@ -0,0 +1,60 @@
+/*
+ * ProFTPD - mod_explain: explanation cache
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_CACHE_H
+#define MOD_EXPLAIN_CACHE_H
+
+#include "mod_explain.h"
+
+/* Default number of explanations cached per session. */
+#define EXPLAIN_CACHE_DEFAULT_MAX_ENTRIES	128
+
+/* Looks up the explanation previously made for this failure, by this
+ * user.  If there is one, and the path prefix upon which it depends has not
+ * changed since (as judged by a single probe of that prefix), a copy of it,
+ * and of its arguments, are returned, allocated from the given pool.
+ * Otherwise, returns NULL, with errno set to ENOENT.
+ */
+const char *explain_cache_get(pool *p, unsigned int syscall_id, int xerrno,
+  const char *path, const char **args);
+
+/* Caches the explanation just made for this failure, validated by the path
+ * prefix which that explanation examined; see explain_path_get_prefix().
+ * Explanations which did not depend on any prefix are not cached.
+ */
+int explain_cache_add(pool *p, unsigned int syscall_id, int xerrno,
+  const char *path, const char *explained, const char **args);
+
+/* Returns the running totals of cache lookups which hit, which missed, and
+ * of cached explanations evicted, for this session.
+ */
+void explain_cache_get_counts(unsigned long *nhits, unsigned long *nmisses,
+  unsigned long *nevictions);
+
+void explain_cache_clear(void);
+
+int explain_cache_init(pool *p, unsigned int max_entries);
+void explain_cache_free(void);
+
+#endif /* MOD_EXPLAIN_CACHE_H */
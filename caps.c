@@ -0,0 +1,317 @@
+/*
+ * ProFTPD - mod_explain: process capabilities
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#include "caps.h"
+
+/* The snapshot of our privileges, taken once at session init.  A root
+ * process in a container may lack e.g. CAP_SYS_CHROOT, and there is no point
+ * in walking paths to explain an EPERM that is due to missing capabilities.
+ *
+ * The snapshot is taken after the session has switched to the user's
+ * effective UID, which empties the effective set; the privileged operations
+ * are done after switching back to root, which restores the effective set
+ * from the permitted set.  Thus only the permitted set tells us which
+ * capabilities those operations have.
+ *
+ * Other modules (e.g. mod_cap) may drop capabilities after login, i.e. after
+ * the snapshot is taken; such a snapshot is expired, and re-read on its next
+ * use.
+ */
+static int caps_have_snapshot = FALSE;
+static int caps_stale = FALSE;
+static uint64_t caps_effective = 0;
+static uint64_t caps_permitted = 0;
+static int caps_seccomp_mode = -1;
+static int caps_no_new_privs = -1;
+
+static const char *trace_channel = "explain.caps";
+
+struct cap_name {
+  unsigned int cap;
+  const char *name;
+};
+
+static struct cap_name cap_names[] = {
+  { EXPLAIN_CAP_FOWNER,			"CAP_FOWNER" },
+  { EXPLAIN_CAP_SYS_CHROOT,		"CAP_SYS_CHROOT" },
+
+  { 0, NULL }
+};
+
+static const char *get_cap_name(unsigned int cap) {
+  register unsigned int i;
+
+  for (i = 0; cap_names[i].name != NULL; i++) {
+    if (cap_names[i].cap == cap) {
+      return cap_names[i].name;
+    }
+  }
+
+  return "unknown";
+}
+
+/* Returns a pointer to the value of the given "Name:\tvalue" field, or NULL
+ * if the field is not present.
+ */
+static const char *get_status_field(const char *text, size_t text_len,
+    const char *name) {
+  const char *ptr, *end;
+  size_t name_len;
+
+  name_len = strlen(name);
+  end = text + text_len;
+
+  for (ptr = text; ptr != NULL && ptr < end;) {
+    const char *eol;
+
+    if ((size_t) (end - ptr) > name_len &&
+        strncmp(ptr, name, name_len) == 0 &&
+        ptr[name_len] == ':') {
+      ptr += name_len + 1;
+
+      while (ptr < end &&
+             (*ptr == ' ' || *ptr == '\t')) {
+        ptr++;
+      }
+
+      return ptr;
+    }
+
+    eol = memchr(ptr, '\n', end - ptr);
+    if (eol == NULL) {
+      break;
+    }
+
+    ptr = eol + 1;
+  }
+
+  return NULL;
+}
+
+int explain_caps_parse_status(const char *text, size_t text_len) {
+  const char *val;
+
+  if (text == NULL ||
+      text_len == 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  val = get_status_field(text, text_len, "CapEff");
+  if (val == NULL) {
+    /* Without the effective set, the rest of the snapshot is of little use. */
+    pr_trace_msg(trace_channel, 9, "no CapEff field found in status text");
+    errno = ENOENT;
+    return -1;
+  }
+
+  caps_effective = (uint64_t) strtoull(val, NULL, 16);
+
+  val = get_status_field(text, text_len, "CapPrm");
+  if (val != NULL) {
+    caps_permitted = (uint64_t) strtoull(val, NULL, 16);
+
+  } else {
+    caps_permitted = caps_effective;
+  }
+
+  val = get_status_field(text, text_len, "Seccomp");
+  if (val != NULL) {
+    caps_seccomp_mode = atoi(val);
+  }
+
+  val = get_status_field(text, text_len, "NoNewPrivs");
+  if (val != NULL) {
+    caps_no_new_privs = (atoi(val) != 0) ? TRUE : FALSE;
+  }
+
+  caps_have_snapshot = TRUE;
+  caps_stale = FALSE;
+
+  pr_trace_msg(trace_channel, 17,
+    "capabilities: effective = 0x%016llx, permitted = 0x%016llx, "
+    "seccomp mode = %d, no_new_privs = %d",
+    (unsigned long long) caps_effective, (unsigned long long) caps_permitted,
+    caps_seccomp_mode, caps_no_new_privs);
+  return 0;
+}
+
+int explain_caps_have_effective(unsigned int cap) {
+  if (caps_have_snapshot == FALSE) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  if (cap > 63) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return (caps_effective & ((uint64_t) 1 << cap)) ? TRUE : FALSE;
+}
+
+int explain_caps_have_permitted(unsigned int cap) {
+  if (caps_have_snapshot == FALSE) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  if (cap > 63) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return (caps_permitted & ((uint64_t) 1 << cap)) ? TRUE : FALSE;
+}
+
+int explain_caps_seccomp_mode(void) {
+  if (caps_have_snapshot == FALSE ||
+      caps_seccomp_mode < 0) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  return caps_seccomp_mode;
+}
+
+int explain_caps_no_new_privs(void) {
+  if (caps_have_snapshot == FALSE ||
+      caps_no_new_privs < 0) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  return caps_no_new_privs;
+}
+
+const char *explain_caps_describe_eperm(pool *p, const char *syscall,
+    unsigned int cap) {
+  const char *explained = NULL;
+
+  if (p == NULL ||
+      syscall == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  if (caps_stale == TRUE &&
+      explain_caps_init(p) < 0) {
+    pr_trace_msg(trace_channel, 9, "unable to refresh capabilities: %s",
+      strerror(errno));
+  }
+
+  if (caps_have_snapshot == FALSE) {
+    errno = ENOENT;
+    return NULL;
+  }
+
+  if (explain_caps_have_permitted(cap) == FALSE) {
+    explained = pstrcat(p, "the process lacks the ", get_cap_name(cap),
+      " capability required for the ", syscall, " system call", NULL);
+
+    if (caps_no_new_privs == TRUE) {
+      explained = pstrcat(p, explained,
+        ", and cannot regain it since no_new_privs is set", NULL);
+    }
+
+    return explained;
+  }
+
+  /* Strict mode allows only a handful of syscalls, none of which we
+   * explain.  A seccomp filter, on the other hand, is applied by most
+   * container runtimes and service managers, and we cannot tell which
+   * syscalls it rejects; it proves nothing.
+   */
+  if (caps_seccomp_mode == EXPLAIN_SECCOMP_MODE_STRICT) {
+    return pstrcat(p, "the process is in strict seccomp mode, which does "
+      "not allow the ", syscall, " system call", NULL);
+  }
+
+  errno = ENOENT;
+  return NULL;
+}
+
+int explain_caps_init(pool *p) {
+#if defined(__linux__)
+  int fd, res, xerrno;
+  char buf[8192];
+  ssize_t buflen;
+
+  (void) p;
+
+  caps_have_snapshot = caps_stale = FALSE;
+  caps_seccomp_mode = -1;
+  caps_no_new_privs = -1;
+
+  /* Note that we deliberately read /proc directly, rather than via the FSIO
+   * API; the FSIO layer might map "/proc" elsewhere.
+   */
+  fd = open("/proc/self/status", O_RDONLY);
+  if (fd < 0) {
+    xerrno = errno;
+
+    pr_trace_msg(trace_channel, 3, "unable to read /proc/self/status: %s",
+      strerror(xerrno));
+
+    errno = xerrno;
+    return -1;
+  }
+
+  memset(buf, '\0', sizeof(buf));
+  buflen = read(fd, buf, sizeof(buf)-1);
+  xerrno = errno;
+  (void) close(fd);
+
+  if (buflen <= 0) {
+    pr_trace_msg(trace_channel, 3, "unable to read /proc/self/status: %s",
+      buflen < 0 ? strerror(xerrno) : "empty file");
+
+    errno = (buflen < 0 ? xerrno : ENOENT);
+    return -1;
+  }
+
+  res = explain_caps_parse_status(buf, (size_t) buflen);
+  return res;
+#else
+  (void) p;
+
+  errno = ENOSYS;
+  return -1;
+#endif /* Linux */
+}
+
+void explain_caps_expire(void) {
+  if (caps_have_snapshot == TRUE) {
+    caps_stale = TRUE;
+  }
+}
+
+void explain_caps_free(pool *p) {
+  (void) p;
+
+  caps_have_snapshot = caps_stale = FALSE;
+  caps_effective = caps_permitted = 0;
+  caps_seccomp_mode = -1;
+  caps_no_new_privs = -1;
+}
@@ -0,0 +1,75 @@
+/*
+ * ProFTPD - mod_explain: process capabilities
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_CAPS_H
+#define MOD_EXPLAIN_CAPS_H
+
+#include "mod_explain.h"
+
+/* Linux capability numbers, as found in <linux/capability.h>.  We define
+ * our own, rather than depending on the kernel headers, since we only ever
+ * compare them against the bitmasks read from /proc/self/status.
+ */
+#define EXPLAIN_CAP_FOWNER			3
+#define EXPLAIN_CAP_SYS_CHROOT			18
+
+/* Seccomp modes, as reported in the "Seccomp:" field. */
+#define EXPLAIN_SECCOMP_MODE_DISABLED		0
+#define EXPLAIN_SECCOMP_MODE_STRICT		1
+#define EXPLAIN_SECCOMP_MODE_FILTER		2
+
+/* Parses the given /proc/<pid>/status text into the session snapshot. */
+int explain_caps_parse_status(const char *text, size_t text_len);
+
+/* Returns TRUE if the capability is in the effective set, FALSE if not, and
+ * -1 (with errno set to ENOENT) if no snapshot is available.
+ */
+int explain_caps_have_effective(unsigned int cap);
+int explain_caps_have_permitted(unsigned int cap);
+
+/* Returns the seccomp mode, or -1 (with errno set to ENOENT) if unknown. */
+int explain_caps_seccomp_mode(void);
+
+/* Returns TRUE/FALSE for the no_new_privs flag, or -1 if unknown. */
+int explain_caps_no_new_privs(void);
+
+/* Describes an EPERM for the given syscall, which is governed by the given
+ * capability, using only the snapshot; a capability is only reported as
+ * missing if it is missing from the permitted set, since privileged
+ * operations are done with the permitted set effective.  If the snapshot
+ * does not explain the EPERM (or if there is no snapshot), NULL is returned,
+ * and errno is set to ENOENT.  An expired snapshot is first re-read.
+ */
+const char *explain_caps_describe_eperm(pool *p, const char *syscall,
+  unsigned int cap);
+
+int explain_caps_init(pool *p);
+
+/* Marks the snapshot as stale, e.g. once mod_cap may have dropped
+ * capabilities after login; it is re-read when next needed.
+ */
+void explain_caps_expire(void);
+void explain_caps_free(pool *p);
+
+#endif /* MOD_EXPLAIN_CAPS_H */
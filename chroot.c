@@ -23,6 +23,7 @@
  */
 
 #include "chroot.h"
+#include "caps.h"
 #include "generic.h"
 #include "path.h"
 
@@ -45,12 +46,19 @@ static const char *get_args(pool *p, const char *path) {
 }
 
 const char *explain_chroot_error(pool *p, int xerrno, const char *path,
-    const char **args) {
+    unsigned int verbosity, const char **args) {
   const char *explained = NULL, *syscall = "chroot(2)";
   int path_flags = EXPLAIN_PATH_FL_WANT_SEARCH|EXPLAIN_PATH_FL_MUST_HAVE_MODE;
 
   *args = get_args(p, path);
 
+  /* Minimal formats only report the errno, even for the failures which are
+   * explained without walking the path.
+   */
+  if (verbosity == PR_ERROR_FORMAT_USE_MINIMAL) {
+    return explain_describe_generic(p, xerrno, syscall);
+  }
+
   switch (xerrno) {
     case EPERM:
       if (getuid() != PR_ROOT_UID) {
@@ -58,12 +66,22 @@ const char *explain_chroot_error(pool *p, int xerrno, const char *path,
         break;
       }
 
+      /* Root in a container may still lack CAP_SYS_CHROOT; check our
+       * capabilities snapshot before resorting to walking the path.
+       */
+      explained = explain_caps_describe_eperm(p, syscall,
+        EXPLAIN_CAP_SYS_CHROOT);
+      if (explained != NULL) {
+        break;
+      }
+
     case EACCES:
     case ENOENT:
     case ELOOP:
     case ENAMETOOLONG:
     case ENOTDIR:
-      explained = explain_path_error(p, xerrno, path, path_flags, S_IFDIR);
+      explained = explain_path_describe(p, xerrno, syscall, path,
+        path_flags, S_IFDIR, verbosity);
       break;
 
 #if defined(ENOMEM)
@@ -28,6 +28,6 @@
 #include "mod_explain.h"
 
 const char *explain_chroot_error(pool *p, int xerrno, const char *path,
-  const char **args);
+  unsigned int verbosity, const char **args);
 
 #endif /* MOD_EXPLAIN_CHROOT_H */
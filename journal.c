@@ -0,0 +1,426 @@
+/*
+ * ProFTPD - mod_explain: explanation journal
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Offline analysis of failures wants every explanation, which formatting
+ * (and writing) trace logs cannot afford.  Instead, each explanation is
+ * appended to a shared, memory-mapped ring as a compact binary record: no
+ * formatting, and no syscalls, just a copy into the mapping.
+ */
+
+#include "journal.h"
+#include "platform.h"
+
+#include <sys/mman.h>
+
+#if defined(HAVE___ATOMIC)
+# define journal_add(ptr, n) \
+    __atomic_fetch_add((ptr), (n), __ATOMIC_RELAXED)
+# define journal_load(ptr)	__atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+# define journal_store(ptr, n)	__atomic_store_n((ptr), (n), __ATOMIC_RELEASE)
+# define journal_fence()	__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+# define journal_add(ptr, n)	((*(ptr) += (n)) - (n))
+# define journal_load(ptr)	*(ptr)
+# define journal_store(ptr, n)	*(ptr) = (n)
+# define journal_fence()
+#endif /* HAVE___ATOMIC */
+
+static struct explain_journal_header *journal = NULL;
+static struct explain_journal_record *journal_records = NULL;
+static char *journal_paths = NULL;
+static char journal_path[PR_TUNABLE_PATH_MAX+1];
+
+static const char *trace_channel = "explain.journal";
+
+static struct explain_journal_record *journal_get_records(
+    const struct explain_journal_header *hdr) {
+  return (struct explain_journal_record *) (((char *) hdr) +
+    sizeof(struct explain_journal_header));
+}
+
+static char *journal_get_paths(const struct explain_journal_header *hdr) {
+  return (char *) (journal_get_records(hdr) + hdr->nrecords);
+}
+
+/* Half of the journal holds records, the other half their paths. */
+static void journal_init_header(struct explain_journal_header *hdr,
+    size_t size) {
+  size_t avail;
+
+  memset(hdr, 0, size);
+
+  avail = size - sizeof(struct explain_journal_header);
+  hdr->version = EXPLAIN_JOURNAL_VERSION;
+  hdr->size = (uint32_t) size;
+  hdr->started = (uint64_t) time(NULL);
+  hdr->nrecords = (uint32_t) ((avail / 2) /
+    sizeof(struct explain_journal_record));
+  hdr->paths_size = (uint32_t) (avail -
+    (hdr->nrecords * sizeof(struct explain_journal_record)));
+
+  /* Readers check the magic first, so write it last. */
+  journal_store(&(hdr->magic), EXPLAIN_JOURNAL_MAGIC);
+}
+
+int explain_journal_open(pool *p, const char *path, size_t size) {
+  struct explain_journal_header *hdr;
+  int fd;
+
+  (void) p;
+
+  if (path == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (size == 0) {
+    size = EXPLAIN_JOURNAL_DEFAULT_SIZE;
+  }
+
+  if (size < EXPLAIN_JOURNAL_MIN_SIZE ||
+      size > UINT32_MAX) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (journal != NULL) {
+    if (strcmp(path, journal_path) == 0 &&
+        size == journal->size) {
+      /* Already open; keep appending. */
+      return 0;
+    }
+
+    explain_journal_close();
+  }
+
+  fd = explain_platform_open_file(path, O_RDWR, 0600);
+  if (fd < 0) {
+    int xerrno = errno;
+
+    pr_trace_msg(trace_channel, 1, "error opening ExplainJournal '%s': %s",
+      path, strerror(xerrno));
+
+    errno = xerrno;
+    return -1;
+  }
+
+  if (ftruncate(fd, size) < 0) {
+    int xerrno = errno;
+
+    pr_trace_msg(trace_channel, 1, "error sizing ExplainJournal '%s': %s",
+      path, strerror(xerrno));
+    (void) close(fd);
+
+    errno = xerrno;
+    return -1;
+  }
+
+  hdr = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if (hdr == MAP_FAILED) {
+    int xerrno = errno;
+
+    pr_trace_msg(trace_channel, 1, "error mapping ExplainJournal '%s': %s",
+      path, strerror(xerrno));
+    (void) close(fd);
+
+    errno = xerrno;
+    return -1;
+  }
+
+  (void) close(fd);
+
+  /* Continue an existing journal of the same layout; otherwise, start a new
+   * one.
+   */
+  if (hdr->magic != EXPLAIN_JOURNAL_MAGIC ||
+      hdr->version != EXPLAIN_JOURNAL_VERSION ||
+      hdr->size != size) {
+    journal_init_header(hdr, size);
+  }
+
+  hdr->pid = (uint32_t) getpid();
+
+  journal = hdr;
+  journal_records = journal_get_records(hdr);
+  journal_paths = journal_get_paths(hdr);
+  sstrncpy(journal_path, path, sizeof(journal_path));
+
+  pr_trace_msg(trace_channel, 9,
+    "mapped %lu byte journal from %s (%u records, %u bytes of paths)",
+    (unsigned long) size, path, hdr->nrecords, hdr->paths_size);
+  return 0;
+}
+
+int explain_journal_close(void) {
+  if (journal == NULL) {
+    return 0;
+  }
+
+  if (munmap(journal, journal->size) < 0) {
+    pr_trace_msg(trace_channel, 3, "error unmapping journal: %s",
+      strerror(errno));
+  }
+
+  journal = NULL;
+  journal_records = NULL;
+  journal_paths = NULL;
+  journal_path[0] = '\0';
+  return 0;
+}
+
+int explain_journal_enabled(void) {
+  return journal != NULL ? TRUE : FALSE;
+}
+
+/* Sessions see paths relative to their working directory and root; the
+ * journal outlives them, and is read from outside any chroot.
+ */
+static const char *journal_get_abs_path(const char *path, char *buf,
+    size_t bufsz) {
+  const char *root = "", *cwd = "", *sep = "";
+
+  if (session.chroot_path != NULL &&
+      strcmp(session.chroot_path, "/") != 0) {
+    root = session.chroot_path;
+  }
+
+  if (*path != '/') {
+    cwd = pr_fs_getcwd();
+    if (cwd == NULL) {
+      cwd = "";
+    }
+
+    if (*cwd == '\0' ||
+        cwd[strlen(cwd)-1] != '/') {
+      sep = "/";
+    }
+
+  } else if (*root == '\0') {
+    return path;
+  }
+
+  snprintf(buf, bufsz, "%s%s%s%s", root, cwd, sep, path);
+  buf[bufsz-1] = '\0';
+  return buf;
+}
+
+int explain_journal_append(unsigned int syscall_id, int xerrno,
+    const char *path, int component_idx, unsigned int reason,
+    unsigned long usecs) {
+  struct explain_journal_record record, *slot;
+  uint64_t seq, offset;
+  size_t path_len = 0, max_len;
+  struct timespec ts;
+  char abs_path[PR_TUNABLE_PATH_MAX+1];
+
+  if (journal == NULL) {
+    errno = EPERM;
+    return -1;
+  }
+
+  /* No one path may overwrite most of the path ring. */
+  max_len = journal->paths_size / 2;
+  if (max_len > PR_TUNABLE_PATH_MAX) {
+    max_len = PR_TUNABLE_PATH_MAX;
+  }
+
+  if (path != NULL) {
+    path = journal_get_abs_path(path, abs_path, sizeof(abs_path));
+    path_len = strlen(path);
+    if (path_len > max_len) {
+      path_len = max_len;
+    }
+  }
+
+  seq = journal_add(&(journal->next_seq), 1);
+  offset = journal_add(&(journal->next_path), path_len);
+
+  if (path_len > 0) {
+    size_t start, first_len;
+
+    start = (size_t) (offset % journal->paths_size);
+    first_len = journal->paths_size - start;
+    if (first_len > path_len) {
+      first_len = path_len;
+    }
+
+    memcpy(journal_paths + start, path, first_len);
+    if (first_len < path_len) {
+      memcpy(journal_paths, path + first_len, path_len - first_len);
+    }
+  }
+
+  (void) clock_gettime(CLOCK_REALTIME, &ts);
+
+  record.seq = 0;
+  record.timestamp = ((uint64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+  record.path_offset = offset;
+  record.pid = (uint32_t) session.pid;
+  record.uid = (uint32_t) session.uid;
+  record.gid = (uint32_t) session.gid;
+  record.xerrno = xerrno;
+  record.component_idx = component_idx;
+  record.usecs = (uint32_t) usecs;
+  record.path_len = (uint32_t) path_len;
+  record.syscall_id = (uint16_t) syscall_id;
+  record.reason = (uint16_t) reason;
+
+  /* Readers see the slot as incomplete until its sequence number is set,
+   * after the rest of the record.
+   */
+  slot = &(journal_records[seq % journal->nrecords]);
+  journal_store(&(slot->seq), 0);
+  journal_fence();
+  memcpy(((char *) slot) + sizeof(uint64_t),
+    ((char *) &record) + sizeof(uint64_t),
+    sizeof(struct explain_journal_record) - sizeof(uint64_t));
+  journal_store(&(slot->seq), seq + 1);
+
+  return 0;
+}
+
+int explain_journal_read(const void *region, size_t region_sz,
+    int (*cb)(const struct explain_journal_entry *, void *),
+    void *user_data) {
+  const struct explain_journal_header *hdr;
+  const struct explain_journal_record *records;
+  const char *paths;
+  struct explain_journal_entry entry;
+  uint64_t first_seq, next_seq, seq;
+  int count = 0;
+
+  if (region == NULL ||
+      cb == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  hdr = region;
+  if (region_sz < sizeof(struct explain_journal_header) ||
+      journal_load(&(hdr->magic)) != EXPLAIN_JOURNAL_MAGIC ||
+      hdr->version != EXPLAIN_JOURNAL_VERSION ||
+      hdr->size > region_sz ||
+      hdr->nrecords == 0 ||
+      hdr->paths_size == 0 ||
+      sizeof(struct explain_journal_header) +
+        ((size_t) hdr->nrecords * sizeof(struct explain_journal_record)) +
+        hdr->paths_size > hdr->size) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  records = journal_get_records(hdr);
+  paths = journal_get_paths(hdr);
+
+  next_seq = journal_load(&(hdr->next_seq));
+  first_seq = next_seq > hdr->nrecords ? next_seq - hdr->nrecords : 0;
+
+  for (seq = first_seq; seq < next_seq; seq++) {
+    const struct explain_journal_record *slot;
+    size_t path_len;
+    int res;
+
+    slot = &(records[seq % hdr->nrecords]);
+    if (journal_load(&(slot->seq)) != seq + 1) {
+      /* Incomplete, or already overwritten. */
+      continue;
+    }
+
+    memcpy(&(entry.record), slot, sizeof(struct explain_journal_record));
+    journal_fence();
+    if (journal_load(&(slot->seq)) != seq + 1) {
+      continue;
+    }
+
+    entry.seq = seq;
+    entry.path[0] = '\0';
+
+    path_len = entry.record.path_len;
+    if (path_len > 0 &&
+        path_len <= PR_TUNABLE_PATH_MAX &&
+        path_len <= hdr->paths_size) {
+      size_t start, first_len;
+
+      start = (size_t) (entry.record.path_offset % hdr->paths_size);
+      first_len = hdr->paths_size - start;
+      if (first_len > path_len) {
+        first_len = path_len;
+      }
+
+      memcpy(entry.path, paths + start, first_len);
+      if (first_len < path_len) {
+        memcpy(entry.path + first_len, paths, path_len - first_len);
+      }
+      entry.path[path_len] = '\0';
+
+      /* Discard the path if it has since been overwritten. */
+      journal_fence();
+      if (journal_load(&(hdr->next_path)) >
+          entry.record.path_offset + hdr->paths_size) {
+        entry.path[0] = '\0';
+      }
+    }
+
+    count++;
+    res = (cb)(&entry, user_data);
+    if (res != 0) {
+      break;
+    }
+  }
+
+  return count;
+}
+
+const char *explain_journal_reason_name(unsigned int reason) {
+  switch (reason) {
+    case EXPLAIN_REASON_NAME_TOO_LONG:
+      return "name too long";
+
+    case EXPLAIN_REASON_PATH_TOO_LONG:
+      return "path too long";
+
+    case EXPLAIN_REASON_NO_SUCH_DIR:
+      return "no such directory";
+
+    case EXPLAIN_REASON_NO_SUCH_FILE:
+      return "no such file";
+
+    case EXPLAIN_REASON_NOT_DIR:
+      return "not a directory";
+
+    case EXPLAIN_REASON_DIR_NOT_SEARCHABLE:
+      return "directory not searchable";
+
+    case EXPLAIN_REASON_FILE_NOT_SEARCHABLE:
+      return "file not searchable";
+
+    case EXPLAIN_REASON_DIR_NOT_WRITABLE:
+      return "directory not writable";
+
+    default:
+      break;
+  }
+
+  return "unknown";
+}
@@ -0,0 +1,121 @@
+/*
+ * ProFTPD - mod_explain: explanation journal
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_JOURNAL_H
+#define MOD_EXPLAIN_JOURNAL_H
+
+#include "mod_explain.h"
+
+/* The journal is a file, mapped by the daemon and shared by every session,
+ * holding a header, a ring of fixed-size records, and a ring of the paths
+ * to which those records point.  Records and paths are only ever appended;
+ * the oldest are overwritten once the rings wrap.  Readers detect records,
+ * and paths, overwritten while being read, and skip them.
+ */
+#define EXPLAIN_JOURNAL_MAGIC			0x45584a52
+#define EXPLAIN_JOURNAL_VERSION			1
+
+#define EXPLAIN_JOURNAL_MIN_SIZE		4096
+#define EXPLAIN_JOURNAL_DEFAULT_SIZE		(1024 * 1024)
+
+struct explain_journal_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  uint32_t pid;
+  uint64_t started;
+
+  uint32_t nrecords;
+  uint32_t paths_size;
+
+  /* The sequence number of the next record, and the offset of the next
+   * path, counting from the start of the journal; neither ever wraps.
+   */
+  uint64_t next_seq;
+  uint64_t next_path;
+};
+
+struct explain_journal_record {
+  /* One more than the record's sequence number, once the record is
+   * complete; zero while it is being written.
+   */
+  uint64_t seq;
+
+  /* Microseconds since the epoch. */
+  uint64_t timestamp;
+
+  /* Offset of the path in the path ring, counting as for next_path. */
+  uint64_t path_offset;
+
+  uint32_t pid;
+  uint32_t uid;
+  uint32_t gid;
+  int32_t xerrno;
+
+  /* The failing path component, and why it failed; see struct
+   * explain_event.
+   */
+  int32_t component_idx;
+  uint32_t usecs;
+  uint32_t path_len;
+  uint16_t syscall_id;
+  uint16_t reason;
+};
+
+/* Maps the journal at the given path, of the given total size (zero for the
+ * default), creating it if necessary.  Reopening the same path keeps the
+ * existing mapping.
+ */
+int explain_journal_open(pool *p, const char *path, size_t size);
+int explain_journal_close(void);
+int explain_journal_enabled(void);
+
+/* Appends a record of the given failure, if the journal is open.  Paths
+ * relative to the session's working directory, or beneath its chroot, are
+ * recorded as absolute paths outside any chroot, so that they can be read
+ * and probed afterwards without the session.
+ */
+int explain_journal_append(unsigned int syscall_id, int xerrno,
+  const char *path, int component_idx, unsigned int reason,
+  unsigned long usecs);
+
+/* A record, as decoded by explain_journal_read(); the path is empty if it
+ * was overwritten before it could be read.
+ */
+struct explain_journal_entry {
+  uint64_t seq;
+  struct explain_journal_record record;
+  char path[PR_TUNABLE_PATH_MAX+1];
+};
+
+/* Calls the given callback for each complete record in the mapped journal,
+ * oldest first, stopping if it returns non-zero.  Returns the number of
+ * records read, or -1 (with errno EINVAL) if the region is not a journal.
+ */
+int explain_journal_read(const void *region, size_t region_sz,
+  int (*cb)(const struct explain_journal_entry *, void *), void *user_data);
+
+const char *explain_journal_reason_name(unsigned int reason);
+
+#endif /* MOD_EXPLAIN_JOURNAL_H */
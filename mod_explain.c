@@ -27,11 +27,25 @@
 
 #include "mod_explain.h"
 #include "platform.h"
+#include "adapt.h"
+#include "cache.h"
+#include "caps.h"
+#include "path.h"
+#include "policy.h"
+#include "probe.h"
+#include "ratelimit.h"
+#include "stats.h"
+#include "usdt.h"
+#include "journal.h"
 #include "chroot.h"
 #include "lstat.h"
 #include "stat.h"
 #include "unlink.h"
 
+#if defined(PR_USE_CTRLS)
+# include "mod_ctrls.h"
+#endif /* PR_USE_CTRLS */
+
 extern xaset_t *server_list;
 
 module explain_module;
@@ -40,100 +54,279 @@ pool *explain_pool = NULL;
 unsigned long explain_opts = 0UL;
 
 static int explain_engine = TRUE;
+static const struct explain_policy *explain_policy = NULL;
 static unsigned int explain_verbosity = PR_ERROR_FORMAT_USE_DETAILED;
 
+/* The verbosity currently in use, which may be less than configured. */
+static unsigned int explain_cur_verbosity = PR_ERROR_FORMAT_USE_DETAILED;
+
 static const char *trace_channel = "explain";
 
+#if defined(PR_USE_CTRLS)
+static ctrls_acttab_t explain_acttab[];
+#endif /* PR_USE_CTRLS */
+
 /* Error explainer. */
 
+/* Explanations are made in a scratch pool, so that their intermediate
+ * allocations do not accumulate in the caller's pool; only the final strings
+ * are copied out.
+ */
+static const char *explain_copy_out(pool *p, pool *tmp_pool,
+    const char *explained, const char **args) {
+  if (args != NULL &&
+      *args != NULL) {
+    *args = pstrdup(p, *args);
+  }
+
+  if (explained != NULL) {
+    explained = pstrdup(p, explained);
+  }
+
+  destroy_pool(tmp_pool);
+  return explained;
+}
+
+/* Returns TRUE if this failure should be explained, or FALSE if its
+ * syscall is not explained by the session's policy (errno set to ENOSYS),
+ * or if its explanation is suppressed by the rate limits (errno set to
+ * EAGAIN).
+ * Any change in the verbosity appropriate for the current load is applied
+ * here.  Any rate limit summaries which have come due are made in the given
+ * scratch pool.
+ */
+static int explain_admit(pool *p, unsigned int syscall_id, int xerrno,
+    const char *path) {
+  unsigned int verbosity;
+
+  if (explain_policy_explains(explain_policy, syscall_id) == FALSE) {
+    errno = ENOSYS;
+    return FALSE;
+  }
+
+  if (explain_ratelimit_admit(p, syscall_id, xerrno, path) == FALSE) {
+    explain_stats_suppressed(syscall_id, xerrno);
+    errno = EAGAIN;
+    return FALSE;
+  }
+
+  verbosity = explain_adapt_get_verbosity(explain_verbosity);
+  if (verbosity != explain_cur_verbosity) {
+    pr_error_use_formats(verbosity);
+    explain_cur_verbosity = verbosity;
+
+    /* Cached explanations were made for the previous verbosity. */
+    explain_cache_clear();
+  }
+
+  /* Under load, the verbosity may have been lowered to minimal; the
+   * explainers then skip the walk, as they do when configured so.
+   */
+  return TRUE;
+}
+
+/* Records the explanation just made in the journal, if any, and tells any
+ * interested modules about it; see EXPLAIN_EVENT_EXPLAINED.
+ */
+static void explain_report(unsigned int syscall_id, int xerrno,
+    const char *path, const char *explained) {
+  struct explain_event event;
+  const char *component_path = NULL;
+  int listening;
+
+  listening = (pr_event_listening(EXPLAIN_EVENT_EXPLAINED) > 0);
+  if (listening == FALSE &&
+      explain_journal_enabled() == FALSE) {
+    return;
+  }
+
+  memset(&event, 0, sizeof(event));
+  event.syscall_id = syscall_id;
+  event.xerrno = xerrno;
+
+  if (explain_path_get_failure(&(event.component_idx), &component_path,
+      &(event.reason)) == 0) {
+    event.component_path = component_path;
+
+  } else {
+    event.component_idx = -1;
+    event.reason = EXPLAIN_REASON_UNKNOWN;
+  }
+
+  event.usecs = explain_stats_get_last_usecs();
+  event.explained = explained;
+
+  (void) explain_journal_append(syscall_id, xerrno, path, event.component_idx,
+    event.reason, event.usecs);
+
+  if (listening == TRUE) {
+    pr_event_generate(EXPLAIN_EVENT_EXPLAINED, &event);
+  }
+}
+
+/* The path explainers, as called by explain_dispatch(); those without a
+ * stat buffer ignore it.
+ */
+typedef const char *(*explain_path_explainer_t)(pool *, int, const char *,
+  struct stat *, unsigned int, const char **);
+
+static const char *explain_chroot_cb(pool *p, int xerrno, const char *path,
+    struct stat *st, unsigned int verbosity, const char **args) {
+  return explain_chroot_error(p, xerrno, path, verbosity, args);
+}
+
+static const char *explain_unlink_cb(pool *p, int xerrno, const char *path,
+    struct stat *st, unsigned int verbosity, const char **args) {
+  return explain_unlink_error(p, xerrno, path, verbosity, args);
+}
+
+/* Explains the failure of the given syscall on a path: once admitted, the
+ * explanation is made in a scratch pool, from the cache if possible,
+ * measured, reported, and then copied out into the caller's pool.
+ */
+static const char *explain_dispatch(pool *p, unsigned int syscall_id,
+    int xerrno, const char *path, struct stat *st,
+    explain_path_explainer_t explainer, const char **args) {
+  const char *explained;
+  pool *tmp_pool;
+  int xerrno2;
+
+  EXPLAIN_USDT2(explainer__dispatch, syscall_id, xerrno);
+  tmp_pool = explain_stats_scratch_pool(p);
+  if (explain_admit(tmp_pool, syscall_id, xerrno, path) == FALSE) {
+    xerrno2 = errno;
+    destroy_pool(tmp_pool);
+    errno = xerrno2;
+    return NULL;
+  }
+
+  EXPLAIN_USDT2(explanation__start, syscall_id, xerrno);
+  explain_stats_begin();
+  explained = explain_cache_get(tmp_pool, syscall_id, xerrno, path, args);
+  if (explained == NULL) {
+    explained = (explainer)(tmp_pool, xerrno, path, st,
+      explain_cur_verbosity, args);
+    xerrno2 = errno;
+    (void) explain_cache_add(tmp_pool, syscall_id, xerrno, path, explained,
+      args);
+
+  } else {
+    xerrno2 = 0;
+  }
+  explain_stats_end(syscall_id, xerrno, explained);
+  explain_adapt_record(explain_stats_get_last_usecs());
+  EXPLAIN_USDT3(explanation__end, syscall_id, xerrno, explained != NULL);
+  explain_report(syscall_id, xerrno, path, explained);
+  explained = explain_copy_out(p, tmp_pool, explained, args);
+
+  errno = xerrno2;
+  return explained;
+}
+
 static const char *explain_chmod(pool *p, int xerrno, const char *path,
     mode_t mode, const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_CHMOD, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_chown(pool *p, int xerrno, const char *path,
     uid_t uid, gid_t gid, const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_CHOWN, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_chroot(pool *p, int xerrno, const char *path,
     const char **args) {
-  return explain_chroot_error(p, xerrno, path, args);
+  return explain_dispatch(p, EXPLAIN_SYSCALL_CHROOT, xerrno, path, NULL,
+    explain_chroot_cb, args);
 }
 
 static const char *explain_close(pool *p, int xerrno, int fd,
     const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_CLOSE, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_fchmod(pool *p, int xerrno, int fd, mode_t mode,
     const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_FCHMOD, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_fchown(pool *p, int xerrno, int fd, uid_t uid,
     gid_t gid, const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_FCHOWN, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_lchown(pool *p, int xerrno, const char *path,
     uid_t uid, gid_t gid, const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_LCHOWN, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_lstat(pool *p, int xerrno, const char *path,
     struct stat *st, const char **args) {
-  return explain_lstat_error(p, xerrno, path, st, args);
+  return explain_dispatch(p, EXPLAIN_SYSCALL_LSTAT, xerrno, path, st,
+    explain_lstat_error, args);
 }
 
 static const char *explain_mkdir(pool *p, int xerrno, const char *path,
     mode_t mode, const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_MKDIR, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_open(pool *p, int xerrno, const char *path,
     int flags, mode_t mode, const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_OPEN, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_read(pool *p, int xerrno, int fd, void *buf,
     size_t sz, const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_READ, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_rename(pool *p, int xerrno, const char *old_path,
     const char *new_path, const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_RENAME, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_rmdir(pool *p, int xerrno, const char *path,
     const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_RMDIR, xerrno);
   errno = ENOSYS;
   return NULL;
 }
 
 static const char *explain_stat(pool *p, int xerrno, const char *path,
     struct stat *st, const char **args) {
-  return explain_stat_error(p, xerrno, path, st, args);
+  return explain_dispatch(p, EXPLAIN_SYSCALL_STAT, xerrno, path, st,
+    explain_stat_error, args);
 }
 
 static const char *explain_unlink(pool *p, int xerrno, const char *path,
     const char **args) {
-  return explain_unlink_error(p, xerrno, path, args);
+  return explain_dispatch(p, EXPLAIN_SYSCALL_UNLINK, xerrno, path, NULL,
+    explain_unlink_cb, args);
 }
 
 static const char *explain_write(pool *p, int xerrno, int fd,
     const void *buf, size_t sz, const char **args) {
+  EXPLAIN_USDT2(explainer__dispatch, EXPLAIN_SYSCALL_WRITE, xerrno);
   errno = ENOSYS;
   return NULL;
 }
@@ -141,11 +334,105 @@ static const char *explain_write(pool *p, int xerrno, int fd,
 /* Configuration directives
  */
 
+/* usage: ExplainAdaptiveVerbosity on|off [latency usecs] [loadavg max]
+ *          [sessions max]
+ */
+MODRET set_explainadaptiveverbosity(cmd_rec *cmd) {
+  register unsigned int i;
+  int adaptive;
+  unsigned long max_usecs = EXPLAIN_ADAPT_DEFAULT_MAX_USECS;
+  double max_loadavg = -1.0;
+  unsigned int max_sessions = 0;
+  config_rec *c;
+
+  if (cmd->argc < 2 ||
+      (cmd->argc % 2) != 0) {
+    CONF_ERROR(cmd, "wrong number of parameters");
+  }
+
+  CHECK_CONF(cmd, CONF_ROOT|CONF_VIRTUAL|CONF_GLOBAL);
+
+  adaptive = get_boolean(cmd, 1);
+  if (adaptive < 0) {
+    CONF_ERROR(cmd, "expected Boolean parameter");
+  }
+
+  for (i = 2; i < cmd->argc; i += 2) {
+    char *ptr = NULL;
+
+    if (strcasecmp(cmd->argv[i], "latency") == 0) {
+      max_usecs = strtoul(cmd->argv[i+1], &ptr, 10);
+
+    } else if (strcasecmp(cmd->argv[i], "loadavg") == 0) {
+      max_loadavg = strtod(cmd->argv[i+1], &ptr);
+
+    } else if (strcasecmp(cmd->argv[i], "sessions") == 0) {
+      max_sessions = strtoul(cmd->argv[i+1], &ptr, 10);
+
+    } else {
+      CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": unknown parameter '",
+        cmd->argv[i], "'", NULL));
+    }
+
+    if (ptr == NULL ||
+        *ptr != '\0') {
+      CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": badly formatted number '",
+        cmd->argv[i+1], "'", NULL));
+    }
+  }
+
+  c = add_config_param(cmd->argv[0], 4, NULL, NULL, NULL, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(int));
+  *((int *) c->argv[0]) = adaptive;
+  c->argv[1] = palloc(c->pool, sizeof(unsigned long));
+  *((unsigned long *) c->argv[1]) = max_usecs;
+  c->argv[2] = palloc(c->pool, sizeof(double));
+  *((double *) c->argv[2]) = max_loadavg;
+  c->argv[3] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[3]) = max_sessions;
+
+  return PR_HANDLED(cmd);
+}
+
+/* usage: ExplainControlsACLs actions|all allow|deny user|group list */
+MODRET set_explainctrlsacls(cmd_rec *cmd) {
+#if defined(PR_USE_CTRLS)
+  char *bad_action = NULL, **actions = NULL;
+
+  CHECK_ARGS(cmd, 4);
+  CHECK_CONF(cmd, CONF_ROOT);
+
+  actions = pr_ctrls_parse_acl(cmd->tmp_pool, cmd->argv[1]);
+
+  if (strcasecmp(cmd->argv[2], "allow") != 0 &&
+      strcasecmp(cmd->argv[2], "deny") != 0) {
+    CONF_ERROR(cmd, "second parameter must be 'allow' or 'deny'");
+  }
+
+  if (strcasecmp(cmd->argv[3], "user") != 0 &&
+      strcasecmp(cmd->argv[3], "group") != 0) {
+    CONF_ERROR(cmd, "third parameter must be 'user' or 'group'");
+  }
+
+  bad_action = pr_ctrls_set_module_acls(explain_acttab, explain_pool, actions,
+    cmd->argv[2], cmd->argv[3], cmd->argv[4]);
+  if (bad_action != NULL) {
+    CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": unknown action: '",
+      bad_action, "'", NULL));
+  }
+
+  return PR_HANDLED(cmd);
+#else
+  CONF_ERROR(cmd, "requires Controls support (--enable-ctrls)");
+#endif /* PR_USE_CTRLS */
+}
+
 /* usage: ExplainEngine on|off */
 MODRET set_explainengine(cmd_rec *cmd) {
   int engine = -1;
+  config_rec *c;
 
-  CHECK_CONF(cmd, CONF_ROOT);
+  CHECK_CONF(cmd, CONF_ROOT|CONF_VIRTUAL|CONF_GLOBAL);
   CHECK_ARGS(cmd, 1);
 
   engine = get_boolean(cmd, 1);
@@ -153,7 +440,10 @@ MODRET set_explainengine(cmd_rec *cmd) {
     CONF_ERROR(cmd, "expected Boolean parameter");
   }
 
-  explain_engine = engine;
+  c = add_config_param(cmd->argv[0], 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(int));
+  *((int *) c->argv[0]) = engine;
+
   return PR_HANDLED(cmd);
 }
 
@@ -172,8 +462,16 @@ MODRET set_explainoptions(cmd_rec *cmd) {
   c = add_config_param(cmd->argv[0], 1, NULL);
 
   for (i = 1; i < cmd->argc; i++) {
-    CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": unknown ExplainOption '",
-      cmd->argv[i], "'", NULL));
+    if (strcasecmp(cmd->argv[i], "NoCache") == 0) {
+      opts |= EXPLAIN_OPT_NO_CACHE;
+
+    } else if (strcasecmp(cmd->argv[i], "PrewarmPaths") == 0) {
+      opts |= EXPLAIN_OPT_PREWARM_PATHS;
+
+    } else {
+      CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": unknown ExplainOption '",
+        cmd->argv[i], "'", NULL));
+    }
   }
 
   c->argv[0] = palloc(c->pool, sizeof(unsigned long));
@@ -182,6 +480,209 @@ MODRET set_explainoptions(cmd_rec *cmd) {
   return PR_HANDLED(cmd);
 }
 
+/* usage: ExplainJournal path [size] */
+MODRET set_explainjournal(cmd_rec *cmd) {
+  size_t size = 0;
+  config_rec *c;
+
+  if (cmd->argc < 2 ||
+      cmd->argc > 3) {
+    CONF_ERROR(cmd, "wrong number of parameters");
+  }
+
+  CHECK_CONF(cmd, CONF_ROOT);
+
+  if (pr_fs_valid_path(cmd->argv[1]) < 0) {
+    CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, "'", cmd->argv[1],
+      "' is not a valid path", NULL));
+  }
+
+  if (cmd->argc == 3) {
+    char *ptr = NULL;
+
+    size = strtoul(cmd->argv[2], &ptr, 10);
+    if (ptr == NULL ||
+        *ptr != '\0' ||
+        size < EXPLAIN_JOURNAL_MIN_SIZE) {
+      CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": badly formatted size '",
+        cmd->argv[2], "'", NULL));
+    }
+  }
+
+  c = add_config_param(cmd->argv[0], 2, NULL, NULL);
+  c->argv[0] = pstrdup(c->pool, cmd->argv[1]);
+  c->argv[1] = palloc(c->pool, sizeof(size_t));
+  *((size_t *) c->argv[1]) = size;
+
+  return PR_HANDLED(cmd);
+}
+
+/* usage: ExplainProbeBudget count|none */
+MODRET set_explainprobebudget(cmd_rec *cmd) {
+  unsigned int budget = 0;
+  config_rec *c;
+
+  CHECK_CONF(cmd, CONF_ROOT|CONF_VIRTUAL|CONF_GLOBAL);
+  CHECK_ARGS(cmd, 1);
+
+  if (strcasecmp(cmd->argv[1], "none") != 0) {
+    char *ptr = NULL;
+
+    budget = strtoul(cmd->argv[1], &ptr, 10);
+    if (ptr == NULL ||
+        *ptr != '\0' ||
+        budget == 0) {
+      CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": badly formatted budget '",
+        cmd->argv[1], "'", NULL));
+    }
+  }
+
+  c = add_config_param(cmd->argv[0], 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[0]) = budget;
+
+  return PR_HANDLED(cmd);
+}
+
+/* usage: ExplainRateLimit off|rate[/secs] [burst count] [sample N]
+ *          [summary secs]
+ */
+MODRET set_explainratelimit(cmd_rec *cmd) {
+  register unsigned int i;
+  unsigned int rate = 0, rate_secs = EXPLAIN_RATELIMIT_DEFAULT_RATE_SECS,
+    burst = EXPLAIN_RATELIMIT_DEFAULT_BURST,
+    sample = EXPLAIN_RATELIMIT_DEFAULT_SAMPLE,
+    summary_secs = EXPLAIN_RATELIMIT_DEFAULT_SUMMARY_SECS;
+  config_rec *c;
+
+  if (cmd->argc < 2 ||
+      (cmd->argc % 2) != 0) {
+    CONF_ERROR(cmd, "wrong number of parameters");
+  }
+
+  CHECK_CONF(cmd, CONF_ROOT|CONF_VIRTUAL|CONF_GLOBAL);
+
+  if (strcasecmp(cmd->argv[1], "off") != 0) {
+    char *ptr = NULL;
+
+    rate = strtoul(cmd->argv[1], &ptr, 10);
+    if (ptr != NULL &&
+        *ptr == '/') {
+      rate_secs = strtoul(ptr + 1, &ptr, 10);
+    }
+
+    if (ptr == NULL ||
+        *ptr != '\0' ||
+        rate == 0 ||
+        rate_secs == 0) {
+      CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": badly formatted rate '",
+        cmd->argv[1], "'", NULL));
+    }
+  }
+
+  for (i = 2; i < cmd->argc; i += 2) {
+    char *ptr = NULL;
+    unsigned int val;
+
+    val = strtoul(cmd->argv[i+1], &ptr, 10);
+    if (ptr == NULL ||
+        *ptr != '\0') {
+      CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": badly formatted number '",
+        cmd->argv[i+1], "'", NULL));
+    }
+
+    if (strcasecmp(cmd->argv[i], "burst") == 0) {
+      burst = val;
+
+    } else if (strcasecmp(cmd->argv[i], "sample") == 0) {
+      sample = val;
+
+    } else if (strcasecmp(cmd->argv[i], "summary") == 0) {
+      summary_secs = val;
+
+    } else {
+      CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": unknown parameter '",
+        cmd->argv[i], "'", NULL));
+    }
+  }
+
+  c = add_config_param(cmd->argv[0], 5, NULL, NULL, NULL, NULL, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[0]) = rate;
+  c->argv[1] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[1]) = rate_secs;
+  c->argv[2] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[2]) = burst;
+  c->argv[3] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[3]) = sample;
+  c->argv[4] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[4]) = summary_secs;
+
+  return PR_HANDLED(cmd);
+}
+
+/* usage: ExplainStatsFile path */
+MODRET set_explainstatsfile(cmd_rec *cmd) {
+  CHECK_ARGS(cmd, 1);
+  CHECK_CONF(cmd, CONF_ROOT);
+
+  if (pr_fs_valid_path(cmd->argv[1]) < 0) {
+    CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, "'", cmd->argv[1],
+      "' is not a valid path", NULL));
+  }
+
+  (void) add_config_param_str(cmd->argv[0], 1, cmd->argv[1]);
+  return PR_HANDLED(cmd);
+}
+
+/* usage: ExplainSyscalls [!]syscall ... */
+MODRET set_explainsyscalls(cmd_rec *cmd) {
+  register unsigned int i;
+  unsigned long syscalls = 0UL;
+  config_rec *c;
+
+  if (cmd->argc < 2) {
+    CONF_ERROR(cmd, "wrong number of parameters");
+  }
+
+  CHECK_CONF(cmd, CONF_ROOT|CONF_VIRTUAL|CONF_GLOBAL);
+
+  /* Starting with an exclusion means "all but these". */
+  if (*((char *) cmd->argv[1]) == '!') {
+    syscalls = EXPLAIN_POLICY_ALL_SYSCALLS;
+  }
+
+  for (i = 1; i < cmd->argc; i++) {
+    const char *name;
+    int negated = FALSE, syscall_id;
+
+    name = cmd->argv[i];
+    if (*name == '!') {
+      negated = TRUE;
+      name++;
+    }
+
+    syscall_id = explain_policy_get_syscall_id(name);
+    if (syscall_id < 0) {
+      CONF_ERROR(cmd, pstrcat(cmd->tmp_pool, ": unknown syscall '", name,
+        "'", NULL));
+    }
+
+    if (negated == TRUE) {
+      syscalls &= ~EXPLAIN_POLICY_SYSCALL(syscall_id);
+
+    } else {
+      syscalls |= EXPLAIN_POLICY_SYSCALL(syscall_id);
+    }
+  }
+
+  c = add_config_param(cmd->argv[0], 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(unsigned long));
+  *((unsigned long *) c->argv[0]) = syscalls;
+
+  return PR_HANDLED(cmd);
+}
+
 /* usage: ExplainVerbosity minimal|terse|detailed */
 MODRET set_explainverbosity(cmd_rec *cmd) {
   unsigned int verbosity = 0;
@@ -211,6 +712,130 @@ MODRET set_explainverbosity(cmd_rec *cmd) {
   return PR_HANDLED(cmd);
 }
 
+/* Command handlers
+ */
+
+MODRET explain_pre_any(cmd_rec *cmd) {
+  if (explain_engine == FALSE) {
+    return PR_DECLINED(cmd);
+  }
+
+  /* The home directory is checked at most once per command; earlier
+   * commands may have replaced it, or the directories leading to it.
+   */
+  explain_platform_uncheck_home();
+  return PR_DECLINED(cmd);
+}
+
+MODRET explain_post_pass(cmd_rec *cmd) {
+  const char *home_path;
+
+  if (explain_engine == FALSE) {
+    return PR_DECLINED(cmd);
+  }
+
+  /* Other modules, e.g. mod_cap, may drop capabilities once the user has
+   * logged in; re-read our snapshot when it is next needed.
+   */
+  explain_caps_expire();
+
+  /* Having logged in, we are now in the user's home directory; keep a handle
+   * on it, as the anchor for explaining paths beneath it.
+   */
+  home_path = pr_fs_getvwd();
+  if (home_path != NULL &&
+      explain_platform_set_home(session.pool, home_path) < 0) {
+    pr_trace_msg(trace_channel, 3,
+      "error capturing home directory '%s': %s", home_path, strerror(errno));
+  }
+
+  /* Probe the directories leading to the home directory (which, once
+   * chrooted, are those of the DefaultRoot), so that the first explanation
+   * in this session is not a cold one.  This is done synchronously, before
+   * the PASS response is sent, and so adds those probes to the login time.
+   */
+  if (home_path != NULL &&
+      (explain_opts & EXPLAIN_OPT_PREWARM_PATHS)) {
+    if (explain_path_prewarm(cmd->tmp_pool, home_path) < 0) {
+      pr_trace_msg(trace_channel, 3, "error prewarming '%s': %s", home_path,
+        strerror(errno));
+    }
+  }
+
+  return PR_DECLINED(cmd);
+}
+
+/* Controls handlers
+ */
+
+#if defined(PR_USE_CTRLS)
+/* usage: explain stats [reset] */
+static int explain_handle_explain(pr_ctrls_t *ctrl, int reqargc,
+    char **reqargv) {
+  register unsigned int i;
+  array_header *lines;
+  pool *tmp_pool;
+
+  if (pr_ctrls_check_acl(ctrl, explain_acttab, "explain") != TRUE) {
+    pr_ctrls_add_response(ctrl, "access denied");
+    return -1;
+  }
+
+  if (reqargc < 1 ||
+      strcasecmp(reqargv[0], "stats") != 0) {
+    pr_ctrls_add_response(ctrl, "explain: missing required parameters");
+    return -1;
+  }
+
+  if (reqargc == 2 &&
+      strcasecmp(reqargv[1], "reset") == 0) {
+    explain_stats_reset();
+    pr_ctrls_add_response(ctrl, "explain: statistics reset");
+    return 0;
+  }
+
+  if (reqargc > 1) {
+    pr_ctrls_add_response(ctrl, "explain: unsupported parameter: '%s'",
+      reqargv[1]);
+    return -1;
+  }
+
+  tmp_pool = make_sub_pool(explain_pool);
+  pr_pool_tag(tmp_pool, "Explain Controls pool");
+
+  lines = explain_stats_text(tmp_pool);
+  for (i = 0; i < lines->nelts; i++) {
+    pr_ctrls_add_response(ctrl, "%s", ((char **) lines->elts)[i]);
+  }
+
+  destroy_pool(tmp_pool);
+  return 0;
+}
+
+static ctrls_acttab_t explain_acttab[] = {
+  { "explain",	"report error explanation statistics", NULL,
+    explain_handle_explain },
+
+  { NULL, NULL, NULL, NULL }
+};
+
+static void explain_ctrls_init(void) {
+  register unsigned int i;
+
+  for (i = 0; explain_acttab[i].act_action; i++) {
+    explain_acttab[i].act_acl = pcalloc(explain_pool, sizeof(ctrls_acl_t));
+    pr_ctrls_init_acl(explain_acttab[i].act_acl);
+
+    if (pr_ctrls_register(&explain_module, explain_acttab[i].act_action,
+        explain_acttab[i].act_desc, explain_acttab[i].act_cb) < 0) {
+      pr_log_pri(PR_LOG_INFO, MOD_EXPLAIN_VERSION
+        ": error registering '%s' control: %s",
+        explain_acttab[i].act_action, strerror(errno));
+    }
+  }
+}
+#endif /* PR_USE_CTRLS */
+
 /* Event listeners
  */
 
@@ -220,6 +845,11 @@ static void explain_mod_unload_ev(const void *event_data, void *user_data) {
     /* Unregister ourselves from all events. */
     pr_event_unregister(&explain_module, NULL, NULL);
 
+#if defined(PR_USE_CTRLS)
+    /* Unregister our Controls actions. */
+    (void) pr_ctrls_unregister(&explain_module, NULL);
+#endif /* PR_USE_CTRLS */
+
     /* Remove our explainer. */
     (void) pr_error_unregister_explainer(explain_pool, &explain_module,
       "explain");
@@ -230,10 +860,142 @@ static void explain_mod_unload_ev(const void *event_data, void *user_data) {
 }
 #endif /* PR_SHARED_MODULE */
 
+static void explain_exit_ev(const void *event_data, void *user_data) {
+  register unsigned int i;
+  array_header *lines;
+  unsigned long nhits = 0, nmisses = 0, nevictions = 0;
+  pool *tmp_pool;
+
+  /* Do not lose count of any suppressed explanations. */
+  tmp_pool = make_sub_pool(session.pool);
+  lines = explain_ratelimit_summarize(tmp_pool, TRUE);
+  for (i = 0; i < lines->nelts; i++) {
+    pr_log_pri(PR_LOG_NOTICE, MOD_EXPLAIN_VERSION ": %s",
+      ((char **) lines->elts)[i]);
+  }
+  destroy_pool(tmp_pool);
+
+  if (pr_trace_get_level(trace_channel) < 8) {
+    return;
+  }
+
+  lines = explain_stats_text(session.pool);
+  for (i = 0; i < lines->nelts; i++) {
+    pr_trace_msg(trace_channel, 8, "%s", ((char **) lines->elts)[i]);
+  }
+
+  explain_cache_get_counts(&nhits, &nmisses, &nevictions);
+  pr_trace_msg(trace_channel, 8,
+    "cache: %lu %s, %lu %s, %lu %s", nhits, nhits != 1 ? "hits" : "hit",
+    nmisses, nmisses != 1 ? "misses" : "miss", nevictions,
+    nevictions != 1 ? "evictions" : "eviction");
+}
+
+/* Returns the DefaultRoot directories of all servers, up to any per-user
+ * parts (e.g. "~" or "%u"), which are only known in the session.
+ */
+static array_header *explain_get_default_roots(pool *p) {
+  server_rec *s;
+  array_header *paths;
+
+  paths = make_array(p, 1, sizeof(char *));
+
+  for (s = (server_rec *) server_list->xas_list; s; s = s->next) {
+    config_rec *c;
+
+    c = find_config(s->conf, CONF_PARAM, "DefaultRoot", FALSE);
+    while (c != NULL) {
+      char *path, *ptr;
+
+      pr_signals_handle();
+
+      path = pstrdup(p, c->argv[0]);
+      ptr = strpbrk(path, "~%");
+      if (ptr != NULL) {
+        *ptr = '\0';
+        ptr = strrchr(path, '/');
+        if (ptr != NULL) {
+          *ptr = '\0';
+        }
+      }
+
+      if (*path == '/') {
+        *((char **) push_array(paths)) = path;
+      }
+
+      c = find_config_next(c, c->next, CONF_PARAM, "DefaultRoot", FALSE);
+    }
+  }
+
+  return paths;
+}
+
 static void explain_postparse_ev(const void *event_data, void *user_data) {
+  server_rec *s;
+
+  /* Compile each server's policy now, once, rather than in every session. */
+  explain_engine = FALSE;
+  explain_policy_init(explain_pool);
+
+  for (s = (server_rec *) server_list->xas_list; s; s = s->next) {
+    const struct explain_policy *policy;
+
+    policy = explain_policy_compile(explain_pool, s);
+    if (policy == NULL) {
+      pr_log_pri(PR_LOG_NOTICE, MOD_EXPLAIN_VERSION
+        ": error compiling policy for server '%s': %s", s->ServerName,
+        strerror(errno));
+      continue;
+    }
+
+    if (policy->engine == TRUE) {
+      explain_engine = TRUE;
+    }
+  }
+
   if (explain_engine == TRUE) {
+    config_rec *c;
+    const char *stats_path = NULL;
     pr_error_explainer_t *explainer;
 
+    /* Map the shared statistics region now, so that every forked session
+     * counts into it.
+     */
+    c = find_config(main_server->conf, CONF_PARAM, "ExplainStatsFile", FALSE);
+    if (c != NULL) {
+      stats_path = c->argv[0];
+    }
+
+    if (explain_stats_open(explain_pool, stats_path) < 0) {
+      pr_log_pri(PR_LOG_NOTICE, MOD_EXPLAIN_VERSION
+        ": error opening shared statistics region: %s", strerror(errno));
+    }
+
+    /* Likewise the journal, to which every session appends. */
+    c = find_config(main_server->conf, CONF_PARAM, "ExplainJournal", FALSE);
+    if (c != NULL) {
+      if (explain_journal_open(explain_pool, c->argv[0],
+          *((size_t *) c->argv[1])) < 0) {
+        pr_log_pri(PR_LOG_NOTICE, MOD_EXPLAIN_VERSION
+          ": error opening ExplainJournal '%s': %s", (char *) c->argv[0],
+          strerror(errno));
+      }
+
+    } else {
+      (void) explain_journal_close();
+    }
+
+    /* Do the setup common to every session now, once, so that the forked
+     * sessions inherit it, rather than each repeating it.
+     */
+    if (explain_platform_warm(explain_pool,
+        explain_get_default_roots(explain_pool)) < 0) {
+      pr_trace_msg(trace_channel, 3, "error looking up platform limits: %s",
+        strerror(errno));
+    }
+
+    (void) explain_probe_detect(explain_pool);
+
     explainer = pr_error_register_explainer(explain_pool, &explain_module,
       "explain");
     if (explainer != NULL) {
@@ -265,23 +1027,35 @@ static void explain_postparse_ev(const void *event_data, void *user_data) {
 static void explain_restart_ev(const void *event_data, void *user_data) {
   (void) pr_error_unregister_explainer(explain_pool, &explain_module,
     "explain");
+  explain_policy_free();
+  explain_platform_warm_free();
   destroy_pool(explain_pool);
   explain_pool = make_sub_pool(permanent_pool);
   pr_pool_tag(explain_pool, MOD_EXPLAIN_VERSION);
 
+#if defined(PR_USE_CTRLS)
+  /* Our ACLs were allocated out of the old pool; start afresh, before the
+   * ExplainControlsACLs directives are parsed again.
+   */
+  (void) pr_ctrls_unregister(&explain_module, NULL);
+  explain_ctrls_init();
+#endif /* PR_USE_CTRLS */
+
   /* Reset default ExplainEngine setting. */
   explain_engine = TRUE;
 }
 
 static void explain_shutdown_ev(const void *event_data, void *user_data) {
+  explain_stats_close();
+  (void) explain_journal_close();
+  explain_policy_free();
+  explain_platform_warm_free();
   (void) pr_error_unregister_explainer(explain_pool, &explain_module,
     "explain");
   destroy_pool(explain_pool);
   explain_pool = NULL;
 }
 
-/* XXX Do we want to support any Controls/ftpctl actions? */
-
 /* Initialization routines
  */
 
@@ -289,6 +1063,12 @@ static int explain_init(void) {
   explain_pool = make_sub_pool(permanent_pool);
   pr_pool_tag(explain_pool, MOD_EXPLAIN_VERSION);
 
+  explain_stats_init(explain_pool);
+
+#if defined(PR_USE_CTRLS)
+  explain_ctrls_init();
+#endif /* PR_USE_CTRLS */
+
 #if defined(PR_SHARED_MODULE)
   pr_event_register(&explain_module, "core.module-unload",
     explain_mod_unload_ev, NULL);
@@ -303,37 +1083,72 @@ static int explain_init(void) {
 }
 
 static int explain_sess_init(void) {
-  config_rec *c;
+  int res;
 
   if (explain_engine == FALSE) {
     return 0;
   }
 
+  explain_policy = explain_policy_get(main_server);
+  if (explain_policy == NULL ||
+      explain_policy->engine == FALSE) {
+    /* Other servers explain errors, but not this one. */
+    explain_engine = FALSE;
+    (void) pr_error_unregister_explainer(explain_pool, &explain_module,
+      "explain");
+    return 0;
+  }
+
   explain_platform_init(session.pool);
+  pr_event_register(&explain_module, "core.exit", explain_exit_ev, NULL);
+  explain_probe_init(session.pool);
+  explain_path_set_budget(explain_policy->probe_budget);
+
+  if (explain_policy->cache_max_entries > 0 &&
+      explain_cache_init(session.pool,
+        explain_policy->cache_max_entries) < 0) {
+    pr_trace_msg(trace_channel, 9, "unable to initialize cache: %s",
+      strerror(errno));
+  }
+
+  /* Failures are only rate limited if so configured. */
+  if (explain_policy->ratelimit == TRUE) {
+    res = explain_ratelimit_init(session.pool, explain_policy->ratelimit_rate,
+      explain_policy->ratelimit_rate_secs, explain_policy->ratelimit_burst,
+      explain_policy->ratelimit_sample,
+      explain_policy->ratelimit_summary_secs);
+    if (res < 0) {
+      pr_trace_msg(trace_channel, 9, "unable to initialize rate limits: %s",
+        strerror(errno));
+    }
+  }
+
+  /* Snapshot our capabilities now, so that capability-related EPERMs can be
+   * explained without probing the filesystem.
+   */
+  if (explain_caps_init(session.pool) < 0) {
+    pr_trace_msg(trace_channel, 9, "unable to snapshot capabilities: %s",
+      strerror(errno));
+  }
 
   /* XXX If/when we have explained responses, they should enabled/disabled
    * on a per-session basis.  Best in a POST_CMD PASS handler, though.
    */
 
-  c = find_config(main_server->conf, CONF_PARAM, "ExplainVerbosity", FALSE);
-  if (c != NULL) {
-    explain_verbosity = *((unsigned int *) c->argv[0]);
-  }
-
+  explain_verbosity = explain_policy->verbosity;
   pr_error_use_formats(explain_verbosity);
-
-  c = find_config(main_server->conf, CONF_PARAM, "ExplainOptions", FALSE);
-  while (c != NULL) {
-    unsigned long opts;
-
-    pr_signals_handle();
-
-    opts = *((unsigned long *) c->argv[0]);
-    explain_opts |= opts;
-
-    c = find_config_next(c, c->next, CONF_PARAM, "ExplainOptions", FALSE);
+  explain_cur_verbosity = explain_verbosity;
+
+  if (explain_policy->adaptive == TRUE) {
+    if (explain_adapt_init(session.pool, explain_policy->adapt_max_usecs,
+        explain_policy->adapt_max_loadavg,
+        explain_policy->adapt_max_sessions) < 0) {
+      pr_trace_msg(trace_channel, 9,
+        "unable to initialize adaptive verbosity: %s", strerror(errno));
+    }
   }
 
+  explain_opts = explain_policy->opts;
   return 0;
 }
 
@@ -341,13 +1156,27 @@ static int explain_sess_init(void) {
  */
 
 static conftable explain_conftab[] = {
+  { "ExplainAdaptiveVerbosity",	set_explainadaptiveverbosity,	NULL },
+  { "ExplainControlsACLs",	set_explainctrlsacls,		NULL },
   { "ExplainEngine",		set_explainengine,		NULL },
+  { "ExplainJournal",		set_explainjournal,		NULL },
   { "ExplainOptions",		set_explainoptions,		NULL },
+  { "ExplainProbeBudget",	set_explainprobebudget,		NULL },
+  { "ExplainRateLimit",		set_explainratelimit,		NULL },
+  { "ExplainStatsFile",		set_explainstatsfile,		NULL },
+  { "ExplainSyscalls",		set_explainsyscalls,		NULL },
   { "ExplainVerbosity",		set_explainverbosity,		NULL },
 
   { NULL }
 };
 
+static cmdtable explain_cmdtab[] = {
+  { PRE_CMD,	C_ANY,	G_NONE,	explain_pre_any,	FALSE,	FALSE },
+  { POST_CMD,	C_PASS,	G_NONE,	explain_post_pass,	FALSE,	FALSE },
+
+  { 0, NULL }
+};
+
 module explain_module = {
   /* Always NULL */
   NULL, NULL,
@@ -362,7 +1191,7 @@ module explain_module = {
   explain_conftab,
 
   /* Module command handler table */
-  NULL,
+  explain_cmdtab,
 
   /* Module authentication handler table */
   NULL,
@@ -23,10 +23,86 @@
  */
 
 #include "path.h"
+#include "generic.h"
 #include "platform.h"
+#include "probe.h"
+#include "token.h"
+#include "usdt.h"
 
 static const char *trace_channel = "explain.path";
 
+/* The prefix, of the most recently explained path, whose attributes that
+ * explanation depends upon; see explain_path_get_prefix().
+ */
+static char path_prefix[PR_TUNABLE_PATH_MAX+1];
+static struct stat path_prefix_st;
+static int path_prefix_have_st = -1;
+
+/* The component at which the most recently explained path failed, and why;
+ * see explain_path_get_failure().
+ */
+static char path_failure[PR_TUNABLE_PATH_MAX+1];
+static int path_failure_idx = -1;
+static unsigned int path_failure_reason = EXPLAIN_REASON_UNKNOWN;
+
+/* The most components to probe for one explanation; zero for no limit. */
+static unsigned int path_budget = 0;
+
+/* Results of earlier probes, to be used instead of probing again. */
+static pr_table_t *path_memo = NULL;
+
+/* The deepest directory validated by the previous walk, and the identities
+ * of the directories validated on the way to it, by component index, for
+ * the effective UID which walked it.  Consecutive failures tend to be in the
+ * same directory; the next walk can start from the deepest prefix it shares
+ * with this one, once a single probe, resolving that prefix in full, confirms
+ * it is still the same directory, and still reachable.
+ */
+#define PATH_RESUME_MAX_DEPTH		64
+
+struct path_resume_id {
+  int valid;
+  dev_t dev;
+  ino_t ino;
+};
+
+static char path_resume_path[PR_TUNABLE_PATH_MAX+1];
+static unsigned int path_resume_depth = 0;
+static int path_resume_chrooted = FALSE;
+static uid_t path_resume_euid = (uid_t) -1;
+static struct path_resume_id path_resume_ids[PATH_RESUME_MAX_DEPTH];
+
+static void path_set_prefix(const char *path, struct stat *st) {
+  sstrncpy(path_prefix, path, sizeof(path_prefix));
+
+  if (st != NULL) {
+    memcpy(&path_prefix_st, st, sizeof(struct stat));
+    path_prefix_have_st = TRUE;
+
+  } else {
+    path_prefix_have_st = FALSE;
+  }
+}
+
+static void path_set_failure(int idx, const char *path, unsigned int reason) {
+  sstrncpy(path_failure, path, sizeof(path_failure));
+  path_failure_idx = idx;
+  path_failure_reason = reason;
+}
+
+/* EACCES on the final component is reported either for the file itself, or
+ * for the directory containing it; see describe_eacces_file().
+ */
+static void path_set_eacces_failure(int idx, const char *path,
+    const char *parent_path, int flags) {
+  if (flags & EXPLAIN_PATH_FL_WANT_SEARCH) {
+    path_set_failure(idx, path, EXPLAIN_REASON_FILE_NOT_SEARCHABLE);
+
+  } else if (parent_path != NULL) {
+    path_set_failure(idx - 1, parent_path, EXPLAIN_REASON_DIR_NOT_WRITABLE);
+  }
+}
+
 static const char *mode2s(pool *p, mode_t o) {
   char buf[1024];
   memset(buf, '\0', sizeof(buf));
@@ -41,33 +117,54 @@ static const char *ul2s(pool *p, unsigned long l) {
   return pstrdup(p, buf);
 }
 
-static array_header *path_split(pool *p, const char *path) {
+/* Splits the path into its components, the first of which is always '/'.
+ * The tokens, if requested, describe the components after the first, i.e.
+ * token i describes component i+1.
+ */
+static array_header *path_split(pool *p, const char *path,
+    unsigned long name_max, struct explain_token **tokens,
+    unsigned int *token_flags) {
+  register int i;
   char buf[PR_TUNABLE_PATH_MAX+1], *full_path;
   size_t full_pathlen;
-  array_header *first, *components;
+  array_header *components;
+  struct explain_token *toks;
+  unsigned int max_tokens;
+  int ntokens;
 
+  memset(buf, '\0', sizeof(buf));
   pr_fs_virtual_path(path, buf, sizeof(buf)-1);
   full_path = buf;
   full_pathlen = strlen(full_path);
 
   /* If the path ENDS in '/', append '.' to it. */
-  if (full_path[full_pathlen-1] == '/' &&
+  if (full_pathlen > 1 &&
+      full_path[full_pathlen-1] == '/' &&
       full_pathlen < (sizeof(buf)-1)) {
-    full_path[full_pathlen] = '.';
+    full_path[full_pathlen++] = '.';
+  }
+
+  max_tokens = (full_pathlen + 1) / 2;
+  toks = palloc(p, sizeof(struct explain_token) * (max_tokens + 1));
+
+  ntokens = explain_token_scan(full_path, full_pathlen, name_max, toks,
+    max_tokens, token_flags);
+  if (ntokens < 0) {
+    ntokens = 0;
   }
 
-  first = make_array(p, 1, sizeof(char *));
+  components = make_array(p, ntokens + 1, sizeof(char *));
 
   /* The first component is ALWAYS '/'. */
-  *((char **) push_array(first)) = pstrdup(p, "/");
+  *((char **) push_array(components)) = pstrdup(p, "/");
 
-  if (full_pathlen == 1) {
-    return first;
+  for (i = 0; i < ntokens; i++) {
+    *((char **) push_array(components)) = pstrndup(p,
+      full_path + toks[i].offset, toks[i].len);
   }
 
-  components = pr_str_text_to_array(p, full_path, '/');
-  if (components != NULL) {
-    components = append_arrays(p, first, components);
+  if (tokens != NULL) {
+    *tokens = toks;
   }
 
   pr_trace_msg(trace_channel, 19, "split path '%s' into %u components", path,
@@ -110,12 +207,256 @@ static const char *describe_enoent_file(pool *p, const char *path, int flags) {
   return pstrcat(p, "file '", path, "' does not exist", NULL);
 }
 
-const char *explain_path_error(pool *p, int err_errno, const char *full_path,
+static const char *describe_enotdir(pool *p, const char *path, int flags) {
+  return pstrcat(p, "path '", path, "' does not refer to a directory", NULL);
+}
+
+/* Returns the progressively longer paths leading up to, and including, the
+ * full path, one per component.
+ */
+static const char **path_prefixes(pool *p, array_header *components) {
+  register unsigned int i;
+  const char **paths;
+
+  paths = pcalloc(p, sizeof(char *) * components->nelts);
+  for (i = 0; i < components->nelts; i++) {
+    const char **elts;
+
+    elts = components->elts;
+    if (i == 0) {
+      paths[i] = elts[i];
+
+    } else {
+      paths[i] = pdircat(p, paths[i-1], elts[i], NULL);
+    }
+  }
+
+  return paths;
+}
+
+/* Probes the given path, unless its result is already recorded in the memo
+ * table.
+ */
+static int path_lstat(pool *p, const char *path, struct stat *st) {
+  if (path_memo != NULL) {
+    const struct explain_path_probe *probe;
+
+    probe = pr_table_get(path_memo, path, NULL);
+    if (probe != NULL) {
+      if (probe->xerrno != 0) {
+        errno = probe->xerrno;
+        return -1;
+      }
+
+      memcpy(st, &(probe->st), sizeof(struct stat));
+      return 0;
+    }
+  }
+
+  return explain_probe_lstat(p, path, st);
+}
+
+/* Most ENOENT/ENOTDIR errors only need to know where resolution stops, and
+ * why.  Rather than probing every component, first see whether the parent of
+ * the final component resolves as a directory; if not, binary search for the
+ * deepest prefix which does.  Returns NULL if the answer is ambiguous (e.g.
+ * symlinks are involved), in which case the caller needs to walk the path.
+ */
+static const char *classify_path_error(pool *p, int err_errno,
+    const char **paths, unsigned int npaths, int flags) {
+  int res, xerrno;
+  unsigned int lo, hi;
+
+  if (npaths < 2) {
+    return NULL;
+  }
+
+  res = explain_probe_resolve(p, paths[npaths-2],
+    EXPLAIN_PROBE_RESOLVE_FL_DIRECTORY);
+  if (res == 0) {
+    res = explain_probe_resolve(p, paths[npaths-1], 0);
+    if (res < 0 &&
+        errno == ENOENT) {
+      pr_trace_msg(trace_channel, 17,
+        "classified %s for '%s' as missing final component",
+        strerror(err_errno), paths[npaths-1]);
+      path_set_prefix(paths[npaths-2], NULL);
+      path_set_failure(npaths-1, paths[npaths-1],
+        EXPLAIN_REASON_NO_SUCH_FILE);
+      return describe_enoent_file(p, paths[npaths-1], flags);
+    }
+
+    return NULL;
+  }
+
+  xerrno = errno;
+  if (xerrno != ENOENT &&
+      xerrno != ENOTDIR) {
+    return NULL;
+  }
+
+  /* The root always resolves, thus paths[lo] resolves as a directory, and
+   * paths[hi] does not.
+   */
+  lo = 0;
+  hi = npaths - 2;
+
+  while (hi - lo > 1) {
+    unsigned int mid;
+
+    pr_signals_handle();
+
+    mid = lo + ((hi - lo) / 2);
+    res = explain_probe_resolve(p, paths[mid],
+      EXPLAIN_PROBE_RESOLVE_FL_DIRECTORY);
+    if (res == 0) {
+      lo = mid;
+      continue;
+    }
+
+    if (errno != ENOENT &&
+        errno != ENOTDIR) {
+      return NULL;
+    }
+
+    hi = mid;
+    xerrno = errno;
+  }
+
+  pr_trace_msg(trace_channel, 17,
+    "classified %s for '%s' as failing at component #%u: %s",
+    strerror(err_errno), paths[npaths-1], hi+1, strerror(xerrno));
+
+  path_set_prefix(paths[lo], NULL);
+
+  if (xerrno == ENOENT) {
+    path_set_failure(hi, paths[hi], EXPLAIN_REASON_NO_SUCH_DIR);
+    return describe_enoent_dir(p, paths[hi], flags);
+  }
+
+  path_set_failure(hi, paths[hi], EXPLAIN_REASON_NOT_DIR);
+  return describe_enotdir(p, paths[hi], flags);
+}
+
+/* Returns the index of the component which is the user's home directory, or
+ * zero if the path is not beneath the home directory.
+ */
+static unsigned int get_home_index(pool *p, const char **paths,
+    unsigned int npaths) {
+  register unsigned int i;
+  const char *home_path = NULL;
+
+  (void) p;
+
+  if (explain_platform_home_fd(&home_path) < 0 ||
+      home_path == NULL) {
+    return 0;
+  }
+
+  /* The final component always needs probing. */
+  for (i = 1; i + 1 < npaths; i++) {
+    if (strcmp(paths[i], home_path) == 0) {
+      return i;
+    }
+  }
+
+  return 0;
+}
+
+/* Returns the index of the deepest (non-final) component shared with the
+ * directory validated by the previous walk, if it is at least min_idx, and
+ * still the same directory; otherwise, returns zero.
+ */
+static unsigned int path_resume_index(pool *p, const char **paths,
+    unsigned int npaths, unsigned int min_idx, struct stat *st) {
+  register unsigned int i;
+  unsigned int max_idx;
+
+  /* Search permission on the validated directories depends on who is
+   * asking.
+   */
+  if (path_resume_depth == 0 ||
+      path_resume_chrooted != (session.chroot_path != NULL) ||
+      path_resume_euid != geteuid() ||
+      npaths < 2) {
+    return 0;
+  }
+
+  if (min_idx < 1) {
+    min_idx = 1;
+  }
+
+  max_idx = path_resume_depth;
+  if (max_idx > npaths - 2) {
+    max_idx = npaths - 2;
+  }
+
+  for (i = max_idx; i >= min_idx; i--) {
+    size_t len;
+
+    len = strlen(paths[i]);
+    if (strncmp(path_resume_path, paths[i], len) != 0 ||
+        (path_resume_path[len] != '/' && path_resume_path[len] != '\0')) {
+      continue;
+    }
+
+    if (path_resume_ids[i].valid == FALSE) {
+      return 0;
+    }
+
+    /* One probe confirms both that the directory is the same one, and that
+     * every directory leading to it can still be searched.  The probe is not
+     * anchored at a directory handle, as that would skip the directories
+     * above the handle.
+     */
+    if (explain_probe_lstat_full(p, paths[i], st) < 0 ||
+        !S_ISDIR(st->st_mode) ||
+        st->st_dev != path_resume_ids[i].dev ||
+        st->st_ino != path_resume_ids[i].ino) {
+      pr_trace_msg(trace_channel, 17,
+        "previously validated directory '%s' has changed", paths[i]);
+      path_resume_depth = 0;
+      return 0;
+    }
+
+    pr_trace_msg(trace_channel, 17,
+      "resuming walk of '%s' after component #%u ('%s')", paths[npaths-1],
+      i+1, paths[i]);
+    return i;
+  }
+
+  return 0;
+}
+
+static void path_resume_record(unsigned int idx, const char *path,
+    struct stat *st) {
+  if (idx >= PATH_RESUME_MAX_DEPTH) {
+    return;
+  }
+
+  path_resume_ids[idx].valid = TRUE;
+  path_resume_ids[idx].dev = st->st_dev;
+  path_resume_ids[idx].ino = st->st_ino;
+
+  sstrncpy(path_resume_path, path, sizeof(path_resume_path));
+  path_resume_depth = idx;
+  path_resume_chrooted = (session.chroot_path != NULL);
+  path_resume_euid = geteuid();
+}
+
+static const char *path_error(pool *p, int err_errno, const char *full_path,
     int flags, mode_t mode) {
   register unsigned int i;
   array_header *components = NULL;
-  const char *explained = NULL, *path = NULL, *prev_path = NULL;
+  const char *explained = NULL, *path = NULL, *prev_path = NULL, **paths;
   unsigned long name_max, no_trunc;
+  struct stat *sts = NULL;
+  int *errnos = NULL, batched = FALSE, have_parent_st = FALSE;
+  struct explain_token *tokens = NULL;
+  unsigned int token_flags = 0;
+  unsigned int home_idx = 0, start_idx = 0, resume_idx = 0;
+  const char *valid_path = NULL;
+  struct stat valid_st, parent_st;
 
   if (p == NULL ||
       full_path == NULL) {
@@ -123,6 +464,9 @@ const char *explain_path_error(pool *p, int err_errno, const char *full_path,
     return NULL;
   }
 
+  explain_path_clear_prefix();
+  explain_path_clear_failure();
+
   /* Try to get some of the easy cases out of the way first. */
 
   if (err_errno == ENAMETOOLONG) {
@@ -134,6 +478,7 @@ const char *explain_path_error(pool *p, int err_errno, const char *full_path,
 
       path_len = strlen(full_path);
       if (path_len > path_max) {
+        path_set_failure(-1, full_path, EXPLAIN_REASON_PATH_TOO_LONG);
         explained = describe_enametoolong_path(p, full_path, path_len,
           path_max, flags);
         return explained;
@@ -149,42 +494,113 @@ const char *explain_path_error(pool *p, int err_errno, const char *full_path,
    * each fully qualified component along the way.
    */
 
-  components = path_split(p, full_path);
-
   name_max = explain_platform_name_max(p, full_path);
   no_trunc = explain_platform_no_trunc(p, full_path);
 
-  for (i = 0; i < components->nelts; i++) {
-    const char **elts, *component;
-    int final_component = FALSE, res, xerrno = 0;
-    struct stat st;
+  components = path_split(p, full_path, name_max, &tokens, &token_flags);
 
-    pr_signals_handle();
+  /* Component names can be too long only if the filesystem on which the
+   * path resides does not silently truncate long names.  The tokenizer has
+   * already found any such names, without our having to walk the path.
+   */
+  if (err_errno == ENAMETOOLONG &&
+      no_trunc == 1 &&
+      (token_flags & EXPLAIN_TOKEN_FL_TOO_LONG)) {
+    const char **elts;
 
     elts = components->elts;
-    component = elts[i];
-
-    if (err_errno == ENAMETOOLONG) {
-      size_t component_len;
-
-      component_len = strlen(component);
-
-      /* Component names can be too long only if the filesystem on which
-       * the path resides does not silently truncate long names.
-       */
-      if (component_len > name_max &&
-          no_trunc == 1) {
-        explained = describe_enametoolong_name(p, component, component_len,
+    for (i = 1; i < components->nelts; i++) {
+      if (tokens[i-1].flags & EXPLAIN_TOKEN_FL_TOO_LONG) {
+        path_set_failure(i, path_prefixes(p, components)[i],
+          EXPLAIN_REASON_NAME_TOO_LONG);
+        explained = describe_enametoolong_name(p, elts[i], tokens[i-1].len,
           name_max, flags);
         return explained;
       }
     }
+  }
 
-    if (path == NULL) {
-      path = component;
+  /* Construct each of the progressively longer paths up front, so that they
+   * can all be probed in a single batch, where supported.  Otherwise, we
+   * probe them one at a time, as we walk.
+   */
+  paths = path_prefixes(p, components);
 
-    } else {
-      path = pdircat(p, path, component, NULL);
+  /* Classifying resolves paths directly; with recorded probes at hand, we
+   * walk the path instead.
+   */
+  if (path_memo == NULL &&
+      (err_errno == ENOENT ||
+       err_errno == ENOTDIR)) {
+    explained = classify_path_error(p, err_errno, paths, components->nelts,
+      flags);
+    if (explained != NULL) {
+      return explained;
+    }
+  }
+
+  /* If the path lies beneath the user's home directory, then the components
+   * leading up to the home directory are known to be searchable directories;
+   * we only need to probe the components after it.
+   */
+  home_idx = get_home_index(p, paths, components->nelts);
+  start_idx = home_idx;
+
+  /* Similarly, the components leading up to the directory validated by the
+   * previous walk need not be probed again, if that directory is unchanged.
+   */
+  if (path_memo == NULL) {
+    struct stat st;
+
+    resume_idx = path_resume_index(p, paths, components->nelts, home_idx,
+      &st);
+    if (resume_idx > 0) {
+      start_idx = resume_idx + 1;
+      valid_path = paths[resume_idx];
+      memcpy(&valid_st, &st, sizeof(struct stat));
+      memcpy(&parent_st, &st, sizeof(struct stat));
+      have_parent_st = TRUE;
+    }
+  }
+
+  /* Otherwise, this walk validates a new chain of directories. */
+  if (resume_idx == 0) {
+    memset(path_resume_ids, 0, sizeof(path_resume_ids));
+    path_resume_depth = 0;
+  }
+
+  if (path_budget > 0 &&
+      components->nelts - start_idx > path_budget) {
+    pr_trace_msg(trace_channel, 9,
+      "walking '%s' would probe %u components, exceeding budget of %u",
+      full_path, components->nelts - start_idx, path_budget);
+    errno = EAGAIN;
+    return NULL;
+  }
+
+  if (path_memo == NULL &&
+      components->nelts - start_idx > 1) {
+    sts = pcalloc(p, sizeof(struct stat) * components->nelts);
+    errnos = pcalloc(p, sizeof(int) * components->nelts);
+
+    if (explain_probe_lstat_batch(p, paths + start_idx,
+        components->nelts - start_idx, sts + start_idx,
+        errnos + start_idx) == 0) {
+      batched = TRUE;
+    }
+  }
+
+  for (i = 0; i < components->nelts; i++) {
+    int final_component = FALSE, res, xerrno = 0;
+    struct stat st;
+
+    pr_signals_handle();
+
+    path = paths[i];
+
+    if (i < start_idx) {
+      prev_path = path;
+      continue;
     }
 
     /* The following are the checks on the non-final components.  The final
@@ -193,23 +609,41 @@ const char *explain_path_error(pool *p, int err_errno, const char *full_path,
 
     final_component = (i == (components->nelts-1));
 
-    res = pr_fsio_lstat(path, &st);
-    xerrno = errno;
+    if (batched == TRUE) {
+      xerrno = errnos[i];
+      res = (xerrno == 0 ? 0 : -1);
+      if (res == 0) {
+        memcpy(&st, &(sts[i]), sizeof(struct stat));
+      }
+
+    } else {
+      res = path_lstat(p, path, &st);
+      xerrno = errno;
+    }
+
+    EXPLAIN_USDT4(path__component, i, components->nelts, path,
+      res < 0 ? xerrno : 0);
 
     if (res < 0) {
       pr_trace_msg(trace_channel, 3,
         "error checking component #%u (of %u), path '%s': %s", i+1,
         components->nelts, path, strerror(xerrno));
+
+    } else {
+      valid_path = path;
+      memcpy(&valid_st, &st, sizeof(struct stat));
     }
 
     if (final_component == FALSE) {
       if (res < 0) {
         switch (xerrno) {
           case ENOENT:
+            path_set_failure(i, path, EXPLAIN_REASON_NO_SUCH_DIR);
             explained = describe_enoent_dir(p, path, flags);
             break;
 
           case EACCES:
+            path_set_failure(i, path, EXPLAIN_REASON_DIR_NOT_SEARCHABLE);
             explained = describe_eacces_dir(p, path, flags);
             break;
 
@@ -227,11 +661,18 @@ const char *explain_path_error(pool *p, int err_errno, const char *full_path,
       if (!S_ISLNK(st.st_mode) &&
           !S_ISDIR(st.st_mode)) {
         /* Explains ENOTDIR */
-        explained = pstrcat(p, "path '", path,
-          "' does not refer to a directory", NULL);
+        path_set_failure(i, path, EXPLAIN_REASON_NOT_DIR);
+        explained = describe_enotdir(p, path, flags);
         break;
       }
 
+      if (S_ISDIR(st.st_mode)) {
+        path_resume_record(i, path, &st);
+      }
+
+      memcpy(&parent_st, &st, sizeof(struct stat));
+      have_parent_st = TRUE;
+
       /* if WANT_SEARCH and no search, EACCES */
 
       /* if found, and a directory, set current lookup directory, and go to
@@ -243,10 +684,12 @@ const char *explain_path_error(pool *p, int err_errno, const char *full_path,
       if (res < 0) {
         switch (xerrno) {
           case ENOENT:
+            path_set_failure(i, path, EXPLAIN_REASON_NO_SUCH_FILE);
             explained = describe_enoent_file(p, path, flags);
             break;
 
           case EACCES:
+            path_set_eacces_failure(i, path, prev_path, flags);
             explained = describe_eacces_file(p, path, flags);
             break;
 
@@ -260,13 +703,28 @@ const char *explain_path_error(pool *p, int err_errno, const char *full_path,
       }
 
       if (err_errno == EACCES) {
+        path_set_eacces_failure(i, path, prev_path, flags);
         explained = describe_eacces_file(p, path, flags);
-        if (explained != NULL) {
-          if (pr_fsio_lstat(prev_path, &st) == 0) {
+        if (explained != NULL &&
+            !(flags & EXPLAIN_PATH_FL_TERSE)) {
+          int parent_res = 0;
+
+          if (have_parent_st == TRUE) {
+            memcpy(&st, &parent_st, sizeof(struct stat));
+
+          } else {
+            parent_res = path_lstat(p, prev_path, &st);
+          }
+
+          if (parent_res == 0) {
             explained = pstrcat(p, explained, "; parent directory '",
               prev_path, "' has perms ", mode2s(p, st.st_mode),
               ", and is owned by UID ", pr_uid2str(p, st.st_uid),
               ", GID ", pr_gid2str(p, st.st_gid), NULL);
+
+            /* This explanation reports the parent's attributes. */
+            valid_path = prev_path;
+            memcpy(&valid_st, &st, sizeof(struct stat));
           }
         }
 
@@ -280,5 +738,203 @@ const char *explain_path_error(pool *p, int err_errno, const char *full_path,
     prev_path = path;
   }
 
+  if (valid_path != NULL) {
+    path_set_prefix(valid_path, &valid_st);
+  }
+
   return explained;
 }
+
+const char *explain_path_error(pool *p, int err_errno, const char *full_path,
+    int flags, mode_t mode) {
+  const char *explained;
+
+  /* Probes may only be anchored at the home directory handle while the
+   * home directory path still leads to it.
+   */
+  (void) explain_probe_check_home(p);
+  explained = path_error(p, err_errno, full_path, flags, mode);
+
+  return explained;
+}
+
+const char *explain_path_describe(pool *p, int xerrno, const char *syscall,
+    const char *path, int flags, mode_t mode, unsigned int verbosity) {
+  const char *explained;
+
+  if (verbosity == PR_ERROR_FORMAT_USE_MINIMAL) {
+    return explain_describe_generic(p, xerrno, syscall);
+  }
+
+  if (verbosity == PR_ERROR_FORMAT_USE_TERSE) {
+    flags |= EXPLAIN_PATH_FL_TERSE;
+  }
+
+  explained = explain_path_error(p, xerrno, path, flags, mode);
+  if (explained == NULL &&
+      errno == EAGAIN) {
+    /* Walking this path would exceed our probe budget. */
+    explained = explain_describe_generic(p, xerrno, syscall);
+  }
+
+  return explained;
+}
+
+int explain_path_prewarm(pool *p, const char *full_path) {
+  register unsigned int i;
+  array_header *components;
+  const char **paths;
+  struct stat *sts;
+  int *errnos, nprobed = 0;
+
+  if (p == NULL ||
+      full_path == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  components = path_split(p, full_path, 0, NULL, NULL);
+
+  paths = path_prefixes(p, components);
+  sts = pcalloc(p, sizeof(struct stat) * components->nelts);
+  errnos = pcalloc(p, sizeof(int) * components->nelts);
+
+  if (explain_probe_lstat_batch(p, paths, components->nelts, sts,
+      errnos) < 0) {
+    for (i = 0; i < components->nelts; i++) {
+      pr_signals_handle();
+
+      errnos[i] = 0;
+      if (explain_probe_lstat(p, paths[i], &(sts[i])) < 0) {
+        errnos[i] = errno;
+      }
+    }
+  }
+
+  /* The directories probed become the chain from which the next walk
+   * resumes, as if a walk had validated them.
+   */
+  memset(path_resume_ids, 0, sizeof(path_resume_ids));
+  path_resume_depth = 0;
+
+  for (i = 0; i < components->nelts; i++) {
+    if (errnos[i] != 0) {
+      pr_trace_msg(trace_channel, 9, "error prewarming '%s': %s", paths[i],
+        strerror(errnos[i]));
+      break;
+    }
+
+    if (!S_ISDIR(sts[i].st_mode)) {
+      break;
+    }
+
+    path_resume_record(i, paths[i], &(sts[i]));
+    nprobed++;
+  }
+
+  /* The owners of these directories are not resolved here: explanations
+   * report them via pr_uid2str()/pr_gid2str(), which only format the numeric
+   * IDs, so there are no user/group name lookups to warm.
+   */
+
+  /* This also opens any handle used for resolving paths. */
+  (void) explain_probe_resolve(p, full_path,
+    EXPLAIN_PROBE_RESOLVE_FL_DIRECTORY);
+
+  pr_trace_msg(trace_channel, 15, "prewarmed %d of %u directories for '%s'",
+    nprobed, components->nelts, full_path);
+  return nprobed;
+}
+
+int explain_path_get_prefix(const char **prefix, struct stat *st,
+    int *have_st) {
+  if (prefix == NULL ||
+      st == NULL ||
+      have_st == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (path_prefix_have_st < 0) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  *prefix = path_prefix;
+  *have_st = path_prefix_have_st;
+  if (path_prefix_have_st == TRUE) {
+    memcpy(st, &path_prefix_st, sizeof(struct stat));
+  }
+
+  return 0;
+}
+
+const char **explain_path_get_prefixes(pool *p, const char *path,
+    unsigned int *nprefixes) {
+  array_header *components;
+
+  if (p == NULL ||
+      path == NULL ||
+      nprefixes == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  components = path_split(p, path, 0, NULL, NULL);
+  *nprefixes = components->nelts;
+  return path_prefixes(p, components);
+}
+
+void explain_path_set_memo(pr_table_t *memo) {
+  path_memo = memo;
+}
+
+void explain_path_reset_resume(void) {
+  memset(path_resume_ids, 0, sizeof(path_resume_ids));
+  path_resume_depth = 0;
+}
+
+void explain_path_set_budget(unsigned int budget) {
+  path_budget = budget;
+}
+
+int explain_path_get_failure(int *idx, const char **path,
+    unsigned int *reason) {
+  if (idx == NULL ||
+      path == NULL ||
+      reason == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (path_failure_reason == EXPLAIN_REASON_UNKNOWN) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  *idx = path_failure_idx;
+  *path = path_failure;
+  *reason = path_failure_reason;
+  return 0;
+}
+
+int explain_path_set_failure(int idx, const char *path, unsigned int reason) {
+  if (path == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  path_set_failure(idx, path, reason);
+  return 0;
+}
+
+void explain_path_clear_failure(void) {
+  path_failure[0] = '\0';
+  path_failure_idx = -1;
+  path_failure_reason = EXPLAIN_REASON_UNKNOWN;
+}
+
+void explain_path_clear_prefix(void) {
+  path_prefix[0] = '\0';
+  path_prefix_have_st = -1;
+}
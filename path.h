@@ -30,6 +30,74 @@
 const char *explain_path_error(pool *p, int xerrno, const char *path,
   int flags, mode_t mode);
 
+/* Explains the given syscall's failure on a path, at the given verbosity.
+ * Minimal formats only report the errno, without walking the path; so do
+ * paths whose walk would exceed the probe budget.  Otherwise, as for
+ * explain_path_error().
+ */
+const char *explain_path_describe(pool *p, int xerrno, const char *syscall,
+  const char *path, int flags, mode_t mode, unsigned int verbosity);
+
+/* Probes each of the directories leading up to, and including, the given
+ * path, and records them as validated, so that the first explanation of a
+ * failure beneath it resumes its walk from there, as later ones do.
+ * Returns the number of directories probed.
+ */
+int explain_path_prewarm(pool *p, const char *path);
+
+/* Returns the deepest existing prefix of the most recently explained path
+ * whose attributes that explanation depends upon: the deepest component
+ * found to exist, or the parent directory whose permissions were reported.
+ * If the prefix was found without being probed, have_st is set to FALSE,
+ * and st is not filled in.  Returns -1, with errno set to ENOENT, if that
+ * explanation did not depend on any prefix.
+ */
+int explain_path_get_prefix(const char **prefix, struct stat *st,
+  int *have_st);
+void explain_path_clear_prefix(void);
+
+/* Returns the failing component of the most recently explained path: its
+ * index (zero being the root), its full path, and an EXPLAIN_REASON code.
+ * The index is -1 if the path as a whole failed, e.g. for being too long.
+ * Returns -1, with errno set to ENOENT, if that explanation did not find
+ * any failing component.  Cached explanations restore the failure recorded
+ * with them, via explain_path_set_failure().
+ */
+int explain_path_get_failure(int *idx, const char **path,
+  unsigned int *reason);
+int explain_path_set_failure(int idx, const char *path, unsigned int reason);
+void explain_path_clear_failure(void);
+
+/* Returns the progressively longer paths leading up to, and including, the
+ * given path, one per component, as explain_path_error() would probe them.
+ */
+const char **explain_path_get_prefixes(pool *p, const char *path,
+  unsigned int *nprefixes);
+
+/* The result of probing a path, in the manner of explain_probe_lstat(). */
+struct explain_path_probe {
+  int xerrno;
+  struct stat st;
+};
+
+/* Sets a table of paths to struct explain_path_probe results, which
+ * explain_path_error() then uses instead of probing those paths itself;
+ * NULL clears it.  While set, paths are always walked, one component at a
+ * time, rather than classified via path resolution.
+ */
+void explain_path_set_memo(pr_table_t *memo);
+
+/* Forgets the directories validated by the previous walk, from which the
+ * next walk would otherwise resume.
+ */
+void explain_path_reset_resume(void);
+
+/* Sets the most path components to be probed for one explanation; paths
+ * needing more are not walked, and explain_path_error() returns NULL, with
+ * errno set to EAGAIN.  Zero, the default, removes the limit.
+ */
+void explain_path_set_budget(unsigned int budget);
+
 /* Provide reasons why we want to use this path. */
 #define EXPLAIN_PATH_FL_WANT_READ		0x0001
 #define EXPLAIN_PATH_FL_WANT_WRITE		0x0002
@@ -41,4 +109,9 @@ const char *explain_path_error(pool *p, int xerrno, const char *path,
 #define EXPLAIN_PATH_FL_MUST_NOT_EXIST		0x0080
 #define EXPLAIN_PATH_FL_MUST_HAVE_MODE		0x0100
 
+/* Report only the failing component, for terse formats; skip describing the
+ * ownership and permissions of its directory.
+ */
+#define EXPLAIN_PATH_FL_TERSE			0x1000
+
 #endif /* MOD_EXPLAIN_PATH_H */
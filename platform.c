@@ -24,31 +24,150 @@
 
 #include "platform.h"
 
+#include <sys/mman.h>
+
 static long platform_sess_name_max = -1;
 static long platform_sess_no_trunc = -1;
 static long platform_sess_path_max = -1;
 
+/* Handles on the root directory (opened lazily, or captured as we chroot),
+ * and on the user's home directory (captured after login).  Path probes are
+ * anchored at these handles, rather than re-resolving the DefaultRoot
+ * prefix.
+ *
+ * The home handle is only used while checked: a probe relative to it skips
+ * the home directory's ancestors, and so would contradict the path-based
+ * syscall being explained, should the home directory since have been
+ * replaced, or an ancestor have lost its search permission.  The check is
+ * made at most once per command.
+ *
+ * Only a home directory on the system filesystem gets a handle; a module
+ * such as mod_vroot may map it elsewhere.
+ */
+static int platform_sess_root_fd = -1;
+static int platform_sess_root_pending = FALSE;
+static int platform_sess_home_fd = -1;
+static const char *platform_sess_home_path = NULL;
+static dev_t platform_sess_home_dev = 0;
+static ino_t platform_sess_home_ino = 0;
+static int platform_sess_home_checked = EXPLAIN_PLATFORM_HOME_UNCHECKED;
+
+/* Filesystem limits, which are the same for every session: looked up once,
+ * by the daemon, and inherited by each forked session.  They are kept in
+ * pages of their own, made read-only once filled in, so that every session
+ * shares the daemon's copy.  System limits such as CHILD_MAX and OPEN_MAX
+ * follow the session's resource limits, and so are not cached.
+ */
+#define PLATFORM_WARM_MAX_FS		16
+
+struct platform_fs_limits {
+  dev_t dev;
+  long name_max;
+  long no_trunc;
+  long path_max;
+};
+
+struct platform_warm {
+  unsigned int nfs;
+  struct platform_fs_limits fs[PLATFORM_WARM_MAX_FS];
+};
+
+static struct platform_warm *platform_warm = NULL;
+
+static const char *trace_channel = "explain.platform";
+
+#if defined(O_PATH)
+# define EXPLAIN_PLATFORM_DIR_FLAGS	(O_PATH|O_DIRECTORY)
+#else
+# define EXPLAIN_PLATFORM_DIR_FLAGS	(O_RDONLY|O_DIRECTORY)
+#endif /* O_PATH */
+
+static int platform_open_dir(const char *path) {
+  int fd;
+
+  fd = open(path, EXPLAIN_PLATFORM_DIR_FLAGS);
+  if (fd >= 0) {
+    (void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+
+  return fd;
+}
+
+static void platform_close_fds(void) {
+  if (platform_sess_root_fd >= 0) {
+    (void) close(platform_sess_root_fd);
+    platform_sess_root_fd = -1;
+  }
+  platform_sess_root_pending = FALSE;
+
+  if (platform_sess_home_fd >= 0) {
+    (void) close(platform_sess_home_fd);
+    platform_sess_home_fd = -1;
+  }
+
+  platform_sess_home_path = NULL;
+  platform_sess_home_checked = EXPLAIN_PLATFORM_HOME_UNCHECKED;
+}
+
+static const struct platform_fs_limits *platform_get_fs_limits(
+    const char *path) {
+  register unsigned int i;
+  struct stat st;
+
+  if (platform_warm == NULL ||
+      stat(path, &st) < 0) {
+    return NULL;
+  }
+
+  for (i = 0; i < platform_warm->nfs; i++) {
+    if (platform_warm->fs[i].dev == st.st_dev) {
+      return &(platform_warm->fs[i]);
+    }
+  }
+
+  return NULL;
+}
+
 static void explain_platform_chroot_ev(const void *event_data,
     void *user_data) {
   const char *path;
+  const struct platform_fs_limits *limits;
 
   path = event_data;
   (void) user_data;
 
+  /* The daemon may already have looked up the limits for this filesystem. */
+  limits = platform_get_fs_limits(path);
+  if (limits != NULL) {
+    platform_sess_name_max = limits->name_max;
+    platform_sess_no_trunc = limits->no_trunc;
+    platform_sess_path_max = limits->path_max;
+
+  } else {
 #if defined(HAVE_PATHCONF)
-  platform_sess_name_max = pathconf(path, _PC_NAME_MAX);
-  platform_sess_no_trunc = pathconf(path, _PC_NO_TRUNC);
-  platform_sess_path_max = pathconf(path, _PC_PATH_MAX);
+    platform_sess_name_max = pathconf(path, _PC_NAME_MAX);
+    platform_sess_no_trunc = pathconf(path, _PC_NO_TRUNC);
+    platform_sess_path_max = pathconf(path, _PC_PATH_MAX);
 #endif /* HAVE_PATHCONF */
+  }
+
+  /* Note that this event is generated BEFORE the chroot(2), thus this handle
+   * refers to the new root once the chroot(2) succeeds.
+   */
+  platform_close_fds();
+  platform_sess_root_fd = platform_open_dir(path);
+  platform_sess_root_pending = (platform_sess_root_fd >= 0);
 }
 
 long explain_platform_child_max(pool *p) {
   (void) p;
+
   return sysconf(_SC_CHILD_MAX);
 }
 
 long explain_platform_iov_max(pool *p) {
   (void) p;
+
   return sysconf(_SC_IOV_MAX);
 }
 
@@ -114,15 +233,314 @@ long explain_platform_path_max(pool *p, const char *path) {
 
 long explain_platform_open_max(pool *p) {
   (void) p;
+
   return sysconf(_SC_OPEN_MAX);
 }
 
+int explain_platform_root_fd(void) {
+  if (platform_sess_root_pending == TRUE) {
+    /* The handle on the new root is only valid once the chroot(2) has
+     * actually happened; until then, there is no usable handle.
+     */
+    if (session.chroot_path == NULL) {
+      errno = ENOENT;
+      return -1;
+    }
+
+    platform_sess_root_pending = FALSE;
+  }
+
+  if (platform_sess_root_fd < 0) {
+    platform_sess_root_fd = platform_open_dir("/");
+    if (platform_sess_root_fd < 0) {
+      int xerrno = errno;
+
+      pr_trace_msg(trace_channel, 3, "error opening root directory: %s",
+        strerror(xerrno));
+
+      errno = xerrno;
+      return -1;
+    }
+  }
+
+  return platform_sess_root_fd;
+}
+
+int explain_platform_get_home(const char **home_path) {
+  if (platform_sess_home_fd < 0) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  if (home_path != NULL) {
+    *home_path = platform_sess_home_path;
+  }
+
+  return platform_sess_home_checked;
+}
+
+int explain_platform_check_home(const struct stat *st) {
+  if (platform_sess_home_fd < 0) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  if (st == NULL) {
+    platform_sess_home_checked = EXPLAIN_PLATFORM_HOME_STALE;
+    errno = ESTALE;
+    return -1;
+  }
+
+  if (st->st_dev != platform_sess_home_dev ||
+      st->st_ino != platform_sess_home_ino) {
+    pr_trace_msg(trace_channel, 9,
+      "home '%s' has been replaced, not using its handle",
+      platform_sess_home_path);
+    platform_sess_home_checked = EXPLAIN_PLATFORM_HOME_STALE;
+    errno = ESTALE;
+    return -1;
+  }
+
+  platform_sess_home_checked = EXPLAIN_PLATFORM_HOME_VALID;
+  return 0;
+}
+
+void explain_platform_uncheck_home(void) {
+  platform_sess_home_checked = EXPLAIN_PLATFORM_HOME_UNCHECKED;
+}
+
+int explain_platform_home_fd(const char **home_path) {
+  if (platform_sess_home_fd < 0 ||
+      platform_sess_home_checked != EXPLAIN_PLATFORM_HOME_VALID) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  if (home_path != NULL) {
+    *home_path = platform_sess_home_path;
+  }
+
+  return platform_sess_home_fd;
+}
+
+int explain_platform_set_home(pool *p, const char *home_path) {
+  int fd;
+  struct stat st;
+  pr_fs_t *fs;
+
+  if (p == NULL ||
+      home_path == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  fs = pr_get_fs(home_path, NULL);
+  if (fs == NULL ||
+      fs->fs_name == NULL ||
+      strcmp(fs->fs_name, "system") != 0) {
+    pr_trace_msg(trace_channel, 9,
+      "home '%s' is not on the system filesystem, not opening a handle",
+      home_path);
+    errno = ENOSYS;
+    return -1;
+  }
+
+  fd = platform_open_dir(home_path);
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (fstat(fd, &st) < 0) {
+    int xerrno = errno;
+
+    (void) close(fd);
+    errno = xerrno;
+    return -1;
+  }
+
+  if (platform_sess_home_fd >= 0) {
+    (void) close(platform_sess_home_fd);
+  }
+
+  platform_sess_home_fd = fd;
+  platform_sess_home_path = pstrdup(p, home_path);
+  platform_sess_home_dev = st.st_dev;
+  platform_sess_home_ino = st.st_ino;
+  platform_sess_home_checked = EXPLAIN_PLATFORM_HOME_UNCHECKED;
+  return 0;
+}
+
+int explain_platform_open_file(const char *path, int flags, mode_t mode) {
+  int fd, xerrno;
+  char dir_path[PR_TUNABLE_PATH_MAX+1], *ptr;
+  struct stat st;
+
+  if (path == NULL ||
+      *path != '/') {
+    errno = EINVAL;
+    return -1;
+  }
+
+  /* As pr_log_openfile() does, refuse files in world-writable directories,
+   * in which anyone could have planted, or could later replace, the file.
+   */
+  sstrncpy(dir_path, path, sizeof(dir_path));
+  ptr = strrchr(dir_path, '/');
+  if (ptr == dir_path) {
+    ptr++;
+  }
+  *ptr = '\0';
+
+  if (stat(dir_path, &st) < 0) {
+    xerrno = errno;
+
+    pr_trace_msg(trace_channel, 3, "unable to stat directory '%s': %s",
+      dir_path, strerror(xerrno));
+
+    errno = xerrno;
+    return -1;
+  }
+
+  if (st.st_mode & S_IWOTH) {
+    pr_trace_msg(trace_channel, 1,
+      "unable to use '%s': parent directory '%s' is world-writable", path,
+      dir_path);
+    errno = EPERM;
+    return -1;
+  }
+
+  fd = open(path, flags|O_CREAT|O_NOFOLLOW|O_CLOEXEC, mode);
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (fstat(fd, &st) < 0) {
+    xerrno = errno;
+
+    (void) close(fd);
+    errno = xerrno;
+    return -1;
+  }
+
+  /* Nor use a file which is not ours alone. */
+  if (!S_ISREG(st.st_mode) ||
+      st.st_nlink > 1 ||
+      st.st_uid != geteuid()) {
+    pr_trace_msg(trace_channel, 1,
+      "unable to use '%s': not a regular file owned by UID %lu", path,
+      (unsigned long) geteuid());
+    (void) close(fd);
+    errno = EPERM;
+    return -1;
+  }
+
+  if ((st.st_mode & 07777) != mode &&
+      fchmod(fd, mode) < 0) {
+    pr_trace_msg(trace_channel, 3, "unable to set mode of '%s': %s", path,
+      strerror(errno));
+  }
+
+  return fd;
+}
+
+static void platform_warm_fs(struct platform_warm *warm, const char *path) {
+  register unsigned int i;
+  struct stat st;
+  struct platform_fs_limits *limits;
+
+  if (stat(path, &st) < 0) {
+    pr_trace_msg(trace_channel, 9, "unable to stat '%s': %s", path,
+      strerror(errno));
+    return;
+  }
+
+  for (i = 0; i < warm->nfs; i++) {
+    if (warm->fs[i].dev == st.st_dev) {
+      return;
+    }
+  }
+
+  if (warm->nfs == PLATFORM_WARM_MAX_FS) {
+    return;
+  }
+
+  limits = &(warm->fs[warm->nfs++]);
+  limits->dev = st.st_dev;
+#if defined(HAVE_PATHCONF)
+  limits->name_max = pathconf(path, _PC_NAME_MAX);
+  limits->no_trunc = pathconf(path, _PC_NO_TRUNC);
+  limits->path_max = pathconf(path, _PC_PATH_MAX);
+#else
+  limits->name_max = limits->no_trunc = limits->path_max = -1;
+#endif /* HAVE_PATHCONF */
+
+  pr_trace_msg(trace_channel, 17,
+    "filesystem of '%s': NAME_MAX %ld, NO_TRUNC %ld, PATH_MAX %ld", path,
+    limits->name_max, limits->no_trunc, limits->path_max);
+}
+
+int explain_platform_warm(pool *p, array_header *paths) {
+  register unsigned int i;
+  struct platform_warm *warm;
+
+  if (p == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  explain_platform_warm_free();
+
+  warm = mmap(NULL, sizeof(struct platform_warm), PROT_READ|PROT_WRITE,
+    MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (warm == MAP_FAILED) {
+    return -1;
+  }
+
+  /* Every directory leading up to each of the given paths (e.g. the
+   * DefaultRoot directories), as sessions may chroot to any of them.
+   */
+  platform_warm_fs(warm, "/");
+
+  if (paths != NULL) {
+    for (i = 0; i < paths->nelts; i++) {
+      char *path, *ptr;
+
+      path = pstrdup(p, ((char **) paths->elts)[i]);
+
+      for (ptr = strchr(path + 1, '/'); ptr != NULL;
+          ptr = strchr(ptr + 1, '/')) {
+        *ptr = '\0';
+        platform_warm_fs(warm, path);
+        *ptr = '/';
+      }
+
+      platform_warm_fs(warm, path);
+    }
+  }
+
+  if (mprotect(warm, sizeof(struct platform_warm), PROT_READ) < 0) {
+    pr_trace_msg(trace_channel, 3,
+      "unable to make platform limits read-only: %s", strerror(errno));
+  }
+
+  platform_warm = warm;
+  return 0;
+}
+
+void explain_platform_warm_free(void) {
+  if (platform_warm != NULL) {
+    (void) munmap(platform_warm, sizeof(struct platform_warm));
+    platform_warm = NULL;
+  }
+}
+
 void explain_platform_init(pool *p) {
   (void) p;
 
   platform_sess_name_max = -1;
   platform_sess_no_trunc = -1;
   platform_sess_path_max = -1;
+  platform_close_fds();
 
   /* Register a listener for the chroot event, so that we can look up
    * system limits, based on paths, BEFORE the chroot(2) happens.
@@ -134,7 +552,9 @@ void explain_platform_init(pool *p) {
 void explain_platform_free(pool *p) {
   (void) p;
 
-  pr_event_unregister(&explain_module, "core.chroot", NULL);
+  pr_event_unregister(&explain_module, "core.chroot",
+    explain_platform_chroot_ev);
+  platform_close_fds();
 
   platform_sess_name_max = -1;
   platform_sess_no_trunc = -1;
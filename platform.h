@@ -34,6 +34,58 @@ long explain_platform_no_trunc(pool *p, const char *path);
 long explain_platform_path_max(pool *p, const char *path);
 long explain_platform_open_max(pool *p);
 
+/* Returns a handle on the root directory: the session root, once the
+ * session has chrooted.  Between the chroot event and the chroot(2) itself,
+ * returns -1 with errno set to ENOENT.
+ */
+int explain_platform_root_fd(void);
+
+/* Returns a handle on the user's home directory, and its path, once the user
+ * has logged in, and while the handle is checked; otherwise, returns -1 with
+ * errno set to ENOENT.
+ */
+int explain_platform_home_fd(const char **home_path);
+
+/* Returns whether the home directory has been checked, since last unchecked,
+ * and its path; returns -1, with errno set to ENOENT, if there is no home
+ * directory handle.
+ */
+int explain_platform_get_home(const char **home_path);
+#define EXPLAIN_PLATFORM_HOME_UNCHECKED		0
+#define EXPLAIN_PLATFORM_HOME_VALID		1
+#define EXPLAIN_PLATFORM_HOME_STALE		2
+
+/* Records whether the home directory path still resolves, through searchable
+ * ancestors, to the directory whose handle we hold, given the result of
+ * stat'ing that path (NULL if the stat failed); only then is the handle
+ * returned by explain_platform_home_fd(), until unchecked.  Returns -1, with
+ * errno set to ESTALE, if not.
+ */
+int explain_platform_check_home(const struct stat *st);
+void explain_platform_uncheck_home(void);
+
+/* Records the user's home directory, and opens a handle on it.  Returns -1,
+ * with errno set to ENOSYS, if the home directory is not on the system
+ * filesystem.
+ */
+int explain_platform_set_home(pool *p, const char *home_path);
+
+/* Opens (creating if need be) a file such as ExplainStatsFile, refusing, as
+ * pr_log_openfile() does, a file in a world-writable directory, a symlink,
+ * or a file which is not a regular file owned by the current user.  The
+ * mode of an existing file is reset to the given mode.  Returns the file
+ * descriptor, or -1 with errno set (EPERM for a refused file).
+ */
+int explain_platform_open_file(const char *path, int flags, mode_t mode);
+
+/* Looks up, once, the limits shared by all sessions: the filesystem limits
+ * for every directory leading up to the given paths (e.g. DefaultRoot
+ * directories).  Intended to be called by the
+ * daemon, before forking sessions, which then inherit these limits.
+ */
+int explain_platform_warm(pool *p, array_header *paths);
+void explain_platform_warm_free(void);
+
 void explain_platform_init(pool *p);
 void explain_platform_free(pool *p);
 
@@ -0,0 +1,225 @@
+/*
+ * ProFTPD - mod_explain: per-server explanation policies
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Looking up the Explain directives in every new session means walking the
+ * configuration, each time, for the same answers.  Instead, we compile each
+ * server's directives into a policy once, in the daemon, and the forked
+ * sessions simply look up the policy for their server.
+ */
+
+#include "policy.h"
+#include "cache.h"
+#include "stats.h"
+
+static array_header *policies = NULL;
+
+static const char *trace_channel = "explain.policy";
+
+static struct explain_policy *policy_lookup(server_rec *s) {
+  register unsigned int i;
+  struct explain_policy **elts;
+
+  elts = policies->elts;
+  for (i = 0; i < policies->nelts; i++) {
+    if (elts[i]->server == s) {
+      return elts[i];
+    }
+  }
+
+  return NULL;
+}
+
+const struct explain_policy *explain_policy_compile(pool *p, server_rec *s) {
+  struct explain_policy *policy;
+  config_rec *c;
+
+  if (p == NULL ||
+      s == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  if (policies == NULL) {
+    errno = EPERM;
+    return NULL;
+  }
+
+  policy = policy_lookup(s);
+  if (policy == NULL) {
+    policy = pcalloc(p, sizeof(struct explain_policy));
+    policy->server = s;
+    *((struct explain_policy **) push_array(policies)) = policy;
+  }
+
+  /* ExplainEngine was once only allowed in the server config; a vhost which
+   * does not set its own still follows that setting.
+   */
+  policy->engine = TRUE;
+  c = find_config(s->conf, CONF_PARAM, "ExplainEngine", FALSE);
+  if (c == NULL &&
+      main_server != NULL &&
+      s != main_server) {
+    c = find_config(main_server->conf, CONF_PARAM, "ExplainEngine", FALSE);
+  }
+
+  if (c != NULL) {
+    policy->engine = *((int *) c->argv[0]);
+  }
+
+  policy->verbosity = PR_ERROR_FORMAT_USE_DETAILED;
+  c = find_config(s->conf, CONF_PARAM, "ExplainVerbosity", FALSE);
+  if (c != NULL) {
+    policy->verbosity = *((unsigned int *) c->argv[0]);
+  }
+
+  policy->probe_budget = 0;
+  c = find_config(s->conf, CONF_PARAM, "ExplainProbeBudget", FALSE);
+  if (c != NULL) {
+    policy->probe_budget = *((unsigned int *) c->argv[0]);
+  }
+
+  policy->syscalls = EXPLAIN_POLICY_ALL_SYSCALLS;
+  c = find_config(s->conf, CONF_PARAM, "ExplainSyscalls", FALSE);
+  if (c != NULL) {
+    policy->syscalls = *((unsigned long *) c->argv[0]);
+  }
+
+  policy->opts = 0UL;
+  c = find_config(s->conf, CONF_PARAM, "ExplainOptions", FALSE);
+  while (c != NULL) {
+    unsigned long opts;
+
+    pr_signals_handle();
+
+    opts = *((unsigned long *) c->argv[0]);
+    policy->opts |= opts;
+
+    c = find_config_next(c, c->next, CONF_PARAM, "ExplainOptions", FALSE);
+  }
+
+  policy->cache_max_entries = EXPLAIN_CACHE_DEFAULT_MAX_ENTRIES;
+  if (policy->opts & EXPLAIN_OPT_NO_CACHE) {
+    policy->cache_max_entries = 0;
+  }
+
+  policy->ratelimit = FALSE;
+  c = find_config(s->conf, CONF_PARAM, "ExplainRateLimit", FALSE);
+  if (c != NULL) {
+    policy->ratelimit = TRUE;
+    policy->ratelimit_rate = *((unsigned int *) c->argv[0]);
+    policy->ratelimit_rate_secs = *((unsigned int *) c->argv[1]);
+    policy->ratelimit_burst = *((unsigned int *) c->argv[2]);
+    policy->ratelimit_sample = *((unsigned int *) c->argv[3]);
+    policy->ratelimit_summary_secs = *((unsigned int *) c->argv[4]);
+  }
+
+  policy->adaptive = FALSE;
+  c = find_config(s->conf, CONF_PARAM, "ExplainAdaptiveVerbosity", FALSE);
+  if (c != NULL &&
+      *((int *) c->argv[0]) == TRUE) {
+    policy->adaptive = TRUE;
+    policy->adapt_max_usecs = *((unsigned long *) c->argv[1]);
+    policy->adapt_max_loadavg = *((double *) c->argv[2]);
+    policy->adapt_max_sessions = *((unsigned int *) c->argv[3]);
+  }
+
+  pr_trace_msg(trace_channel, 9,
+    "compiled policy for server '%s': engine %s, verbosity %u, "
+    "probe budget %u, syscalls %#lx, cache entries %u, options %#lx, "
+    "rate limit %s, adaptive verbosity %s", s->ServerName,
+    policy->engine ? "on" : "off", policy->verbosity, policy->probe_budget,
+    policy->syscalls, policy->cache_max_entries, policy->opts,
+    policy->ratelimit ? "on" : "off", policy->adaptive ? "on" : "off");
+  return policy;
+}
+
+const struct explain_policy *explain_policy_get(server_rec *s) {
+  const struct explain_policy *policy = NULL;
+
+  if (policies != NULL &&
+      s != NULL) {
+    policy = policy_lookup(s);
+  }
+
+  if (policy == NULL) {
+    errno = ENOENT;
+  }
+
+  return policy;
+}
+
+int explain_policy_explains(const struct explain_policy *policy,
+    unsigned int syscall_id) {
+  if (policy == NULL ||
+      syscall_id >= EXPLAIN_SYSCALL_MAX) {
+    return FALSE;
+  }
+
+  if (policy->engine == FALSE) {
+    return FALSE;
+  }
+
+  return (policy->syscalls & EXPLAIN_POLICY_SYSCALL(syscall_id)) ? TRUE :
+    FALSE;
+}
+
+int explain_policy_get_syscall_id(const char *name) {
+  register unsigned int i;
+  size_t namelen;
+
+  if (name == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  namelen = strlen(name);
+
+  /* Our syscall names carry their manual section, e.g. "unlink(2)". */
+  for (i = 0; i < EXPLAIN_SYSCALL_MAX; i++) {
+    const char *syscall_name;
+
+    syscall_name = explain_stats_syscall_name(i);
+    if (strncasecmp(syscall_name, name, namelen) == 0 &&
+        syscall_name[namelen] == '(') {
+      return (int) i;
+    }
+  }
+
+  errno = ENOENT;
+  return -1;
+}
+
+int explain_policy_init(pool *p) {
+  if (p == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  policies = make_array(p, 1, sizeof(struct explain_policy *));
+  return 0;
+}
+
+void explain_policy_free(void) {
+  policies = NULL;
+}
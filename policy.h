@@ -0,0 +1,99 @@
+/*
+ * ProFTPD - mod_explain: per-server explanation policies
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_POLICY_H
+#define MOD_EXPLAIN_POLICY_H
+
+#include "mod_explain.h"
+
+/* How explanations are made for the sessions of one server (i.e. vhost),
+ * compiled once from its configuration, after the configuration is parsed.
+ */
+struct explain_policy {
+  server_rec *server;
+
+  int engine;
+  unsigned int verbosity;
+
+  /* The most path components to probe, for one explanation; zero for no
+   * limit.
+   */
+  unsigned int probe_budget;
+
+  /* The syscalls whose errors are explained, as a mask of
+   * EXPLAIN_POLICY_SYSCALL() bits.
+   */
+  unsigned long syscalls;
+
+  /* The size of the session cache; zero disables caching. */
+  unsigned int cache_max_entries;
+
+  /* Rate limiting, if ExplainRateLimit is configured; see
+   * explain_ratelimit_init() for the parameters.
+   */
+  int ratelimit;
+  unsigned int ratelimit_rate;
+  unsigned int ratelimit_rate_secs;
+  unsigned int ratelimit_burst;
+  unsigned int ratelimit_sample;
+  unsigned int ratelimit_summary_secs;
+
+  /* Adaptive verbosity, if enabled by ExplainAdaptiveVerbosity; see
+   * explain_adapt_init() for the thresholds.
+   */
+  int adaptive;
+  unsigned long adapt_max_usecs;
+  double adapt_max_loadavg;
+  unsigned int adapt_max_sessions;
+
+  unsigned long opts;
+};
+
+#define EXPLAIN_POLICY_SYSCALL(syscall_id)	(1UL << (syscall_id))
+#define EXPLAIN_POLICY_ALL_SYSCALLS \
+  ((1UL << EXPLAIN_SYSCALL_MAX) - 1)
+
+/* Compiles the policy for the given server, replacing any previously
+ * compiled for it.  Returns the policy, or NULL (with errno set) on error.
+ */
+const struct explain_policy *explain_policy_compile(pool *p, server_rec *s);
+
+/* Returns the policy compiled for the given server, or NULL, with errno set
+ * to ENOENT, if there is none.
+ */
+const struct explain_policy *explain_policy_get(server_rec *s);
+
+/* Returns TRUE if the given policy explains errors from the given syscall. */
+int explain_policy_explains(const struct explain_policy *policy,
+  unsigned int syscall_id);
+
+/* Returns the ID of the syscall with the given name (e.g. "unlink"), or -1,
+ * with errno set to ENOENT, if there is no such syscall.
+ */
+int explain_policy_get_syscall_id(const char *name);
+
+int explain_policy_init(pool *p);
+void explain_policy_free(void);
+
+#endif /* MOD_EXPLAIN_POLICY_H */
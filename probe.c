@@ -0,0 +1,727 @@
+/*
+ * ProFTPD - mod_explain: path probing
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Needed for the statx(2) declarations. */
+#if !defined(_GNU_SOURCE)
+# define _GNU_SOURCE
+#endif
+
+#include "probe.h"
+#include "platform.h"
+
+#if defined(HAVE_STATX) && defined(AT_STATX_DONT_SYNC)
+# define EXPLAIN_USE_STATX	1
+# include <sys/sysmacros.h>
+
+/* The fields which the explainers actually read. */
+# define EXPLAIN_STATX_MASK \
+  (STATX_TYPE|STATX_MODE|STATX_UID|STATX_GID|STATX_INO|STATX_CTIME)
+
+# if defined(HAVE_IO_URING)
+#  define EXPLAIN_USE_IO_URING	1
+#  include <sys/syscall.h>
+#  include <linux/io_uring.h>
+
+/* Maximum number of statx(2) requests submitted at once. */
+#  define EXPLAIN_IO_URING_ENTRIES	64
+# endif /* HAVE_IO_URING */
+#endif
+
+#if defined(HAVE_OPENAT2)
+# define EXPLAIN_USE_OPENAT2	1
+# include <sys/syscall.h>
+# include <linux/openat2.h>
+#endif /* HAVE_OPENAT2 */
+
+#define EXPLAIN_PROBE_FL_ALL \
+  (EXPLAIN_PROBE_FL_USE_STATX|EXPLAIN_PROBE_FL_USE_IO_URING|\
+   EXPLAIN_PROBE_FL_USE_OPENAT2)
+
+/* Backends are cleared if the kernel (or a seccomp filter) rejects them. */
+static unsigned long probe_flags = EXPLAIN_PROBE_FL_ALL;
+
+/* The backends with which each session starts: those which the daemon found
+ * to be supported, so that sessions need not each discover the same.
+ */
+static unsigned long probe_session_flags = EXPLAIN_PROBE_FL_ALL;
+
+/* Running totals of the probes made, and of the syscalls used to make them;
+ * with batching, the latter can be much lower.
+ */
+static unsigned long probe_nprobes = 0;
+static unsigned long probe_nsyscalls = 0;
+
+static const char *trace_channel = "explain.probe";
+
+#if defined(EXPLAIN_USE_STATX) || defined(EXPLAIN_USE_OPENAT2)
+/* We can only bypass the FSIO API for paths handled by the default "system"
+ * filesystem; other modules (e.g. mod_vroot) may register their own FSIO
+ * handlers, which we must honor.
+ */
+static int probe_is_system_fs(const char *path) {
+  pr_fs_t *fs;
+
+  fs = pr_get_fs(path, NULL);
+  if (fs == NULL ||
+      fs->fs_name == NULL) {
+    return FALSE;
+  }
+
+  return (strcmp(fs->fs_name, "system") == 0);
+}
+
+static const char *probe_rel_path(const char *path) {
+  while (*path == '/') {
+    path++;
+  }
+
+  if (*path == '\0') {
+    return ".";
+  }
+
+  return path;
+}
+
+/* Returns the directory handle at which a probe of the given path should be
+ * anchored, and the path relative to that handle.  Paths beneath the user's
+ * home directory are anchored there; other paths, once chrooted, at the
+ * session root.  Otherwise, AT_FDCWD and the path itself are returned.
+ */
+static int probe_get_anchor(const char *path, const char **rel_path) {
+  const char *home_path = NULL;
+  int fd;
+
+  fd = explain_platform_home_fd(&home_path);
+  if (fd >= 0 &&
+      home_path != NULL) {
+    size_t home_len;
+
+    home_len = strlen(home_path);
+    if (home_len > 1 &&
+        strncmp(path, home_path, home_len) == 0 &&
+        (path[home_len] == '/' || path[home_len] == '\0')) {
+      *rel_path = probe_rel_path(path + home_len);
+      return fd;
+    }
+  }
+
+  if (session.chroot_path != NULL &&
+      *path == '/') {
+    fd = explain_platform_root_fd();
+    if (fd >= 0) {
+      *rel_path = probe_rel_path(path);
+      return fd;
+    }
+  }
+
+  *rel_path = path;
+  return AT_FDCWD;
+}
+#endif /* EXPLAIN_USE_STATX or EXPLAIN_USE_OPENAT2 */
+
+#if defined(EXPLAIN_USE_STATX)
+static void probe_statx2stat(struct statx *stx, struct stat *st) {
+  memset(st, 0, sizeof(struct stat));
+  st->st_mode = stx->stx_mode;
+  st->st_uid = stx->stx_uid;
+  st->st_gid = stx->stx_gid;
+  st->st_ino = stx->stx_ino;
+  st->st_dev = makedev(stx->stx_dev_major, stx->stx_dev_minor);
+  st->st_ctime = stx->stx_ctime.tv_sec;
+}
+
+static int probe_statx(const char *path, struct stat *st) {
+  int dirfd, res;
+  struct statx stx;
+  const char *rel_path = NULL;
+
+  dirfd = probe_get_anchor(path, &rel_path);
+
+  probe_nprobes++;
+  probe_nsyscalls++;
+  res = statx(dirfd, rel_path, AT_SYMLINK_NOFOLLOW|AT_STATX_DONT_SYNC,
+    EXPLAIN_STATX_MASK, &stx);
+  if (res < 0) {
+    return -1;
+  }
+
+  probe_statx2stat(&stx, st);
+  return 0;
+}
+#endif /* EXPLAIN_USE_STATX */
+
+#if defined(EXPLAIN_USE_IO_URING)
+/* A minimal io_uring(7) ring, set up via the raw syscalls, so that we do not
+ * need to link against liburing.  It is set up lazily, on the first batch
+ * made as the session's user, and then kept for the remainder of the
+ * session.
+ */
+static int probe_uring_fd = -1;
+static void *probe_uring_sq_ptr = NULL, *probe_uring_cq_ptr = NULL;
+static size_t probe_uring_sq_sz = 0, probe_uring_cq_sz = 0;
+static struct io_uring_sqe *probe_uring_sqes = NULL;
+static size_t probe_uring_sqes_sz = 0;
+static unsigned int *probe_uring_sq_tail = NULL, *probe_uring_sq_mask = NULL,
+  *probe_uring_sq_array = NULL;
+static unsigned int *probe_uring_cq_head = NULL, *probe_uring_cq_tail = NULL,
+  *probe_uring_cq_mask = NULL;
+static struct io_uring_cqe *probe_uring_cqes = NULL;
+
+static void probe_uring_close(void) {
+  if (probe_uring_sqes != NULL) {
+    (void) munmap(probe_uring_sqes, probe_uring_sqes_sz);
+    probe_uring_sqes = NULL;
+  }
+
+  if (probe_uring_cq_ptr != NULL &&
+      probe_uring_cq_ptr != probe_uring_sq_ptr) {
+    (void) munmap(probe_uring_cq_ptr, probe_uring_cq_sz);
+  }
+  probe_uring_cq_ptr = NULL;
+
+  if (probe_uring_sq_ptr != NULL) {
+    (void) munmap(probe_uring_sq_ptr, probe_uring_sq_sz);
+    probe_uring_sq_ptr = NULL;
+  }
+
+  if (probe_uring_fd >= 0) {
+    (void) close(probe_uring_fd);
+    probe_uring_fd = -1;
+  }
+}
+
+static int probe_uring_open(void) {
+  int fd, xerrno;
+  struct io_uring_params params;
+  unsigned char *sq_ptr, *cq_ptr;
+
+  if (probe_uring_fd >= 0) {
+    return 0;
+  }
+
+  memset(&params, 0, sizeof(params));
+  fd = (int) syscall(__NR_io_uring_setup, EXPLAIN_IO_URING_ENTRIES, &params);
+  if (fd < 0) {
+    return -1;
+  }
+
+  probe_uring_fd = fd;
+  probe_uring_sq_sz = params.sq_off.array +
+    (params.sq_entries * sizeof(unsigned int));
+  probe_uring_cq_sz = params.cq_off.cqes +
+    (params.cq_entries * sizeof(struct io_uring_cqe));
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (probe_uring_cq_sz > probe_uring_sq_sz) {
+      probe_uring_sq_sz = probe_uring_cq_sz;
+    }
+
+    probe_uring_cq_sz = probe_uring_sq_sz;
+  }
+
+  sq_ptr = mmap(NULL, probe_uring_sq_sz, PROT_READ|PROT_WRITE,
+    MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ptr == MAP_FAILED) {
+    xerrno = errno;
+    probe_uring_close();
+
+    errno = xerrno;
+    return -1;
+  }
+  probe_uring_sq_ptr = sq_ptr;
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ptr = sq_ptr;
+
+  } else {
+    cq_ptr = mmap(NULL, probe_uring_cq_sz, PROT_READ|PROT_WRITE,
+      MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ptr == MAP_FAILED) {
+      xerrno = errno;
+      probe_uring_close();
+
+      errno = xerrno;
+      return -1;
+    }
+  }
+  probe_uring_cq_ptr = cq_ptr;
+
+  probe_uring_sqes_sz = params.sq_entries * sizeof(struct io_uring_sqe);
+  probe_uring_sqes = mmap(NULL, probe_uring_sqes_sz, PROT_READ|PROT_WRITE,
+    MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (probe_uring_sqes == MAP_FAILED) {
+    xerrno = errno;
+    probe_uring_sqes = NULL;
+    probe_uring_close();
+
+    errno = xerrno;
+    return -1;
+  }
+
+  probe_uring_sq_tail = (unsigned int *) (sq_ptr + params.sq_off.tail);
+  probe_uring_sq_mask = (unsigned int *) (sq_ptr + params.sq_off.ring_mask);
+  probe_uring_sq_array = (unsigned int *) (sq_ptr + params.sq_off.array);
+  probe_uring_cq_head = (unsigned int *) (cq_ptr + params.cq_off.head);
+  probe_uring_cq_tail = (unsigned int *) (cq_ptr + params.cq_off.tail);
+  probe_uring_cq_mask = (unsigned int *) (cq_ptr + params.cq_off.ring_mask);
+  probe_uring_cqes = (struct io_uring_cqe *) (cq_ptr + params.cq_off.cqes);
+
+  pr_trace_msg(trace_channel, 15, "set up io_uring with %u entries",
+    params.sq_entries);
+  return 0;
+}
+
+/* Submits statx(2) requests for the given paths, and waits for all of their
+ * completions, using a single io_uring_enter(2) call.  On error, every
+ * request that was submitted has still been reaped (unless waiting for them
+ * failed), but the ring may hold unsubmitted requests; the caller must then
+ * close the ring, rather than reuse it.
+ */
+static int probe_uring_statx(const char **paths, unsigned int npaths,
+    struct statx *stxs, int *errnos) {
+  register unsigned int i;
+  unsigned int tail, head, mask, nsubmitted, ncompleted = 0;
+  int res, xerrno = 0;
+
+  tail = *probe_uring_sq_tail;
+  mask = *probe_uring_sq_mask;
+
+  for (i = 0; i < npaths; i++) {
+    unsigned int idx;
+    struct io_uring_sqe *sqe;
+    const char *rel_path = NULL;
+
+    idx = tail & mask;
+    sqe = &(probe_uring_sqes[idx]);
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_STATX;
+    sqe->fd = probe_get_anchor(paths[i], &rel_path);
+    sqe->addr = (unsigned long) rel_path;
+    sqe->len = EXPLAIN_STATX_MASK;
+    sqe->off = (unsigned long) &(stxs[i]);
+    sqe->statx_flags = AT_SYMLINK_NOFOLLOW|AT_STATX_DONT_SYNC;
+    sqe->user_data = i;
+
+    probe_uring_sq_array[idx] = idx;
+    tail++;
+  }
+
+  __atomic_store_n(probe_uring_sq_tail, tail, __ATOMIC_RELEASE);
+
+  probe_nprobes += npaths;
+  probe_nsyscalls++;
+  res = (int) syscall(__NR_io_uring_enter, probe_uring_fd, npaths, npaths,
+    IORING_ENTER_GETEVENTS, NULL, 0);
+  if (res < 0) {
+    /* Nothing was submitted. */
+    return -1;
+  }
+
+  nsubmitted = (unsigned int) res;
+  if (nsubmitted != npaths) {
+    /* Reap what was submitted, so that no completions are left to be
+     * mistaken for those of a later batch, then fail.
+     */
+    pr_trace_msg(trace_channel, 3,
+      "io_uring submitted only %u of %u statx requests", nsubmitted, npaths);
+    xerrno = EAGAIN;
+  }
+
+  head = *probe_uring_cq_head;
+  mask = *probe_uring_cq_mask;
+
+  while (ncompleted < nsubmitted) {
+    struct io_uring_cqe *cqe;
+
+    if (head == __atomic_load_n(probe_uring_cq_tail, __ATOMIC_ACQUIRE)) {
+      /* Not everything has completed yet; wait for the rest. */
+      probe_nsyscalls++;
+      res = (int) syscall(__NR_io_uring_enter, probe_uring_fd, 0,
+        nsubmitted - ncompleted, IORING_ENTER_GETEVENTS, NULL, 0);
+      if (res < 0 &&
+          errno != EINTR) {
+        xerrno = errno;
+        break;
+      }
+
+      continue;
+    }
+
+    cqe = &(probe_uring_cqes[head & mask]);
+    if (cqe->user_data < npaths) {
+      errnos[cqe->user_data] = cqe->res < 0 ? -(cqe->res) : 0;
+    }
+
+    head++;
+    ncompleted++;
+  }
+
+  __atomic_store_n(probe_uring_cq_head, head, __ATOMIC_RELEASE);
+
+  if (xerrno != 0) {
+    errno = xerrno;
+    return -1;
+  }
+
+  return 0;
+}
+#endif /* EXPLAIN_USE_IO_URING */
+
+int explain_probe_lstat(pool *p, const char *path, struct stat *st) {
+  (void) p;
+
+  if (path == NULL ||
+      st == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+#if defined(EXPLAIN_USE_STATX)
+  if ((probe_flags & EXPLAIN_PROBE_FL_USE_STATX) &&
+      probe_is_system_fs(path) == TRUE) {
+    int res;
+
+    res = probe_statx(path, st);
+    if (res == 0) {
+      return 0;
+    }
+
+    if (errno != ENOSYS &&
+        errno != EPERM) {
+      return -1;
+    }
+
+    /* Fall back to lstat(2) for the rest of this session. */
+    pr_trace_msg(trace_channel, 3,
+      "statx(2) unavailable (%s), falling back to lstat(2)", strerror(errno));
+    probe_flags &= ~EXPLAIN_PROBE_FL_USE_STATX;
+  }
+#endif /* EXPLAIN_USE_STATX */
+
+  probe_nprobes++;
+  probe_nsyscalls++;
+  return pr_fsio_lstat(path, st);
+}
+
+int explain_probe_lstat_full(pool *p, const char *path, struct stat *st) {
+  (void) p;
+
+  if (path == NULL ||
+      st == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  probe_nprobes++;
+  probe_nsyscalls++;
+  return pr_fsio_lstat(path, st);
+}
+
+int explain_probe_check_home(pool *p) {
+  const char *home_path = NULL;
+  int res;
+  struct stat st;
+
+  (void) p;
+
+  res = explain_platform_get_home(&home_path);
+  if (res < 0) {
+    return -1;
+  }
+
+  if (res == EXPLAIN_PLATFORM_HOME_VALID) {
+    return 0;
+  }
+
+  if (res == EXPLAIN_PLATFORM_HOME_STALE) {
+    errno = ESTALE;
+    return -1;
+  }
+
+  /* Resolving the path checks every ancestor, as the syscall did. */
+  probe_nprobes++;
+  probe_nsyscalls++;
+  if (pr_fsio_stat(home_path, &st) < 0) {
+    pr_trace_msg(trace_channel, 9, "unable to check home '%s': %s",
+      home_path, strerror(errno));
+    return explain_platform_check_home(NULL);
+  }
+
+  return explain_platform_check_home(&st);
+}
+
+int explain_probe_lstat_batch(pool *p, const char **paths,
+    unsigned int npaths, struct stat *sts, int *errnos) {
+#if defined(EXPLAIN_USE_IO_URING)
+  register unsigned int i;
+  struct statx *stxs;
+
+  if (p == NULL ||
+      paths == NULL ||
+      npaths == 0 ||
+      sts == NULL ||
+      errnos == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (!(probe_flags & EXPLAIN_PROBE_FL_USE_IO_URING) ||
+      !(probe_flags & EXPLAIN_PROBE_FL_USE_STATX)) {
+    errno = ENOSYS;
+    return -1;
+  }
+
+  /* Every prefix needs to be handled by the system filesystem; otherwise,
+   * the caller needs to use the FSIO API, one probe at a time.
+   */
+  for (i = 0; i < npaths; i++) {
+    if (probe_is_system_fs(paths[i]) == FALSE) {
+      errno = ENOSYS;
+      return -1;
+    }
+  }
+
+  /* Before Linux 5.12, io_uring requests run with the credentials of the
+   * ring's creator, rather than of the submitter; never create the ring
+   * with any identity other than the session's, e.g. whilst still root.
+   */
+  if (probe_uring_fd < 0 &&
+      (geteuid() != session.uid ||
+       getegid() != session.gid)) {
+    pr_trace_msg(trace_channel, 17,
+      "not setting up io_uring as UID %lu/GID %lu (session UID %lu/GID %lu)",
+      (unsigned long) geteuid(), (unsigned long) getegid(),
+      (unsigned long) session.uid, (unsigned long) session.gid);
+    errno = ENOSYS;
+    return -1;
+  }
+
+  if (probe_uring_open() < 0) {
+    pr_trace_msg(trace_channel, 3,
+      "io_uring unavailable (%s), falling back to serial probes",
+      strerror(errno));
+    probe_flags &= ~EXPLAIN_PROBE_FL_USE_IO_URING;
+
+    errno = ENOSYS;
+    return -1;
+  }
+
+  stxs = pcalloc(p, sizeof(struct statx) * npaths);
+
+  for (i = 0; i < npaths; i += EXPLAIN_IO_URING_ENTRIES) {
+    unsigned int count;
+
+    count = npaths - i;
+    if (count > EXPLAIN_IO_URING_ENTRIES) {
+      count = EXPLAIN_IO_URING_ENTRIES;
+    }
+
+    if (probe_uring_statx(paths + i, count, stxs + i, errnos + i) < 0) {
+      int xerrno = errno;
+
+      pr_trace_msg(trace_channel, 3,
+        "error submitting io_uring statx batch: %s", strerror(xerrno));
+
+      /* The ring may still hold unsubmitted, or unreaped, requests; never
+       * reuse it.
+       */
+      probe_uring_close();
+      probe_flags &= ~EXPLAIN_PROBE_FL_USE_IO_URING;
+
+      errno = ENOSYS;
+      return -1;
+    }
+  }
+
+  for (i = 0; i < npaths; i++) {
+    if (errnos[i] == EINVAL) {
+      /* Older kernels support io_uring, but not IORING_OP_STATX. */
+      pr_trace_msg(trace_channel, 3,
+        "io_uring statx unsupported, falling back to serial probes");
+      probe_uring_close();
+      probe_flags &= ~EXPLAIN_PROBE_FL_USE_IO_URING;
+
+      errno = ENOSYS;
+      return -1;
+    }
+
+    if (errnos[i] == 0) {
+      probe_statx2stat(&(stxs[i]), &(sts[i]));
+    }
+  }
+
+  return 0;
+#else
+  (void) p;
+  (void) paths;
+  (void) npaths;
+  (void) sts;
+  (void) errnos;
+
+  errno = ENOSYS;
+  return -1;
+#endif /* EXPLAIN_USE_IO_URING */
+}
+
+int explain_probe_resolve(pool *p, const char *path, int flags) {
+#if defined(EXPLAIN_USE_OPENAT2)
+  int dirfd, fd, xerrno;
+  struct open_how how;
+  const char *rel_path = NULL;
+
+  (void) p;
+
+  if (path == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (!(probe_flags & EXPLAIN_PROBE_FL_USE_OPENAT2) ||
+      probe_is_system_fs(path) == FALSE) {
+    errno = ENOSYS;
+    return -1;
+  }
+
+  dirfd = probe_get_anchor(path, &rel_path);
+  if (dirfd == AT_FDCWD) {
+    /* Paths are resolved beneath the root, so strip any leading slashes. */
+    dirfd = explain_platform_root_fd();
+    if (dirfd < 0) {
+      errno = ENOSYS;
+      return -1;
+    }
+
+    rel_path = probe_rel_path(path);
+  }
+
+  memset(&how, 0, sizeof(how));
+  how.flags = O_PATH|O_CLOEXEC|O_NOFOLLOW;
+  how.resolve = RESOLVE_BENEATH|RESOLVE_NO_SYMLINKS|RESOLVE_NO_MAGICLINKS;
+
+  if (flags & EXPLAIN_PROBE_RESOLVE_FL_DIRECTORY) {
+    how.flags |= O_DIRECTORY;
+  }
+
+  probe_nprobes++;
+  probe_nsyscalls++;
+  fd = (int) syscall(SYS_openat2, dirfd, rel_path, &how, sizeof(how));
+  if (fd < 0) {
+    xerrno = errno;
+
+    if (xerrno == ENOSYS ||
+        xerrno == EPERM ||
+        xerrno == E2BIG) {
+      pr_trace_msg(trace_channel, 3,
+        "openat2(2) unavailable (%s), disabling path classification",
+        strerror(xerrno));
+      probe_flags &= ~EXPLAIN_PROBE_FL_USE_OPENAT2;
+      xerrno = ENOSYS;
+    }
+
+    errno = xerrno;
+    return -1;
+  }
+
+  probe_nsyscalls++;
+  (void) close(fd);
+  return 0;
+#else
+  (void) p;
+  (void) path;
+  (void) flags;
+
+  errno = ENOSYS;
+  return -1;
+#endif /* EXPLAIN_USE_OPENAT2 */
+}
+
+void explain_probe_get_counts(unsigned long *nprobes,
+    unsigned long *nsyscalls) {
+  if (nprobes != NULL) {
+    *nprobes = probe_nprobes;
+  }
+
+  if (nsyscalls != NULL) {
+    *nsyscalls = probe_nsyscalls;
+  }
+}
+
+unsigned long explain_probe_get_flags(void) {
+  return probe_flags;
+}
+
+void explain_probe_set_flags(unsigned long flags) {
+  probe_flags = flags;
+}
+
+unsigned long explain_probe_detect(pool *p) {
+  const char *paths[1];
+  struct stat st;
+  int xerrno;
+
+  if (p == NULL) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  /* Each backend clears its flag, should the kernel reject it. */
+  probe_flags = EXPLAIN_PROBE_FL_ALL;
+
+  paths[0] = "/";
+  (void) explain_probe_lstat(p, paths[0], &st);
+  (void) explain_probe_lstat_batch(p, paths, 1, &st, &xerrno);
+  (void) explain_probe_resolve(p, paths[0],
+    EXPLAIN_PROBE_RESOLVE_FL_DIRECTORY);
+
+  /* Sessions open their own handles, as needed; the root handle is closed
+   * by explain_platform_init().
+   */
+#if defined(EXPLAIN_USE_IO_URING)
+  probe_uring_close();
+#endif /* EXPLAIN_USE_IO_URING */
+
+  probe_nprobes = probe_nsyscalls = 0;
+  probe_session_flags = probe_flags;
+
+  pr_trace_msg(trace_channel, 9, "detected probe backends: %s%s%s",
+    (probe_flags & EXPLAIN_PROBE_FL_USE_STATX) ? "statx " : "",
+    (probe_flags & EXPLAIN_PROBE_FL_USE_IO_URING) ? "io_uring " : "",
+    (probe_flags & EXPLAIN_PROBE_FL_USE_OPENAT2) ? "openat2" : "");
+  return probe_session_flags;
+}
+
+void explain_probe_init(pool *p) {
+  (void) p;
+
+  probe_flags = probe_session_flags;
+}
+
+void explain_probe_free(pool *p) {
+  (void) p;
+
+#if defined(EXPLAIN_USE_IO_URING)
+  probe_uring_close();
+#endif /* EXPLAIN_USE_IO_URING */
+}
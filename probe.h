@@ -0,0 +1,92 @@
+/*
+ * ProFTPD - mod_explain: path probing
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_PROBE_H
+#define MOD_EXPLAIN_PROBE_H
+
+#include "mod_explain.h"
+
+/* Probes the given path, without following a final symlink, in the manner of
+ * lstat(2).  Only the st_mode, st_uid, st_gid, st_ino, st_dev, and st_ctime
+ * fields of the given struct stat are guaranteed to be filled in; explanations do not
+ * need strictly coherent attributes, and thus, where possible, the probe
+ * avoids forcing a revalidation of cached attributes (e.g. for NFS).
+ */
+int explain_probe_lstat(pool *p, const char *path, struct stat *st);
+
+/* As explain_probe_lstat(), but always resolving the path in full, rather
+ * than from a directory handle, so that the probe succeeds only if every
+ * directory leading to the path can be searched with the current
+ * credentials.
+ */
+int explain_probe_lstat_full(pool *p, const char *path, struct stat *st);
+
+/* Checks, at most once until unchecked, that the home directory path still
+ * leads to the home directory handle, so that probes may be anchored there.
+ * The path is resolved in full, and the check counted as a probe.
+ */
+int explain_probe_check_home(pool *p);
+
+/* Probes all of the given paths, in the manner of explain_probe_lstat(), in
+ * a single batch.  On return, errnos[i] is zero if paths[i] was probed
+ * successfully (and sts[i] filled in), or the errno value for that probe.
+ *
+ * Returns -1, with errno set to ENOSYS, if batching is not available for
+ * these paths; callers should then probe each path in turn.
+ */
+int explain_probe_lstat_batch(pool *p, const char **paths,
+  unsigned int npaths, struct stat *sts, int *errnos);
+
+/* Resolves the given path beneath the session root, in a single syscall,
+ * refusing to traverse any symlinks.  Returns zero if the path resolves, or
+ * -1 with errno set to the resolution error.  If such resolution is not
+ * supported, -1 is returned with errno set to ENOSYS.
+ */
+int explain_probe_resolve(pool *p, const char *path, int flags);
+#define EXPLAIN_PROBE_RESOLVE_FL_DIRECTORY	0x0001
+
+/* Returns the running totals of probes made, and the syscalls used to make
+ * them, for this process.
+ */
+void explain_probe_get_counts(unsigned long *nprobes,
+  unsigned long *nsyscalls);
+
+/* Probing backends; these are enabled by default, where supported. */
+#define EXPLAIN_PROBE_FL_USE_STATX		0x0001
+#define EXPLAIN_PROBE_FL_USE_IO_URING		0x0002
+#define EXPLAIN_PROBE_FL_USE_OPENAT2		0x0004
+
+unsigned long explain_probe_get_flags(void);
+void explain_probe_set_flags(unsigned long flags);
+
+/* Detects which of the probing backends the kernel supports, and returns
+ * their flags; subsequent calls to explain_probe_init() enable only these.
+ * Intended to be called by the daemon, before forking sessions.
+ */
+unsigned long explain_probe_detect(pool *p);
+
+void explain_probe_init(pool *p);
+void explain_probe_free(pool *p);
+
+#endif /* MOD_EXPLAIN_PROBE_H */
@@ -0,0 +1,315 @@
+/*
+ * ProFTPD - mod_explain: explanation rate limiting
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* During an error storm (a full disk, an unreachable LDAP server), every
+ * failure would otherwise be explained, adding load when the server can
+ * least afford it.  Thus each (syscall, errno) gets a token bucket; once it
+ * runs dry, only 1 in N failures are explained, and the rest are counted,
+ * and periodically summarized.
+ */
+
+#include "ratelimit.h"
+#include "stats.h"
+
+struct explain_ratelimit_bucket {
+  double tokens;
+  uint64_t last_ms;
+
+  /* Failures over the limit since the last summary. */
+  unsigned long nover, nsampled, nsuppressed;
+  uint64_t since_ms;
+
+  /* Common prefix of the suppressed paths, allocated on first use. */
+  char *prefix;
+};
+
+static pool *ratelimit_pool = NULL;
+static struct explain_ratelimit_bucket
+  ratelimit_buckets[EXPLAIN_SYSCALL_MAX][EXPLAIN_STATS_MAX_ERRNO];
+
+static int ratelimit_enabled = FALSE;
+static double ratelimit_rate_per_ms = 0.0, ratelimit_burst = 0.0;
+static unsigned int ratelimit_sample = 0;
+static uint64_t ratelimit_summary_ms = 0, ratelimit_next_summary_ms = 0;
+static unsigned int ratelimit_npending = 0;
+
+static unsigned long ratelimit_nadmitted = 0, ratelimit_nsampled = 0,
+  ratelimit_nsuppressed = 0;
+
+static const char *trace_channel = "explain.ratelimit";
+
+static uint64_t get_now_ms(void) {
+  struct timespec now;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
+    return 0;
+  }
+
+  return ((uint64_t) now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+}
+
+/* Narrows the bucket's prefix to the deepest directory it has in common
+ * with the given path.
+ */
+static void merge_prefix(struct explain_ratelimit_bucket *bucket,
+    const char *path) {
+  register unsigned int i;
+
+  if (bucket->prefix == NULL) {
+    bucket->prefix = pcalloc(ratelimit_pool, PR_TUNABLE_PATH_MAX+1);
+  }
+
+  if (path == NULL) {
+    path = "";
+  }
+
+  if (bucket->nsuppressed == 0) {
+    sstrncpy(bucket->prefix, path, PR_TUNABLE_PATH_MAX+1);
+    return;
+  }
+
+  for (i = 0; bucket->prefix[i] != '\0'; i++) {
+    if (bucket->prefix[i] != path[i]) {
+      break;
+    }
+  }
+
+  if (bucket->prefix[i] == '\0' &&
+      (path[i] == '\0' || path[i] == '/')) {
+    return;
+  }
+
+  while (i > 0 &&
+         bucket->prefix[i] != '/') {
+    i--;
+  }
+
+  if (i == 0 &&
+      bucket->prefix[0] == '/') {
+    i = 1;
+  }
+
+  bucket->prefix[i] = '\0';
+}
+
+int explain_ratelimit_admit(pool *p, unsigned int syscall_id, int xerrno,
+    const char *path) {
+  struct explain_ratelimit_bucket *bucket;
+  uint64_t now_ms;
+  int admitted = TRUE;
+
+  if (ratelimit_enabled == FALSE ||
+      syscall_id >= EXPLAIN_SYSCALL_MAX) {
+    return TRUE;
+  }
+
+  if (xerrno < 0 ||
+      xerrno >= EXPLAIN_STATS_MAX_ERRNO) {
+    xerrno = 0;
+  }
+
+  now_ms = get_now_ms();
+  bucket = &(ratelimit_buckets[syscall_id][xerrno]);
+
+  if (bucket->last_ms == 0) {
+    bucket->tokens = ratelimit_burst;
+
+  } else {
+    bucket->tokens += (now_ms - bucket->last_ms) * ratelimit_rate_per_ms;
+    if (bucket->tokens > ratelimit_burst) {
+      bucket->tokens = ratelimit_burst;
+    }
+  }
+  bucket->last_ms = now_ms;
+
+  if (bucket->tokens >= 1.0) {
+    bucket->tokens -= 1.0;
+    ratelimit_nadmitted++;
+
+  } else {
+    if (bucket->nover == 0) {
+      bucket->since_ms = now_ms;
+      ratelimit_npending++;
+    }
+
+    bucket->nover++;
+
+    if (ratelimit_sample > 0 &&
+        (bucket->nover % ratelimit_sample) == 0) {
+      bucket->nsampled++;
+      ratelimit_nsampled++;
+
+    } else {
+      merge_prefix(bucket, path);
+      bucket->nsuppressed++;
+      ratelimit_nsuppressed++;
+      admitted = FALSE;
+    }
+  }
+
+  if (ratelimit_npending > 0 &&
+      now_ms >= ratelimit_next_summary_ms &&
+      p != NULL) {
+    register unsigned int i;
+    array_header *lines;
+
+    lines = explain_ratelimit_summarize(p, FALSE);
+    for (i = 0; i < lines->nelts; i++) {
+      pr_log_pri(PR_LOG_NOTICE, MOD_EXPLAIN_VERSION ": %s",
+        ((char **) lines->elts)[i]);
+    }
+  }
+
+  return admitted;
+}
+
+array_header *explain_ratelimit_summarize(pool *p, int force) {
+  register unsigned int i, j;
+  array_header *lines;
+  uint64_t now_ms;
+
+  if (p == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  lines = make_array(p, 1, sizeof(char *));
+  if (ratelimit_npending == 0) {
+    return lines;
+  }
+
+  now_ms = get_now_ms();
+
+  for (i = 0; i < EXPLAIN_SYSCALL_MAX; i++) {
+    for (j = 0; j < EXPLAIN_STATS_MAX_ERRNO; j++) {
+      struct explain_ratelimit_bucket *bucket;
+      char *line;
+
+      bucket = &(ratelimit_buckets[i][j]);
+      if (bucket->nover == 0) {
+        continue;
+      }
+
+      if (force == FALSE &&
+          now_ms - bucket->since_ms < ratelimit_summary_ms) {
+        continue;
+      }
+
+      if (bucket->nsuppressed == 0) {
+        /* Everything over the limit was sampled; nothing to summarize. */
+        bucket->nover = bucket->nsampled = 0;
+        ratelimit_npending--;
+        continue;
+      }
+
+      line = psprintf(p, "%lu further %s errors (%s)", bucket->nsuppressed,
+        explain_stats_syscall_name(i), j > 0 ? strerror(j) : "other");
+      if (bucket->prefix != NULL &&
+          *(bucket->prefix) != '\0') {
+        line = pstrcat(p, line, " on ", bucket->prefix, NULL);
+      }
+
+      line = pstrcat(p, line, psprintf(p, " suppressed in %lus",
+        (unsigned long) ((now_ms - bucket->since_ms + 999) / 1000)), NULL);
+      if (bucket->nsampled > 0) {
+        line = pstrcat(p, line, psprintf(p, " (%lu sampled)",
+          bucket->nsampled), NULL);
+      }
+
+      *((char **) push_array(lines)) = line;
+      pr_trace_msg(trace_channel, 9, "%s", line);
+
+      bucket->nover = bucket->nsampled = bucket->nsuppressed = 0;
+      ratelimit_npending--;
+    }
+  }
+
+  ratelimit_next_summary_ms = now_ms + ratelimit_summary_ms;
+  return lines;
+}
+
+void explain_ratelimit_get_counts(unsigned long *nadmitted,
+    unsigned long *nsampled, unsigned long *nsuppressed) {
+  if (nadmitted != NULL) {
+    *nadmitted = ratelimit_nadmitted;
+  }
+
+  if (nsampled != NULL) {
+    *nsampled = ratelimit_nsampled;
+  }
+
+  if (nsuppressed != NULL) {
+    *nsuppressed = ratelimit_nsuppressed;
+  }
+}
+
+int explain_ratelimit_init(pool *p, unsigned int rate, unsigned int rate_secs,
+    unsigned int burst, unsigned int sample, unsigned int summary_secs) {
+  if (p == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  explain_ratelimit_free();
+
+  if (rate == 0) {
+    pr_trace_msg(trace_channel, 9, "rate limiting disabled");
+    return 0;
+  }
+
+  if (rate_secs == 0) {
+    rate_secs = 1;
+  }
+
+  if (burst < 1) {
+    burst = 1;
+  }
+
+  ratelimit_pool = make_sub_pool(p);
+  pr_pool_tag(ratelimit_pool, "Explain rate limit pool");
+
+  ratelimit_rate_per_ms = (double) rate / (rate_secs * 1000.0);
+  ratelimit_burst = (double) burst;
+  ratelimit_sample = sample;
+  ratelimit_summary_ms = (uint64_t) summary_secs * 1000;
+  ratelimit_next_summary_ms = get_now_ms() + ratelimit_summary_ms;
+  ratelimit_enabled = TRUE;
+
+  pr_trace_msg(trace_channel, 9,
+    "limiting explanations to %u per %us (burst %u), sampling 1 in %u, "
+    "summarizing every %us", rate, rate_secs, burst, sample, summary_secs);
+  return 0;
+}
+
+void explain_ratelimit_free(void) {
+  if (ratelimit_pool != NULL) {
+    destroy_pool(ratelimit_pool);
+    ratelimit_pool = NULL;
+  }
+
+  memset(ratelimit_buckets, 0, sizeof(ratelimit_buckets));
+  ratelimit_enabled = FALSE;
+  ratelimit_npending = 0;
+  ratelimit_nadmitted = ratelimit_nsampled = ratelimit_nsuppressed = 0;
+}
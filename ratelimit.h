@@ -0,0 +1,68 @@
+/*
+ * ProFTPD - mod_explain: explanation rate limiting
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_RATELIMIT_H
+#define MOD_EXPLAIN_RATELIMIT_H
+
+#include "mod_explain.h"
+
+/* Rate limiting is off unless configured.  Defaults, for the parameters not
+ * given to ExplainRateLimit: a rate per second, in bursts of up to 20;
+ * beyond that, 1 in 100 failures are sampled, and the rest suppressed, with
+ * a summary of those logged every 10 seconds.
+ */
+#define EXPLAIN_RATELIMIT_DEFAULT_RATE_SECS	1
+#define EXPLAIN_RATELIMIT_DEFAULT_BURST		20
+#define EXPLAIN_RATELIMIT_DEFAULT_SAMPLE	100
+#define EXPLAIN_RATELIMIT_DEFAULT_SUMMARY_SECS	10
+
+/* Configures the limits: rate explanations per rate_secs, for each
+ * (syscall, errno), with bursts of up to burst explanations.  Once over
+ * that limit, every sample'th failure is still explained (zero for none).
+ * A rate of zero disables rate limiting.
+ */
+int explain_ratelimit_init(pool *p, unsigned int rate, unsigned int rate_secs,
+  unsigned int burst, unsigned int sample, unsigned int summary_secs);
+void explain_ratelimit_free(void);
+
+/* Returns TRUE if this failure should be explained, FALSE if its explanation
+ * should be suppressed.  Any summaries which have come due are logged.
+ */
+int explain_ratelimit_admit(pool *p, unsigned int syscall_id, int xerrno,
+  const char *path);
+
+/* Returns the summary lines, e.g. "1532 further write(2) errors (No space
+ * left on device) on /data suppressed in 10s", for those (syscall, errno)
+ * whose summary interval has elapsed, or for all of them, if forced; the
+ * counts summarized are then reset.
+ */
+array_header *explain_ratelimit_summarize(pool *p, int force);
+
+/* Returns the running totals of failures explained, sampled, and suppressed
+ * by the rate limits, for this process.
+ */
+void explain_ratelimit_get_counts(unsigned long *nadmitted,
+  unsigned long *nsampled, unsigned long *nsuppressed);
+
+#endif /* MOD_EXPLAIN_RATELIMIT_H */
@@ -34,7 +34,7 @@ static const char *get_args(pool *p, const char *path) {
 }
 
 const char *explain_stat_error(pool *p, int xerrno, const char *path,
-    struct stat *st, const char **args) {
+    struct stat *st, unsigned int verbosity, const char **args) {
   const char *explained = NULL, *syscall = "stat(2)";
   int path_flags = EXPLAIN_PATH_FL_WANT_SEARCH|EXPLAIN_PATH_FL_MUST_HAVE_MODE;
 
@@ -46,7 +46,8 @@ const char *explain_stat_error(pool *p, int xerrno, const char *path,
     case ELOOP:
     case ENAMETOOLONG:
     case EPERM:
-      explained = explain_path_error(p, xerrno, path, path_flags, S_IFREG);
+      explained = explain_path_describe(p, xerrno, syscall, path,
+        path_flags, S_IFREG, verbosity);
       break;
 
     default:
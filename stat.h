@@ -28,6 +28,6 @@
 #include "mod_explain.h"
 
 const char *explain_stat_error(pool *p, int xerrno, const char *path,
-  struct stat *st, const char **args);
+  struct stat *st, unsigned int verbosity, const char **args);
 
 #endif /* MOD_EXPLAIN_STAT_H */
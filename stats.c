@@ -0,0 +1,416 @@
+/*
+ * ProFTPD - mod_explain: explanation statistics
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#include "stats.h"
+#include "probe.h"
+#include "platform.h"
+
+#include <sys/mman.h>
+
+#if defined(HAVE___ATOMIC)
+# define stats_add(ptr, n) \
+    (void) __atomic_fetch_add((ptr), (n), __ATOMIC_RELAXED)
+# define stats_load(ptr)	__atomic_load_n((ptr), __ATOMIC_RELAXED)
+# define stats_store(ptr, n)	__atomic_store_n((ptr), (n), __ATOMIC_RELAXED)
+#else
+# define stats_add(ptr, n)	*(ptr) += (n)
+# define stats_load(ptr)	*(ptr)
+# define stats_store(ptr, n)	*(ptr) = (n)
+#endif /* HAVE___ATOMIC */
+
+/* Until a shared region is opened, the counters are process-local. */
+static struct explain_stats explain_local_stats;
+static struct explain_stats *explain_stats = &explain_local_stats;
+
+static struct explain_stats_region *stats_region = NULL;
+static char stats_path[PR_TUNABLE_PATH_MAX+1];
+
+/* State for the explanation in progress. */
+static struct timespec stats_start_ts;
+static unsigned long stats_start_nprobes = 0, stats_start_nsyscalls = 0;
+static unsigned long stats_last_usecs = 0;
+
+static const char *trace_channel = "explain.stats";
+
+static const char *syscall_names[EXPLAIN_SYSCALL_MAX] = {
+  "chmod(2)",
+  "chown(2)",
+  "chroot(2)",
+  "close(2)",
+  "fchmod(2)",
+  "fchown(2)",
+  "lchown(2)",
+  "lstat(2)",
+  "mkdir(2)",
+  "open(2)",
+  "read(2)",
+  "rename(2)",
+  "rmdir(2)",
+  "stat(2)",
+  "unlink(2)",
+  "write(2)"
+};
+
+const char *explain_stats_syscall_name(unsigned int syscall_id) {
+  if (syscall_id >= EXPLAIN_SYSCALL_MAX) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  return syscall_names[syscall_id];
+}
+
+static unsigned int get_bucket(uint64_t val, unsigned int nbuckets) {
+  unsigned int bucket = 0;
+
+  while (val > 0 &&
+         bucket < (nbuckets - 1)) {
+    val >>= 1;
+    bucket++;
+  }
+
+  return bucket;
+}
+
+static uint64_t get_elapsed_usecs(struct timespec *start) {
+  struct timespec now;
+  int64_t usecs;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
+    return 0;
+  }
+
+  usecs = ((int64_t) (now.tv_sec - start->tv_sec) * 1000000) +
+    ((now.tv_nsec - start->tv_nsec) / 1000);
+  return usecs > 0 ? (uint64_t) usecs : 0;
+}
+
+pool *explain_stats_scratch_pool(pool *p) {
+  pool *tmp_pool;
+
+  tmp_pool = pr_pool_create_sz(p, EXPLAIN_STATS_SCRATCH_POOL_SZ);
+  pr_pool_tag(tmp_pool, "Explain scratch pool");
+  return tmp_pool;
+}
+
+void explain_stats_begin(void) {
+  (void) clock_gettime(CLOCK_MONOTONIC, &stats_start_ts);
+  explain_probe_get_counts(&stats_start_nprobes, &stats_start_nsyscalls);
+}
+
+void explain_stats_end(unsigned int syscall_id, int xerrno,
+    const char *explained) {
+  uint64_t usecs;
+  unsigned long nprobes = 0, nsyscalls = 0;
+
+  if (syscall_id >= EXPLAIN_SYSCALL_MAX) {
+    return;
+  }
+
+  usecs = get_elapsed_usecs(&stats_start_ts);
+  stats_last_usecs = (unsigned long) usecs;
+  explain_probe_get_counts(&nprobes, &nsyscalls);
+  nprobes -= stats_start_nprobes;
+  nsyscalls -= stats_start_nsyscalls;
+
+  if (xerrno < 0 ||
+      xerrno >= EXPLAIN_STATS_MAX_ERRNO) {
+    xerrno = 0;
+  }
+
+  stats_add(&(explain_stats->explanations), 1);
+  if (explained == NULL) {
+    stats_add(&(explain_stats->unexplained), 1);
+  }
+
+  stats_add(&(explain_stats->total_usecs), usecs);
+  stats_add(&(explain_stats->probes), nprobes);
+  stats_add(&(explain_stats->probe_syscalls), nsyscalls);
+  stats_add(&(explain_stats->errnos[syscall_id][xerrno]), 1);
+  stats_add(&(explain_stats->latency[syscall_id][get_bucket(usecs,
+    EXPLAIN_STATS_LATENCY_BUCKETS)]), 1);
+  stats_add(&(explain_stats->probe_counts[get_bucket(nprobes,
+    EXPLAIN_STATS_PROBE_BUCKETS)]), 1);
+
+  pr_trace_msg(trace_channel, 19,
+    "%s %s explanation took %lu usecs, %lu probes (%lu syscalls)",
+    syscall_names[syscall_id], strerror(xerrno), (unsigned long) usecs,
+    nprobes, nsyscalls);
+}
+
+unsigned long explain_stats_get_last_usecs(void) {
+  return stats_last_usecs;
+}
+
+void explain_stats_suppressed(unsigned int syscall_id, int xerrno) {
+  if (syscall_id >= EXPLAIN_SYSCALL_MAX) {
+    return;
+  }
+
+  stats_add(&(explain_stats->suppressed), 1);
+  pr_trace_msg(trace_channel, 19, "%s %s explanation suppressed",
+    syscall_names[syscall_id], strerror(xerrno));
+}
+
+const struct explain_stats *explain_stats_get(void) {
+  return explain_stats;
+}
+
+void explain_stats_reset(void) {
+  register unsigned int i;
+  uint64_t *words;
+
+  /* Other processes may be updating the counters concurrently. */
+  words = (uint64_t *) explain_stats;
+  for (i = 0; i < sizeof(struct explain_stats) / sizeof(uint64_t); i++) {
+    stats_store(&(words[i]), 0);
+  }
+}
+
+int explain_stats_snapshot(struct explain_stats *stats) {
+  register unsigned int i;
+  uint64_t *src, *dst;
+
+  if (stats == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  src = (uint64_t *) explain_stats;
+  dst = (uint64_t *) stats;
+  for (i = 0; i < sizeof(struct explain_stats) / sizeof(uint64_t); i++) {
+    dst[i] = stats_load(&(src[i]));
+  }
+
+  return 0;
+}
+
+static const char *get_bucket_label(pool *p, unsigned int bucket,
+    unsigned int nbuckets) {
+  if (bucket == 0) {
+    return "0";
+  }
+
+  if (bucket == nbuckets - 1) {
+    return psprintf(p, ">=%llu", 1ULL << (bucket - 1));
+  }
+
+  return psprintf(p, "<%llu", 1ULL << bucket);
+}
+
+array_header *explain_stats_text(pool *p) {
+  register unsigned int i, j;
+  array_header *lines;
+  struct explain_stats stats;
+
+  if (p == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  explain_stats_snapshot(&stats);
+  lines = make_array(p, 1, sizeof(char *));
+
+  *((char **) push_array(lines)) = psprintf(p,
+    "explanations: %llu (%llu unexplained, %llu suppressed), %llu usecs, "
+    "%llu probes (%llu syscalls)",
+    (unsigned long long) stats.explanations,
+    (unsigned long long) stats.unexplained,
+    (unsigned long long) stats.suppressed,
+    (unsigned long long) stats.total_usecs,
+    (unsigned long long) stats.probes,
+    (unsigned long long) stats.probe_syscalls);
+
+  for (i = 0; i < EXPLAIN_SYSCALL_MAX; i++) {
+    char *latency = NULL;
+
+    for (j = 0; j < EXPLAIN_STATS_MAX_ERRNO; j++) {
+      if (stats.errnos[i][j] == 0) {
+        continue;
+      }
+
+      *((char **) push_array(lines)) = psprintf(p, "%s errno %u (%s): %llu",
+        syscall_names[i], j, j > 0 ? strerror(j) : "other",
+        (unsigned long long) stats.errnos[i][j]);
+    }
+
+    for (j = 0; j < EXPLAIN_STATS_LATENCY_BUCKETS; j++) {
+      if (stats.latency[i][j] == 0) {
+        continue;
+      }
+
+      latency = pstrcat(p, latency != NULL ? latency : "",
+        latency != NULL ? ", " : "",
+        get_bucket_label(p, j, EXPLAIN_STATS_LATENCY_BUCKETS), ": ",
+        psprintf(p, "%llu", (unsigned long long) stats.latency[i][j]),
+        NULL);
+    }
+
+    if (latency != NULL) {
+      *((char **) push_array(lines)) = pstrcat(p, syscall_names[i],
+        " latency (usecs): ", latency, NULL);
+    }
+  }
+
+  if (stats.explanations > 0) {
+    char *probes = NULL;
+
+    for (j = 0; j < EXPLAIN_STATS_PROBE_BUCKETS; j++) {
+      if (stats.probe_counts[j] == 0) {
+        continue;
+      }
+
+      probes = pstrcat(p, probes != NULL ? probes : "",
+        probes != NULL ? ", " : "",
+        get_bucket_label(p, j, EXPLAIN_STATS_PROBE_BUCKETS), ": ",
+        psprintf(p, "%llu", (unsigned long long) stats.probe_counts[j]),
+        NULL);
+    }
+
+    if (probes != NULL) {
+      *((char **) push_array(lines)) = pstrcat(p,
+        "probes per explanation: ", probes, NULL);
+    }
+  }
+
+  return lines;
+}
+
+int explain_stats_open(pool *p, const char *path) {
+  struct explain_stats_region *region;
+  size_t region_sz;
+  int fd = -1, flags = MAP_SHARED;
+
+  if (stats_region != NULL) {
+    if ((path == NULL && stats_path[0] == '\0') ||
+        (path != NULL && strcmp(path, stats_path) == 0)) {
+      /* Already open; keep the collected counters. */
+      return 0;
+    }
+
+    explain_stats_close();
+  }
+
+  region_sz = sizeof(struct explain_stats_region);
+
+  if (path != NULL) {
+    fd = explain_platform_open_file(path, O_RDWR, 0600);
+    if (fd < 0) {
+      int xerrno = errno;
+
+      pr_trace_msg(trace_channel, 1, "error opening ExplainStatsFile '%s': %s",
+        path, strerror(xerrno));
+
+      errno = xerrno;
+      return -1;
+    }
+
+    if (ftruncate(fd, region_sz) < 0) {
+      int xerrno = errno;
+
+      pr_trace_msg(trace_channel, 1, "error sizing ExplainStatsFile '%s': %s",
+        path, strerror(xerrno));
+      (void) close(fd);
+
+      errno = xerrno;
+      return -1;
+    }
+
+  } else {
+    flags |= MAP_ANONYMOUS;
+  }
+
+  region = mmap(NULL, region_sz, PROT_READ|PROT_WRITE, flags, fd, 0);
+  if (region == MAP_FAILED) {
+    int xerrno = errno;
+
+    pr_trace_msg(trace_channel, 1, "error mapping stats region: %s",
+      strerror(xerrno));
+    if (fd >= 0) {
+      (void) close(fd);
+    }
+
+    errno = xerrno;
+    return -1;
+  }
+
+  if (fd >= 0) {
+    (void) close(fd);
+  }
+
+  /* Readers check the magic last, so write the header after the counters. */
+  memcpy(&(region->stats), explain_stats, sizeof(struct explain_stats));
+  region->version = EXPLAIN_STATS_VERSION;
+  region->size = (uint32_t) region_sz;
+  region->pid = (uint32_t) getpid();
+  region->started = (uint64_t) time(NULL);
+  stats_store(&(region->magic), EXPLAIN_STATS_MAGIC);
+
+  stats_region = region;
+  explain_stats = &(region->stats);
+
+  if (path != NULL) {
+    sstrncpy(stats_path, path, sizeof(stats_path));
+
+  } else {
+    stats_path[0] = '\0';
+  }
+
+  pr_trace_msg(trace_channel, 9, "mapped %lu byte stats region%s%s",
+    (unsigned long) region_sz, path != NULL ? " from " : "",
+    path != NULL ? path : "");
+  return 0;
+}
+
+int explain_stats_close(void) {
+  if (stats_region == NULL) {
+    return 0;
+  }
+
+  /* Keep counting locally, starting from the shared values. */
+  explain_stats_snapshot(&explain_local_stats);
+  explain_stats = &explain_local_stats;
+
+  if (munmap(stats_region, sizeof(struct explain_stats_region)) < 0) {
+    pr_trace_msg(trace_channel, 3, "error unmapping stats region: %s",
+      strerror(errno));
+  }
+
+  stats_region = NULL;
+  stats_path[0] = '\0';
+  return 0;
+}
+
+int explain_stats_init(pool *p) {
+  (void) p;
+
+  explain_stats_reset();
+  return 0;
+}
+
+void explain_stats_free(pool *p) {
+  (void) p;
+
+  explain_stats_close();
+}
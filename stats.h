@@ -0,0 +1,119 @@
+/*
+ * ProFTPD - mod_explain: explanation statistics
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_STATS_H
+#define MOD_EXPLAIN_STATS_H
+
+#include "mod_explain.h"
+
+/* Errno values at or above this are counted in the zero bucket. */
+#define EXPLAIN_STATS_MAX_ERRNO			160
+
+/* Power-of-two histogram buckets: bucket N counts values in [2^(N-1), 2^N),
+ * with bucket zero counting zero values, and the last bucket counting
+ * everything larger.
+ */
+#define EXPLAIN_STATS_LATENCY_BUCKETS		24
+#define EXPLAIN_STATS_PROBE_BUCKETS		12
+
+struct explain_stats {
+  uint64_t explanations;
+  uint64_t unexplained;
+  uint64_t total_usecs;
+  uint64_t probes;
+  uint64_t probe_syscalls;
+
+  /* Explanations skipped under load. */
+  uint64_t suppressed;
+
+  /* Explanations, by (syscall, errno). */
+  uint64_t errnos[EXPLAIN_SYSCALL_MAX][EXPLAIN_STATS_MAX_ERRNO];
+
+  /* Explanation latency, in microseconds, by syscall. */
+  uint64_t latency[EXPLAIN_SYSCALL_MAX][EXPLAIN_STATS_LATENCY_BUCKETS];
+
+  /* Probes made per explanation. */
+  uint64_t probe_counts[EXPLAIN_STATS_PROBE_BUCKETS];
+};
+
+/* The shared statistics region has a fixed layout, so that external tools
+ * can map the ExplainStatsFile and read it, without locking.  All counters
+ * are updated atomically.
+ */
+#define EXPLAIN_STATS_MAGIC			0x45585354
+#define EXPLAIN_STATS_VERSION			4
+
+struct explain_stats_region {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  uint32_t pid;
+  uint64_t started;
+
+  struct explain_stats stats;
+};
+
+const char *explain_stats_syscall_name(unsigned int syscall_id);
+
+/* Explanations are made in a scratch pool, destroyed afterwards; its first
+ * block is sized to hold a typical explanation.
+ */
+#define EXPLAIN_STATS_SCRATCH_POOL_SZ		16384
+pool *explain_stats_scratch_pool(pool *p);
+
+/* Marks the start/end of an explanation for the given syscall and errno;
+ * the end records the counters, latency, and probes made.
+ */
+void explain_stats_begin(void);
+void explain_stats_end(unsigned int syscall_id, int xerrno,
+  const char *explained);
+
+/* Returns the time taken by the most recent explanation, in microseconds. */
+unsigned long explain_stats_get_last_usecs(void);
+
+/* Records an explanation skipped under load, i.e. by rate limiting, or
+ * while shedding explanations.
+ */
+void explain_stats_suppressed(unsigned int syscall_id, int xerrno);
+
+const struct explain_stats *explain_stats_get(void);
+void explain_stats_reset(void);
+
+/* Copies a consistent-enough snapshot of the counters, word by word. */
+int explain_stats_snapshot(struct explain_stats *stats);
+
+/* Moves the counters into a shared region, mapped from the given path, or
+ * anonymously if the path is NULL, so that they survive session exits.  The
+ * region must be opened in the daemon, before sessions are forked.
+ */
+int explain_stats_open(pool *p, const char *path);
+int explain_stats_close(void);
+
+/* Returns an array of text lines describing the collected statistics. */
+array_header *explain_stats_text(pool *p);
+
+int explain_stats_init(pool *p);
+void explain_stats_free(pool *p);
+
+#endif /* MOD_EXPLAIN_STATS_H */
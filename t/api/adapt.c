@@ -0,0 +1,153 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Adaptive verbosity API tests. */
+
+#include "tests.h"
+
+static pool *p = NULL;
+
+static void set_up(void) {
+  if (p == NULL) {
+    p = make_sub_pool(NULL);
+  }
+
+  tests_scoreboard_set_nentries(0);
+}
+
+static void tear_down(void) {
+  explain_adapt_free();
+  tests_scoreboard_set_nentries(0);
+
+  if (p) {
+    destroy_pool(p);
+    p = NULL;
+  }
+}
+
+START_TEST (adapt_params_test) {
+  int res;
+  unsigned int verbosity;
+
+  res = explain_adapt_init(NULL, 0, 0.0, 0);
+  ck_assert_msg(res < 0, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  /* Without adaptation, the configured verbosity is used. */
+  explain_adapt_record(1000000);
+  verbosity = explain_adapt_get_verbosity(PR_ERROR_FORMAT_USE_TERSE);
+  ck_assert_msg(verbosity == PR_ERROR_FORMAT_USE_TERSE,
+    "Expected terse verbosity, got %u", verbosity);
+}
+END_TEST
+
+START_TEST (adapt_latency_test) {
+  register unsigned int i;
+  int res;
+  unsigned int verbosity;
+
+  res = explain_adapt_init(p, 1000, 0.0, 0);
+  ck_assert_msg(res == 0, "Failed to init adaptation: %s", strerror(errno));
+
+  explain_adapt_record(100);
+  verbosity = explain_adapt_get_verbosity(PR_ERROR_FORMAT_USE_DETAILED);
+  ck_assert_msg(verbosity == PR_ERROR_FORMAT_USE_DETAILED,
+    "Expected detailed verbosity, got %u", verbosity);
+
+  /* Over the threshold, then over twice the threshold. */
+  for (i = 0; i < 10; i++) {
+    explain_adapt_record(1500);
+  }
+
+  verbosity = explain_adapt_get_verbosity(PR_ERROR_FORMAT_USE_DETAILED);
+  ck_assert_msg(verbosity == PR_ERROR_FORMAT_USE_TERSE,
+    "Expected terse verbosity, got %u", verbosity);
+
+  for (i = 0; i < 10; i++) {
+    explain_adapt_record(10000);
+  }
+
+  verbosity = explain_adapt_get_verbosity(PR_ERROR_FORMAT_USE_DETAILED);
+  ck_assert_msg(verbosity == PR_ERROR_FORMAT_USE_MINIMAL,
+    "Expected minimal verbosity, got %u", verbosity);
+
+  /* Just under twice the threshold is not enough to upgrade again... */
+  for (i = 0; i < 50; i++) {
+    explain_adapt_record(1900);
+  }
+
+  verbosity = explain_adapt_get_verbosity(PR_ERROR_FORMAT_USE_DETAILED);
+  ck_assert_msg(verbosity == PR_ERROR_FORMAT_USE_MINIMAL,
+    "Expected minimal verbosity, got %u", verbosity);
+
+  /* ...but well under the threshold is. */
+  for (i = 0; i < 50; i++) {
+    explain_adapt_record(100);
+  }
+
+  verbosity = explain_adapt_get_verbosity(PR_ERROR_FORMAT_USE_DETAILED);
+  ck_assert_msg(verbosity == PR_ERROR_FORMAT_USE_DETAILED,
+    "Expected detailed verbosity, got %u", verbosity);
+}
+END_TEST
+
+START_TEST (adapt_sessions_test) {
+  int res;
+  unsigned int verbosity;
+
+  tests_scoreboard_set_nentries(25);
+
+  /* Starting from terse, there is only one level to shed. */
+  res = explain_adapt_init(p, 0, 0.0, 10);
+  ck_assert_msg(res == 0, "Failed to init adaptation: %s", strerror(errno));
+
+  verbosity = explain_adapt_get_verbosity(PR_ERROR_FORMAT_USE_TERSE);
+  ck_assert_msg(verbosity == PR_ERROR_FORMAT_USE_MINIMAL,
+    "Expected minimal verbosity, got %u", verbosity);
+
+  /* The scoreboard is not read again for a while. */
+  tests_scoreboard_set_nentries(1);
+  verbosity = explain_adapt_get_verbosity(PR_ERROR_FORMAT_USE_TERSE);
+  ck_assert_msg(verbosity == PR_ERROR_FORMAT_USE_MINIMAL,
+    "Expected minimal verbosity, got %u", verbosity);
+}
+END_TEST
+
+Suite *tests_get_adapt_suite(void) {
+  Suite *suite;
+  TCase *testcase;
+
+  suite = suite_create("adapt");
+  testcase = tcase_create("base");
+
+  tcase_add_checked_fixture(testcase, set_up, tear_down);
+
+  tcase_add_test(testcase, adapt_params_test);
+  tcase_add_test(testcase, adapt_latency_test);
+  tcase_add_test(testcase, adapt_sessions_test);
+
+  suite_add_tcase(suite, testcase);
+  return suite;
+}
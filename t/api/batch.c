@@ -0,0 +1,192 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Batch API tests. */
+
+#include "tests.h"
+#include "batch.h"
+#include "path.h"
+#include "probe.h"
+#include "unlink.h"
+
+static pool *p = NULL;
+
+static const char *tree_root = "/tmp/explain-batch.d";
+
+/* Mount point for the in-memory filesystem. */
+static const char *fake_root = "/tmp/explain-batch.d/fake";
+
+#define BATCH_NFILES		100
+
+static void set_up(void) {
+  if (p == NULL) {
+    p = make_sub_pool(NULL);
+  }
+
+  init_fs();
+  (void) mkdir(tree_root, 0755);
+  (void) mkdir(fake_root, 0755);
+  explain_probe_init(p);
+}
+
+static void tear_down(void) {
+  tests_fakefs_unmount();
+  explain_path_reset_resume();
+  explain_probe_free(p);
+  (void) rmdir(fake_root);
+  (void) rmdir(tree_root);
+
+  if (p) {
+    destroy_pool(p);
+    p = NULL;
+  }
+}
+
+START_TEST (batch_params_test) {
+  int res;
+  struct explain_batch_entry entry;
+
+  res = explain_batch_explain(NULL, NULL, 0, 0);
+  ck_assert_msg(res < 0, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  res = explain_batch_explain(p, NULL, 0, 0);
+  ck_assert_msg(res < 0, "Failed to handle null entries");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  /* Only path-based syscalls are explained. */
+  memset(&entry, 0, sizeof(entry));
+  entry.syscall_id = EXPLAIN_SYSCALL_WRITE;
+  entry.xerrno = ENOSPC;
+  entry.path = "/tmp";
+
+  res = explain_batch_explain(p, &entry, 1, PR_ERROR_FORMAT_USE_DETAILED);
+  ck_assert_msg(res == 0, "Expected no explanations, got %d", res);
+  ck_assert_msg(entry.explained == NULL, "Expected no explanation, got '%s'",
+    entry.explained);
+}
+END_TEST
+
+START_TEST (batch_shared_prefix_test) {
+  register unsigned int i;
+  int res;
+  struct explain_batch_entry *entries;
+  const char *dir_path;
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  dir_path = pdircat(p, fake_root, "a", NULL);
+  tests_fakefs_add_dir(dir_path, 0755, 0, 0);
+  tests_fakefs_add_dir(pdircat(p, dir_path, "b", NULL), 0755, 0, 0);
+
+  /* Many failures, on sibling paths, in the same directories. */
+  entries = pcalloc(p, sizeof(struct explain_batch_entry) * BATCH_NFILES);
+  for (i = 0; i < BATCH_NFILES; i++) {
+    char name[32];
+
+    memset(name, '\0', sizeof(name));
+    snprintf(name, sizeof(name)-1, "b/file%u", i);
+
+    entries[i].syscall_id = EXPLAIN_SYSCALL_UNLINK;
+    entries[i].xerrno = ENOENT;
+    entries[i].path = pdircat(p, dir_path, name, NULL);
+  }
+
+  /* Each directory is probed once, and each missing file once. */
+  tests_fakefs_reset_nops();
+  res = explain_batch_explain(p, entries, BATCH_NFILES,
+    PR_ERROR_FORMAT_USE_DETAILED);
+  ck_assert_msg(res == BATCH_NFILES, "Expected %u explanations, got %d",
+    BATCH_NFILES, res);
+  ck_assert_msg(tests_fakefs_get_nops() == BATCH_NFILES + 3,
+    "Expected %u probes, got %u", BATCH_NFILES + 3, tests_fakefs_get_nops());
+
+  /* The explanations are those made one at a time. */
+  for (i = 0; i < BATCH_NFILES; i++) {
+    const char *args = NULL, *explained;
+
+    explained = explain_unlink_error(p, ENOENT, entries[i].path,
+      PR_ERROR_FORMAT_USE_DETAILED, &args);
+    ck_assert_msg(explained != NULL, "Failed to explain '%s'",
+      entries[i].path);
+    ck_assert_msg(strcmp(explained, entries[i].explained) == 0,
+      "Expected '%s', got '%s'", explained, entries[i].explained);
+    ck_assert_msg(strcmp(args, entries[i].args) == 0,
+      "Expected '%s', got '%s'", args, entries[i].args);
+  }
+}
+END_TEST
+
+START_TEST (batch_pruned_test) {
+  register unsigned int i;
+  int res;
+  struct explain_batch_entry entries[10];
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  /* Nothing beneath a missing directory is probed. */
+  for (i = 0; i < 10; i++) {
+    char name[32];
+
+    memset(name, '\0', sizeof(name));
+    snprintf(name, sizeof(name)-1, "missing/sub%u/file", i);
+
+    memset(&(entries[i]), 0, sizeof(struct explain_batch_entry));
+    entries[i].syscall_id = EXPLAIN_SYSCALL_STAT;
+    entries[i].xerrno = ENOENT;
+    entries[i].path = pdircat(p, fake_root, name, NULL);
+  }
+
+  tests_fakefs_reset_nops();
+  res = explain_batch_explain(p, entries, 10, PR_ERROR_FORMAT_USE_DETAILED);
+  ck_assert_msg(res == 10, "Expected 10 explanations, got %d", res);
+  ck_assert_msg(tests_fakefs_get_nops() == 2,
+    "Expected 2 probes, got %u", tests_fakefs_get_nops());
+  ck_assert_msg(strstr(entries[0].explained, "does not exist") != NULL,
+    "Expected missing directory, got '%s'", entries[0].explained);
+}
+END_TEST
+
+Suite *tests_get_batch_suite(void) {
+  Suite *suite;
+  TCase *testcase;
+
+  suite = suite_create("batch");
+  testcase = tcase_create("base");
+
+  tcase_add_checked_fixture(testcase, set_up, tear_down);
+
+  tcase_add_test(testcase, batch_params_test);
+  tcase_add_test(testcase, batch_shared_prefix_test);
+  tcase_add_test(testcase, batch_pruned_test);
+
+  suite_add_tcase(suite, testcase);
+  return suite;
+}
@@ -0,0 +1,237 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Cache API tests. */
+
+#include "tests.h"
+#include "path.h"
+#include "probe.h"
+
+static pool *p = NULL;
+
+/* Mount point for the in-memory filesystem. */
+static const char *fake_root = "/tmp/explain-cache.d";
+
+static void set_up(void) {
+  if (p == NULL) {
+    p = make_sub_pool(NULL);
+  }
+
+  init_fs();
+  (void) mkdir(fake_root, 0755);
+  explain_probe_init(p);
+  explain_cache_init(p, EXPLAIN_CACHE_DEFAULT_MAX_ENTRIES);
+
+  if (tests_fakefs_mount(p, fake_root, 0) == 0) {
+    tests_fakefs_add_dir(pdircat(p, fake_root, "a", NULL), 0755, 0, 0);
+    tests_fakefs_add_dir(pdircat(p, fake_root, "a/b", NULL), 0755, 0, 0);
+    tests_fakefs_add_file(pdircat(p, fake_root, "a/b/file", NULL), 0644, 0,
+      0);
+  }
+}
+
+static void tear_down(void) {
+  tests_fakefs_unmount();
+  explain_path_reset_resume();
+  explain_path_clear_failure();
+  explain_cache_free();
+  explain_probe_free(p);
+  (void) rmdir(fake_root);
+
+  if (p) {
+    destroy_pool(p);
+    p = NULL;
+  }
+}
+
+/* Explains the failure the way the explainers do: from the cache, if
+ * possible, otherwise by walking the path (and caching the result).
+ */
+static const char *explain_enoent(const char *path) {
+  const char *explained, *args = NULL;
+
+  explained = explain_cache_get(p, EXPLAIN_SYSCALL_STAT, ENOENT, path, &args);
+  if (explained == NULL) {
+    args = pstrcat(p, "path = '", path, "'", NULL);
+    explained = explain_path_error(p, ENOENT, path, 0, 0);
+    (void) explain_cache_add(p, EXPLAIN_SYSCALL_STAT, ENOENT, path, explained,
+      &args);
+  }
+
+  return explained;
+}
+
+START_TEST (cache_params_test) {
+  int res;
+  const char *explained;
+
+  explained = explain_cache_get(NULL, 0, 0, NULL, NULL);
+  ck_assert_msg(explained == NULL, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  res = explain_cache_add(p, 0, 0, "/foo", NULL, NULL);
+  ck_assert_msg(res < 0, "Failed to handle null explanation");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  /* Explanations which examined no path prefix are not cached. */
+  explain_path_clear_prefix();
+  res = explain_cache_add(p, 0, EIO, "/foo", "bar", NULL);
+  ck_assert_msg(res < 0, "Cached explanation without prefix unexpectedly");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  explain_cache_free();
+  explained = explain_cache_get(p, 0, 0, "/foo", NULL);
+  ck_assert_msg(explained == NULL, "Failed to handle missing cache");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+}
+END_TEST
+
+START_TEST (cache_hit_test) {
+  int idx, res;
+  unsigned int reason;
+  const char *explained, *expected, *failed, *path, *args = NULL;
+  unsigned long nhits = 0, nmisses = 0;
+
+  path = pdircat(p, fake_root, "a/b/missing", NULL);
+  expected = explain_enoent(path);
+  ck_assert_msg(expected != NULL, "Failed to explain ENOENT for '%s'", path);
+
+  /* The repeated failure is explained with a single probe. */
+  tests_fakefs_reset_nops();
+  explained = explain_cache_get(p, EXPLAIN_SYSCALL_STAT, ENOENT, path, &args);
+  ck_assert_msg(explained != NULL, "Failed to get cached explanation: %s",
+    strerror(errno));
+  ck_assert_msg(strcmp(explained, expected) == 0, "Expected '%s', got '%s'",
+    expected, explained);
+  ck_assert_msg(args != NULL, "Expected cached args");
+  ck_assert_msg(tests_fakefs_get_nops() == 1,
+    "Expected 1 probe, got %u", tests_fakefs_get_nops());
+
+  /* The failing component is that of the original explanation. */
+  res = explain_path_get_failure(&idx, &failed, &reason);
+  ck_assert_msg(res == 0, "Failed to get failure: %s", strerror(errno));
+  ck_assert_msg(reason == EXPLAIN_REASON_NO_SUCH_FILE,
+    "Expected missing file, got reason %u", reason);
+  ck_assert_msg(strcmp(failed, path) == 0, "Expected '%s', got '%s'", path,
+    failed);
+
+  /* Different errnos, and syscalls, are cached separately. */
+  explained = explain_cache_get(p, EXPLAIN_SYSCALL_LSTAT, ENOENT, path, NULL);
+  ck_assert_msg(explained == NULL, "Got cached explanation unexpectedly");
+  explained = explain_cache_get(p, EXPLAIN_SYSCALL_STAT, EACCES, path, NULL);
+  ck_assert_msg(explained == NULL, "Got cached explanation unexpectedly");
+
+  explain_cache_get_counts(&nhits, &nmisses, NULL);
+  ck_assert_msg(nhits == 1, "Expected 1 hit, got %lu", nhits);
+  ck_assert_msg(nmisses == 3, "Expected 3 misses, got %lu", nmisses);
+}
+END_TEST
+
+START_TEST (cache_invalidate_test) {
+  const char *explained, *path;
+
+  /* A missing directory is validated by its (existing) parent. */
+  path = pdircat(p, fake_root, "a/b/c/missing", NULL);
+  explained = explain_enoent(path);
+  ck_assert_msg(explained != NULL, "Failed to explain ENOENT for '%s'", path);
+  ck_assert_msg(strstr(explained, "/c'") != NULL,
+    "Expected missing directory, got '%s'", explained);
+
+  explained = explain_cache_get(p, EXPLAIN_SYSCALL_STAT, ENOENT, path, NULL);
+  ck_assert_msg(explained != NULL, "Failed to get cached explanation: %s",
+    strerror(errno));
+
+  /* Creating the directory changes its parent, and so the explanation. */
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a/b/c", NULL), 0755, 0, 0);
+
+  explained = explain_cache_get(p, EXPLAIN_SYSCALL_STAT, ENOENT, path, NULL);
+  ck_assert_msg(explained == NULL, "Got stale cached explanation");
+
+  explained = explain_enoent(path);
+  ck_assert_msg(explained != NULL, "Failed to explain ENOENT for '%s'", path);
+  ck_assert_msg(strstr(explained, "/missing'") != NULL,
+    "Expected missing file, got '%s'", explained);
+
+  /* Any change to the validating prefix invalidates it. */
+  tests_fakefs_touch(pdircat(p, fake_root, "a/b/c", NULL));
+  explained = explain_cache_get(p, EXPLAIN_SYSCALL_STAT, ENOENT, path, NULL);
+  ck_assert_msg(explained == NULL, "Got stale cached explanation");
+}
+END_TEST
+
+START_TEST (cache_evict_test) {
+  register unsigned int i;
+  const char *explained, *path;
+  unsigned long nevictions = 0;
+
+  explain_cache_init(p, 2);
+
+  for (i = 0; i < 3; i++) {
+    path = pdircat(p, fake_root, psprintf(p, "a/b/missing%u", i), NULL);
+    explained = explain_enoent(path);
+    ck_assert_msg(explained != NULL, "Failed to explain ENOENT for '%s'",
+      path);
+
+    /* Keep the first entry recently used. */
+    path = pdircat(p, fake_root, "a/b/missing0", NULL);
+    explained = explain_cache_get(p, EXPLAIN_SYSCALL_STAT, ENOENT, path, NULL);
+    ck_assert_msg(explained != NULL, "Failed to get cached explanation: %s",
+      strerror(errno));
+  }
+
+  explain_cache_get_counts(NULL, NULL, &nevictions);
+  ck_assert_msg(nevictions == 1, "Expected 1 eviction, got %lu", nevictions);
+
+  path = pdircat(p, fake_root, "a/b/missing1", NULL);
+  explained = explain_cache_get(p, EXPLAIN_SYSCALL_STAT, ENOENT, path, NULL);
+  ck_assert_msg(explained == NULL, "Got evicted explanation unexpectedly");
+
+  path = pdircat(p, fake_root, "a/b/missing2", NULL);
+  explained = explain_cache_get(p, EXPLAIN_SYSCALL_STAT, ENOENT, path, NULL);
+  ck_assert_msg(explained != NULL, "Failed to get cached explanation: %s",
+    strerror(errno));
+}
+END_TEST
+
+Suite *tests_get_cache_suite(void) {
+  Suite *suite;
+  TCase *testcase;
+
+  suite = suite_create("cache");
+  testcase = tcase_create("base");
+
+  tcase_add_checked_fixture(testcase, set_up, tear_down);
+
+  tcase_add_test(testcase, cache_params_test);
+  tcase_add_test(testcase, cache_hit_test);
+  tcase_add_test(testcase, cache_invalidate_test);
+  tcase_add_test(testcase, cache_evict_test);
+
+  suite_add_tcase(suite, testcase);
+  return suite;
+}
@@ -0,0 +1,287 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Capabilities API tests. */
+
+#include "tests.h"
+#include "unlink.h"
+
+static pool *p = NULL;
+
+/* CapEff lacks CAP_SYS_CHROOT (bit 18), but CapPrm has it. */
+static const char *status_text =
+  "Name:\tproftpd\n"
+  "Uid:\t0\t0\t0\t0\n"
+  "CapInh:\t0000000000000000\n"
+  "CapPrm:\t00000000a80425fb\n"
+  "CapEff:\t00000000a80025fb\n"
+  "CapBnd:\t00000000a80425fb\n"
+  "NoNewPrivs:\t1\n"
+  "Seccomp:\t2\n";
+
+/* Neither CapEff nor CapPrm has CAP_SYS_CHROOT. */
+static const char *status_nochroot_text =
+  "Name:\tproftpd\n"
+  "Uid:\t0\t0\t0\t0\n"
+  "CapInh:\t0000000000000000\n"
+  "CapPrm:\t00000000a80025fb\n"
+  "CapEff:\t0000000000000000\n"
+  "CapBnd:\t00000000a80025fb\n"
+  "NoNewPrivs:\t1\n"
+  "Seccomp:\t1\n";
+
+/* CapPrm lacks CAP_FOWNER (bit 3). */
+static const char *status_nofowner_text =
+  "Name:\tproftpd\n"
+  "Uid:\t0\t0\t0\t0\n"
+  "CapInh:\t0000000000000000\n"
+  "CapPrm:\t00000000a80425f3\n"
+  "CapEff:\t0000000000000000\n"
+  "CapBnd:\t00000000a80425fb\n"
+  "NoNewPrivs:\t0\n"
+  "Seccomp:\t0\n";
+
+static const char *sticky_dir = "/tmp/explain-caps.d";
+static const char *sticky_file = "/tmp/explain-caps.d/file";
+
+static void set_up(void) {
+  if (p == NULL) {
+    p = make_sub_pool(NULL);
+  }
+}
+
+static void tear_down(void) {
+  explain_caps_free(p);
+
+  (void) unlink(sticky_file);
+  (void) rmdir(sticky_dir);
+
+  if (p) {
+    destroy_pool(p);
+    p = NULL;
+  }
+}
+
+START_TEST (caps_parse_status_test) {
+  int res;
+
+  res = explain_caps_parse_status(NULL, 0);
+  ck_assert_msg(res < 0, "Failed to handle null text");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  res = explain_caps_parse_status("Name:\tfoo\n", 10);
+  ck_assert_msg(res < 0, "Failed to handle missing CapEff");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  res = explain_caps_have_effective(EXPLAIN_CAP_SYS_CHROOT);
+  ck_assert_msg(res < 0, "Failed to handle missing snapshot");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  res = explain_caps_parse_status(status_text, strlen(status_text));
+  ck_assert_msg(res == 0, "Failed to parse status text: %s", strerror(errno));
+
+  res = explain_caps_have_effective(EXPLAIN_CAP_SYS_CHROOT);
+  ck_assert_msg(res == FALSE, "Expected FALSE, got %d", res);
+
+  res = explain_caps_have_permitted(EXPLAIN_CAP_SYS_CHROOT);
+  ck_assert_msg(res == TRUE, "Expected TRUE, got %d", res);
+
+  res = explain_caps_have_effective(EXPLAIN_CAP_FOWNER);
+  ck_assert_msg(res == TRUE, "Expected TRUE, got %d", res);
+
+  res = explain_caps_seccomp_mode();
+  ck_assert_msg(res == EXPLAIN_SECCOMP_MODE_FILTER, "Expected %d, got %d",
+    EXPLAIN_SECCOMP_MODE_FILTER, res);
+
+  res = explain_caps_no_new_privs();
+  ck_assert_msg(res == TRUE, "Expected TRUE, got %d", res);
+}
+END_TEST
+
+START_TEST (caps_describe_eperm_test) {
+  const char *desc, *expected;
+  int res;
+
+  desc = explain_caps_describe_eperm(NULL, NULL, 0);
+  ck_assert_msg(desc == NULL, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  desc = explain_caps_describe_eperm(p, "chroot(2)", EXPLAIN_CAP_SYS_CHROOT);
+  ck_assert_msg(desc == NULL, "Failed to handle missing snapshot");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  res = explain_caps_parse_status(status_text, strlen(status_text));
+  ck_assert_msg(res == 0, "Failed to parse status text: %s", strerror(errno));
+
+  /* The capability is permitted, and so will be effective as root. */
+  desc = explain_caps_describe_eperm(p, "chroot(2)", EXPLAIN_CAP_SYS_CHROOT);
+  ck_assert_msg(desc == NULL, "Expected no description, got '%s'", desc);
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  /* A seccomp filter does not, by itself, explain an EPERM. */
+  desc = explain_caps_describe_eperm(p, "unlink(2)", EXPLAIN_CAP_FOWNER);
+  ck_assert_msg(desc == NULL, "Expected no description, got '%s'", desc);
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  res = explain_caps_parse_status(status_nochroot_text,
+    strlen(status_nochroot_text));
+  ck_assert_msg(res == 0, "Failed to parse status text: %s", strerror(errno));
+
+  desc = explain_caps_describe_eperm(p, "chroot(2)", EXPLAIN_CAP_SYS_CHROOT);
+  ck_assert_msg(desc != NULL, "Failed to describe EPERM: %s", strerror(errno));
+  expected = "the process lacks the CAP_SYS_CHROOT capability required for the chroot(2) system call, and cannot regain it since no_new_privs is set";
+  ck_assert_msg(strcmp(desc, expected) == 0,
+    "Expected '%s', got '%s'", expected, desc);
+
+  desc = explain_caps_describe_eperm(p, "unlink(2)", EXPLAIN_CAP_FOWNER);
+  ck_assert_msg(desc != NULL, "Failed to describe EPERM: %s", strerror(errno));
+  expected = "the process is in strict seccomp mode, which does not allow the unlink(2) system call";
+  ck_assert_msg(strcmp(desc, expected) == 0,
+    "Expected '%s', got '%s'", expected, desc);
+}
+END_TEST
+
+START_TEST (caps_expire_test) {
+  const char *desc;
+  int res;
+
+  /* Expiring a missing snapshot does not conjure one up. */
+  explain_caps_expire();
+  res = explain_caps_seccomp_mode();
+  ck_assert_msg(res < 0, "Expected no snapshot, got seccomp mode %d", res);
+
+  res = explain_caps_parse_status(status_nochroot_text,
+    strlen(status_nochroot_text));
+  ck_assert_msg(res == 0, "Failed to parse status text: %s", strerror(errno));
+
+  res = explain_caps_seccomp_mode();
+  ck_assert_msg(res == EXPLAIN_SECCOMP_MODE_STRICT, "Expected %d, got %d",
+    EXPLAIN_SECCOMP_MODE_STRICT, res);
+
+  /* Once expired, the snapshot is re-read from our own status (or dropped,
+   * if that cannot be read); we are not in strict seccomp mode.
+   */
+  explain_caps_expire();
+  desc = explain_caps_describe_eperm(p, "chroot(2)", EXPLAIN_CAP_SYS_CHROOT);
+  (void) desc;
+
+  res = explain_caps_seccomp_mode();
+  ck_assert_msg(res != EXPLAIN_SECCOMP_MODE_STRICT,
+    "Expected refreshed seccomp mode, got %d", res);
+}
+END_TEST
+
+START_TEST (caps_unlink_sticky_test) {
+  const char *desc, *expected, *args = NULL;
+  int fd, res;
+
+  if (geteuid() != PR_ROOT_UID) {
+    return;
+  }
+
+  res = mkdir(sticky_dir, 0777);
+  ck_assert_msg(res == 0, "Failed to create '%s': %s", sticky_dir,
+    strerror(errno));
+  res = chmod(sticky_dir, 01777);
+  ck_assert_msg(res == 0, "Failed to chmod '%s': %s", sticky_dir,
+    strerror(errno));
+
+  fd = open(sticky_file, O_CREAT|O_WRONLY, 0644);
+  ck_assert_msg(fd >= 0, "Failed to create '%s': %s", sticky_file,
+    strerror(errno));
+  (void) close(fd);
+
+  res = chown(sticky_dir, 1, 1);
+  ck_assert_msg(res == 0, "Failed to chown '%s': %s", sticky_dir,
+    strerror(errno));
+  res = chown(sticky_file, 2, 2);
+  ck_assert_msg(res == 0, "Failed to chown '%s': %s", sticky_file,
+    strerror(errno));
+
+  /* With CAP_FOWNER permitted, the sticky bit does not explain the EPERM. */
+  res = explain_caps_parse_status(status_text, strlen(status_text));
+  ck_assert_msg(res == 0, "Failed to parse status text: %s", strerror(errno));
+
+  desc = explain_unlink_error(p, EPERM, sticky_file,
+    PR_ERROR_FORMAT_USE_DETAILED, &args);
+  ck_assert_msg(desc == NULL || strstr(desc, "sticky") == NULL,
+    "Expected no sticky bit explanation, got '%s'", desc);
+
+  res = explain_caps_parse_status(status_nofowner_text,
+    strlen(status_nofowner_text));
+  ck_assert_msg(res == 0, "Failed to parse status text: %s", strerror(errno));
+
+  desc = explain_unlink_error(p, EPERM, sticky_file,
+    PR_ERROR_FORMAT_USE_DETAILED, &args);
+  ck_assert_msg(desc != NULL, "Failed to explain EPERM: %s", strerror(errno));
+  expected = "directory '/tmp/explain-caps.d' has the sticky bit set, and neither the directory nor '/tmp/explain-caps.d/file' is owned by the process, and the process lacks the CAP_FOWNER capability required for the unlink(2) system call";
+  ck_assert_msg(strcmp(desc, expected) == 0,
+    "Expected '%s', got '%s'", expected, desc);
+}
+END_TEST
+
+START_TEST (caps_init_test) {
+  int res;
+
+  res = explain_caps_init(p);
+  if (res < 0) {
+    ck_assert_msg(errno == ENOSYS || errno == ENOENT || errno == EACCES,
+      "Unexpected error snapshotting capabilities: %s (%d)", strerror(errno),
+      errno);
+
+  } else {
+    res = explain_caps_have_effective(EXPLAIN_CAP_FOWNER);
+    ck_assert_msg(res == TRUE || res == FALSE, "Expected TRUE/FALSE, got %d",
+      res);
+  }
+
+  explain_caps_free(p);
+}
+END_TEST
+
+Suite *tests_get_caps_suite(void) {
+  Suite *suite;
+  TCase *testcase;
+
+  suite = suite_create("caps");
+  testcase = tcase_create("base");
+
+  tcase_add_checked_fixture(testcase, set_up, tear_down);
+
+  tcase_add_test(testcase, caps_parse_status_test);
+  tcase_add_test(testcase, caps_describe_eperm_test);
+  tcase_add_test(testcase, caps_expire_test);
+  tcase_add_test(testcase, caps_unlink_sticky_test);
+  tcase_add_test(testcase, caps_init_test);
+
+  suite_add_tcase(suite, testcase);
+  return suite;
+}
@@ -0,0 +1,484 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+
+/* In-memory FSIO backend, for deterministic (and fast) path walks.
+ *
+ * Nodes are kept in a hash table, keyed by their full path.  Lookups walk
+ * each component in turn, following symlinks, and checking search
+ * permission on each directory for the configured identity; thus EACCES
+ * states can be reproduced even when the tests run as root.
+ *
+ * The mount point itself should exist on disk, since FSIO may resolve it via
+ * the parent filesystem.
+ */
+
+#include "tests.h"
+
+struct fakefs_node {
+  mode_t mode;
+  uid_t uid;
+  gid_t gid;
+  ino_t ino;
+
+  /* Bumped whenever the node, or (for directories) its entries, change. */
+  time_t ctime;
+
+  /* For symlinks. */
+  const char *target;
+
+  /* Injected error, returned for any lookup through this node. */
+  int xerrno;
+};
+
+/* Maximum number of symlinks followed in a single lookup. */
+#define FAKEFS_MAX_SYMLINKS	8
+
+static pool *fakefs_pool = NULL;
+static pr_table_t *fakefs_nodes = NULL;
+static const char *fakefs_path = NULL;
+static ino_t fakefs_next_ino = 1;
+static time_t fakefs_ctime = 0;
+
+static uid_t fakefs_uid = (uid_t) -1;
+static gid_t fakefs_gid = (gid_t) -1;
+static unsigned long fakefs_latency_usecs = 0;
+static unsigned int fakefs_nops = 0;
+
+static int fakefs_lookup(pool *p, const char *path, int follow, int depth,
+  struct fakefs_node **res, const char **res_path);
+
+static struct fakefs_node *fakefs_get_node(const char *path) {
+  const void *v;
+
+  v = pr_table_get(fakefs_nodes, path, NULL);
+  return (struct fakefs_node *) v;
+}
+
+static int fakefs_can_search(struct fakefs_node *node) {
+  mode_t mask;
+
+  if (fakefs_uid == (uid_t) -1 ||
+      fakefs_uid == 0) {
+    return TRUE;
+  }
+
+  if (node->uid == fakefs_uid) {
+    mask = S_IXUSR;
+
+  } else if (node->gid == fakefs_gid) {
+    mask = S_IXGRP;
+
+  } else {
+    mask = S_IXOTH;
+  }
+
+  return (node->mode & mask) ? TRUE : FALSE;
+}
+
+/* Resolves a symlink target, relative to the directory containing the
+ * link, into a full path.
+ */
+static const char *fakefs_link_path(pool *p, const char *dir_path,
+    const char *target) {
+  if (*target == '/') {
+    return target;
+  }
+
+  return pdircat(p, dir_path, target, NULL);
+}
+
+static int fakefs_lookup(pool *p, const char *path, int follow, int depth,
+    struct fakefs_node **res, const char **res_path) {
+  const char *dir_path, *ptr;
+  struct fakefs_node *dir;
+
+  if (depth > FAKEFS_MAX_SYMLINKS) {
+    errno = ELOOP;
+    return -1;
+  }
+
+  if (strncmp(path, fakefs_path, strlen(fakefs_path)) != 0) {
+    /* Symlinks out of the fake filesystem are not supported. */
+    errno = ENOENT;
+    return -1;
+  }
+
+  dir_path = fakefs_path;
+  dir = fakefs_get_node(dir_path);
+  ptr = path + strlen(fakefs_path);
+
+  while (*ptr != '\0') {
+    const char *next_path, *end;
+    struct fakefs_node *node;
+    size_t len;
+    int final;
+
+    while (*ptr == '/') {
+      ptr++;
+    }
+
+    if (*ptr == '\0') {
+      break;
+    }
+
+    end = strchr(ptr, '/');
+    len = (end != NULL ? (size_t) (end - ptr) : strlen(ptr));
+
+    final = TRUE;
+    if (end != NULL) {
+      const char *rest;
+
+      for (rest = end; *rest == '/'; rest++);
+      if (*rest != '\0') {
+        final = FALSE;
+      }
+    }
+
+    if (dir->xerrno != 0) {
+      errno = dir->xerrno;
+      return -1;
+    }
+
+    if (!S_ISDIR(dir->mode)) {
+      errno = ENOTDIR;
+      return -1;
+    }
+
+    if (fakefs_can_search(dir) == FALSE) {
+      errno = EACCES;
+      return -1;
+    }
+
+    next_path = pdircat(p, dir_path, pstrndup(p, ptr, len), NULL);
+    node = fakefs_get_node(next_path);
+    if (node == NULL) {
+      errno = ENOENT;
+      return -1;
+    }
+
+    if (S_ISLNK(node->mode) &&
+        (final == FALSE || follow == TRUE)) {
+      if (fakefs_lookup(p, fakefs_link_path(p, dir_path, node->target),
+          TRUE, depth + 1, &node, &next_path) < 0) {
+        return -1;
+      }
+    }
+
+    dir_path = next_path;
+    dir = node;
+    ptr += len;
+  }
+
+  if (dir->xerrno != 0) {
+    errno = dir->xerrno;
+    return -1;
+  }
+
+  *res = dir;
+  if (res_path != NULL) {
+    *res_path = dir_path;
+  }
+
+  return 0;
+}
+
+static int fakefs_op(pr_fs_t *fs, const char *path, struct stat *st,
+    int follow) {
+  pool *tmp_pool;
+  struct fakefs_node *node = NULL;
+  int res, xerrno;
+
+  (void) fs;
+
+  fakefs_nops++;
+
+  if (fakefs_latency_usecs > 0) {
+    struct timespec ts;
+
+    ts.tv_sec = fakefs_latency_usecs / 1000000;
+    ts.tv_nsec = (fakefs_latency_usecs % 1000000) * 1000;
+    (void) nanosleep(&ts, NULL);
+  }
+
+  tmp_pool = make_sub_pool(fakefs_pool);
+  res = fakefs_lookup(tmp_pool, path, follow, 0, &node, NULL);
+  xerrno = errno;
+  destroy_pool(tmp_pool);
+
+  if (res < 0) {
+    errno = xerrno;
+    return -1;
+  }
+
+  memset(st, 0, sizeof(struct stat));
+  st->st_mode = node->mode;
+  st->st_uid = node->uid;
+  st->st_gid = node->gid;
+  st->st_ino = node->ino;
+  st->st_ctime = node->ctime;
+  st->st_nlink = 1;
+  return 0;
+}
+
+static int fakefs_lstat(pr_fs_t *fs, const char *path, struct stat *st) {
+  return fakefs_op(fs, path, st, FALSE);
+}
+
+static int fakefs_stat(pr_fs_t *fs, const char *path, struct stat *st) {
+  return fakefs_op(fs, path, st, TRUE);
+}
+
+static struct fakefs_node *fakefs_add_node(const char *path, mode_t mode,
+    uid_t uid, gid_t gid) {
+  struct fakefs_node *node;
+
+  if (fakefs_nodes == NULL) {
+    errno = EPERM;
+    return NULL;
+  }
+
+  if (path == NULL ||
+      strncmp(path, fakefs_path, strlen(fakefs_path)) != 0) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  if (fakefs_get_node(path) != NULL) {
+    errno = EEXIST;
+    return NULL;
+  }
+
+  /* The parent directory must already exist. */
+  if (strcmp(path, fakefs_path) != 0) {
+    char parent[PR_TUNABLE_PATH_MAX+1], *ptr;
+    struct fakefs_node *dir;
+
+    sstrncpy(parent, path, sizeof(parent));
+    ptr = strrchr(parent, '/');
+    if (ptr == parent) {
+      ptr++;
+    }
+    *ptr = '\0';
+
+    dir = fakefs_get_node(parent);
+    if (dir == NULL) {
+      errno = ENOENT;
+      return NULL;
+    }
+
+    if (!S_ISDIR(dir->mode)) {
+      errno = ENOTDIR;
+      return NULL;
+    }
+
+    dir->ctime++;
+  }
+
+  node = pcalloc(fakefs_pool, sizeof(struct fakefs_node));
+  node->mode = mode;
+  node->uid = uid;
+  node->gid = gid;
+  node->ino = fakefs_next_ino++;
+  node->ctime = fakefs_ctime;
+
+  if (pr_table_add(fakefs_nodes, pstrdup(fakefs_pool, path), node,
+      sizeof(struct fakefs_node)) < 0) {
+    return NULL;
+  }
+
+  return node;
+}
+
+int tests_fakefs_add_dir(const char *path, mode_t mode, uid_t uid,
+    gid_t gid) {
+  if (fakefs_add_node(path, S_IFDIR|(mode & 07777), uid, gid) == NULL) {
+    return -1;
+  }
+
+  return 0;
+}
+
+int tests_fakefs_add_file(const char *path, mode_t mode, uid_t uid,
+    gid_t gid) {
+  if (fakefs_add_node(path, S_IFREG|(mode & 07777), uid, gid) == NULL) {
+    return -1;
+  }
+
+  return 0;
+}
+
+int tests_fakefs_add_symlink(const char *path, const char *target) {
+  struct fakefs_node *node;
+
+  if (target == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  node = fakefs_add_node(path, S_IFLNK|0777, 0, 0);
+  if (node == NULL) {
+    return -1;
+  }
+
+  node->target = pstrdup(fakefs_pool, target);
+  return 0;
+}
+
+int tests_fakefs_set_errno(const char *path, int xerrno) {
+  struct fakefs_node *node;
+
+  if (fakefs_nodes == NULL) {
+    errno = EPERM;
+    return -1;
+  }
+
+  node = fakefs_get_node(path);
+  if (node == NULL) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  node->xerrno = xerrno;
+  pr_fs_statcache_reset();
+  return 0;
+}
+
+int tests_fakefs_touch(const char *path) {
+  struct fakefs_node *node;
+
+  if (fakefs_nodes == NULL) {
+    errno = EPERM;
+    return -1;
+  }
+
+  node = fakefs_get_node(path);
+  if (node == NULL) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  node->ctime++;
+  pr_fs_statcache_reset();
+  return 0;
+}
+
+void tests_fakefs_set_latency(unsigned long usecs) {
+  fakefs_latency_usecs = usecs;
+}
+
+void tests_fakefs_set_user(uid_t uid, gid_t gid) {
+  fakefs_uid = uid;
+  fakefs_gid = gid;
+  pr_fs_statcache_reset();
+}
+
+unsigned int tests_fakefs_get_nops(void) {
+  return fakefs_nops;
+}
+
+void tests_fakefs_reset_nops(void) {
+  fakefs_nops = 0;
+}
+
+int tests_fakefs_mount(pool *p, const char *path, unsigned int nnodes) {
+  pr_fs_t *fs;
+  unsigned int max_ents, nchains;
+
+  if (p == NULL ||
+      path == NULL ||
+      *path != '/') {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (fakefs_nodes != NULL) {
+    errno = EEXIST;
+    return -1;
+  }
+
+  fakefs_pool = make_sub_pool(p);
+  pr_pool_tag(fakefs_pool, "Fake FSIO pool");
+
+  /* Keep the hash chains short, even at 100k nodes. */
+  nchains = nnodes > 0 ? (nnodes / 4) + 1 : 32;
+  fakefs_nodes = pr_table_nalloc(fakefs_pool, 0, nchains);
+
+  max_ents = nnodes > 0 ? nnodes + 1 : 8192;
+  (void) pr_table_ctl(fakefs_nodes, PR_TABLE_CTL_SET_MAX_ENTS, &max_ents);
+
+  fakefs_path = pstrdup(fakefs_pool, path);
+  fakefs_next_ino = 1;
+  fakefs_nops = 0;
+
+  /* Node ctimes start well in the past, and are bumped on every change. */
+  fakefs_ctime = time(NULL) - 3600;
+  fakefs_uid = (uid_t) -1;
+  fakefs_gid = (gid_t) -1;
+  fakefs_latency_usecs = 0;
+
+  if (tests_fakefs_add_dir(path, 0755, 0, 0) < 0) {
+    int xerrno = errno;
+
+    destroy_pool(fakefs_pool);
+    fakefs_pool = NULL;
+    fakefs_nodes = NULL;
+
+    errno = xerrno;
+    return -1;
+  }
+
+  fs = pr_register_fs(fakefs_pool, "fakefs", path);
+  if (fs == NULL) {
+    int xerrno = errno;
+
+    destroy_pool(fakefs_pool);
+    fakefs_pool = NULL;
+    fakefs_nodes = NULL;
+
+    errno = xerrno;
+    return -1;
+  }
+
+  fs->lstat = fakefs_lstat;
+  fs->stat = fakefs_stat;
+
+  pr_fs_statcache_reset();
+  return 0;
+}
+
+int tests_fakefs_unmount(void) {
+  if (fakefs_nodes == NULL) {
+    return 0;
+  }
+
+  (void) pr_unregister_fs(fakefs_path);
+  pr_fs_statcache_reset();
+
+  destroy_pool(fakefs_pool);
+  fakefs_pool = NULL;
+  fakefs_nodes = NULL;
+  fakefs_path = NULL;
+  return 0;
+}
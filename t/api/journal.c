@@ -0,0 +1,308 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Journal API tests. */
+
+#include "tests.h"
+#include "journal.h"
+
+#include <sys/mman.h>
+
+static pool *p = NULL;
+
+static const char *journal_dir = "/tmp/explain-journal.d";
+static const char *journal_path = "/tmp/explain-journal.d/journal.dat";
+
+static void set_up(void) {
+  if (p == NULL) {
+    p = make_sub_pool(NULL);
+  }
+
+  (void) unlink(journal_path);
+  (void) rmdir(journal_dir);
+  (void) mkdir(journal_dir, 0755);
+}
+
+static void tear_down(void) {
+  (void) explain_journal_close();
+  (void) unlink(journal_path);
+  (void) rmdir(journal_dir);
+
+  if (p) {
+    destroy_pool(p);
+    p = NULL;
+  }
+}
+
+struct journal_entries {
+  unsigned int count;
+  struct explain_journal_entry entries[8];
+};
+
+static int collect_entry(const struct explain_journal_entry *entry,
+    void *user_data) {
+  struct journal_entries *collected;
+
+  collected = user_data;
+  if (collected->count < 8) {
+    memcpy(&(collected->entries[collected->count]), entry,
+      sizeof(struct explain_journal_entry));
+  }
+
+  collected->count++;
+  return 0;
+}
+
+static int read_journal(struct journal_entries *collected) {
+  int fd, res;
+  struct stat st;
+  void *region;
+
+  memset(collected, 0, sizeof(struct journal_entries));
+
+  fd = open(journal_path, O_RDONLY);
+  ck_assert_msg(fd >= 0, "Failed to open '%s': %s", journal_path,
+    strerror(errno));
+  ck_assert_msg(fstat(fd, &st) == 0, "Failed to stat '%s': %s", journal_path,
+    strerror(errno));
+
+  region = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ck_assert_msg(region != MAP_FAILED, "Failed to map '%s': %s", journal_path,
+    strerror(errno));
+  (void) close(fd);
+
+  res = explain_journal_read(region, st.st_size, collect_entry, collected);
+  (void) munmap(region, st.st_size);
+  return res;
+}
+
+START_TEST (journal_params_test) {
+  int res;
+  char buf[EXPLAIN_JOURNAL_MIN_SIZE];
+
+  res = explain_journal_open(p, NULL, 0);
+  ck_assert_msg(res < 0, "Failed to handle null path");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  res = explain_journal_open(p, journal_path, EXPLAIN_JOURNAL_MIN_SIZE - 1);
+  ck_assert_msg(res < 0, "Failed to handle too-small size");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  ck_assert_msg(explain_journal_enabled() == FALSE,
+    "Expected journal to be disabled");
+  res = explain_journal_append(EXPLAIN_SYSCALL_STAT, ENOENT, "/foo", 1,
+    EXPLAIN_REASON_NO_SUCH_FILE, 0);
+  ck_assert_msg(res < 0, "Failed to handle closed journal");
+  ck_assert_msg(errno == EPERM, "Expected EPERM (%d), got %s (%d)", EPERM,
+    strerror(errno), errno);
+
+  res = explain_journal_read(NULL, 0, NULL, NULL);
+  ck_assert_msg(res < 0, "Failed to handle null region");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  memset(buf, 0, sizeof(buf));
+  res = explain_journal_read(buf, sizeof(buf), collect_entry, NULL);
+  ck_assert_msg(res < 0, "Failed to handle region without journal");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+}
+END_TEST
+
+START_TEST (journal_append_test) {
+  int res;
+  struct journal_entries collected;
+  const struct explain_journal_entry *entry;
+  struct stat st;
+
+  res = explain_journal_open(p, journal_path, 0);
+  ck_assert_msg(res == 0, "Failed to open journal: %s", strerror(errno));
+  ck_assert_msg(explain_journal_enabled() == TRUE,
+    "Expected journal to be enabled");
+
+  ck_assert_msg(stat(journal_path, &st) == 0, "Failed to stat '%s': %s",
+    journal_path, strerror(errno));
+  ck_assert_msg((st.st_mode & 07777) == 0600, "Expected mode 0600, got %04o",
+    (unsigned int) (st.st_mode & 07777));
+
+  res = explain_journal_append(EXPLAIN_SYSCALL_STAT, ENOENT, "/foo/bar", 2,
+    EXPLAIN_REASON_NO_SUCH_FILE, 42);
+  ck_assert_msg(res == 0, "Failed to append: %s", strerror(errno));
+
+  res = explain_journal_append(EXPLAIN_SYSCALL_UNLINK, EACCES, "/baz", 0,
+    EXPLAIN_REASON_DIR_NOT_WRITABLE, 7);
+  ck_assert_msg(res == 0, "Failed to append: %s", strerror(errno));
+
+  res = read_journal(&collected);
+  ck_assert_msg(res == 2, "Expected 2 records, got %d", res);
+
+  entry = &(collected.entries[0]);
+  ck_assert_msg(entry->seq == 0, "Expected seq 0, got %lu",
+    (unsigned long) entry->seq);
+  ck_assert_msg(entry->record.syscall_id == EXPLAIN_SYSCALL_STAT,
+    "Expected stat(2), got %u", entry->record.syscall_id);
+  ck_assert_msg(entry->record.xerrno == ENOENT, "Expected ENOENT, got %d",
+    entry->record.xerrno);
+  ck_assert_msg(entry->record.reason == EXPLAIN_REASON_NO_SUCH_FILE,
+    "Expected missing file, got reason %u", entry->record.reason);
+  ck_assert_msg(entry->record.component_idx == 2,
+    "Expected component #2, got %d", entry->record.component_idx);
+  ck_assert_msg(entry->record.usecs == 42, "Expected 42 usecs, got %u",
+    entry->record.usecs);
+  ck_assert_msg(strcmp(entry->path, "/foo/bar") == 0,
+    "Expected '/foo/bar', got '%s'", entry->path);
+
+  entry = &(collected.entries[1]);
+  ck_assert_msg(entry->seq == 1, "Expected seq 1, got %lu",
+    (unsigned long) entry->seq);
+  ck_assert_msg(strcmp(entry->path, "/baz") == 0,
+    "Expected '/baz', got '%s'", entry->path);
+
+  /* Reopening continues the same journal. */
+  (void) explain_journal_close();
+  res = explain_journal_open(p, journal_path, 0);
+  ck_assert_msg(res == 0, "Failed to reopen journal: %s", strerror(errno));
+
+  res = explain_journal_append(EXPLAIN_SYSCALL_LSTAT, ENOTDIR, "/qux", 1,
+    EXPLAIN_REASON_NOT_DIR, 0);
+  ck_assert_msg(res == 0, "Failed to append: %s", strerror(errno));
+
+  res = read_journal(&collected);
+  ck_assert_msg(res == 3, "Expected 3 records, got %d", res);
+  ck_assert_msg(strcmp(collected.entries[2].path, "/qux") == 0,
+    "Expected '/qux', got '%s'", collected.entries[2].path);
+}
+END_TEST
+
+START_TEST (journal_wrap_test) {
+  register unsigned int i;
+  int res;
+  char *long_path;
+  struct journal_entries collected;
+
+  res = explain_journal_open(p, journal_path, EXPLAIN_JOURNAL_MIN_SIZE);
+  ck_assert_msg(res == 0, "Failed to open journal: %s", strerror(errno));
+
+  /* Only the most recent records are kept. */
+  for (i = 0; i < 1000; i++) {
+    res = explain_journal_append(EXPLAIN_SYSCALL_STAT, ENOENT, "/a/b", 1,
+      EXPLAIN_REASON_NO_SUCH_DIR, i);
+    ck_assert_msg(res == 0, "Failed to append: %s", strerror(errno));
+  }
+
+  res = read_journal(&collected);
+  ck_assert_msg(res > 0 && res < 1000, "Expected wrapped journal, got %d",
+    res);
+  ck_assert_msg(collected.entries[0].seq == (uint64_t) (1000 - res),
+    "Expected oldest seq %d, got %lu", 1000 - res,
+    (unsigned long) collected.entries[0].seq);
+  ck_assert_msg(strcmp(collected.entries[0].path, "/a/b") == 0,
+    "Expected '/a/b', got '%s'", collected.entries[0].path);
+
+  /* Long paths overwrite the paths of older records, which are then read
+   * without their paths.
+   */
+  long_path = pcalloc(p, EXPLAIN_JOURNAL_MIN_SIZE);
+  memset(long_path, 'x', EXPLAIN_JOURNAL_MIN_SIZE - 1);
+  long_path[0] = '/';
+
+  for (i = 0; i < 3; i++) {
+    res = explain_journal_append(EXPLAIN_SYSCALL_STAT, ENAMETOOLONG,
+      long_path, 1, EXPLAIN_REASON_NAME_TOO_LONG, 0);
+    ck_assert_msg(res == 0, "Failed to append: %s", strerror(errno));
+  }
+
+  res = read_journal(&collected);
+  ck_assert_msg(collected.entries[0].path[0] == '\0',
+    "Expected overwritten path, got '%s'", collected.entries[0].path);
+}
+END_TEST
+
+START_TEST (journal_chroot_test) {
+  int res;
+  struct journal_entries collected;
+
+  res = explain_journal_open(p, journal_path, 0);
+  ck_assert_msg(res == 0, "Failed to open journal: %s", strerror(errno));
+
+  /* Paths are recorded as seen from outside the session's chroot. */
+  session.chroot_path = "/srv/ftp";
+  res = explain_journal_append(EXPLAIN_SYSCALL_STAT, ENOENT, "/upload/file",
+    2, EXPLAIN_REASON_NO_SUCH_FILE, 0);
+  ck_assert_msg(res == 0, "Failed to append: %s", strerror(errno));
+
+  /* Relative paths are resolved against the working directory, first. */
+  res = pr_fs_setcwd("/tmp");
+  ck_assert_msg(res == 0, "Failed to set cwd: %s", strerror(errno));
+  res = explain_journal_append(EXPLAIN_SYSCALL_UNLINK, EACCES, "file", 2,
+    EXPLAIN_REASON_DIR_NOT_WRITABLE, 0);
+  ck_assert_msg(res == 0, "Failed to append: %s", strerror(errno));
+  session.chroot_path = NULL;
+
+  res = read_journal(&collected);
+  ck_assert_msg(res == 2, "Expected 2 records, got %d", res);
+  ck_assert_msg(strcmp(collected.entries[0].path,
+    "/srv/ftp/upload/file") == 0, "Expected '/srv/ftp/upload/file', got '%s'",
+    collected.entries[0].path);
+  ck_assert_msg(strcmp(collected.entries[1].path, "/srv/ftp/tmp/file") == 0,
+    "Expected '/srv/ftp/tmp/file', got '%s'", collected.entries[1].path);
+}
+END_TEST
+
+START_TEST (journal_open_unsafe_test) {
+  int res;
+
+  /* Journals in world-writable directories are refused, as for log files. */
+  ck_assert_msg(chmod(journal_dir, 0777) == 0, "Failed to chmod '%s': %s",
+    journal_dir, strerror(errno));
+
+  res = explain_journal_open(p, journal_path, 0);
+  ck_assert_msg(res < 0, "Failed to handle world-writable directory");
+  ck_assert_msg(errno == EPERM, "Expected EPERM (%d), got %s (%d)", EPERM,
+    strerror(errno), errno);
+  ck_assert_msg(explain_journal_enabled() == FALSE,
+    "Expected journal to be disabled");
+}
+END_TEST
+
+Suite *tests_get_journal_suite(void) {
+  Suite *suite;
+  TCase *testcase;
+
+  suite = suite_create("journal");
+  testcase = tcase_create("base");
+
+  tcase_add_checked_fixture(testcase, set_up, tear_down);
+
+  tcase_add_test(testcase, journal_params_test);
+  tcase_add_test(testcase, journal_append_test);
+  tcase_add_test(testcase, journal_wrap_test);
+  tcase_add_test(testcase, journal_chroot_test);
+  tcase_add_test(testcase, journal_open_unsafe_test);
+
+  suite_add_tcase(suite, testcase);
+  return suite;
+}
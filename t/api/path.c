@@ -26,16 +26,95 @@
 
 #include "tests.h"
 #include "path.h"
+#include "platform.h"
+#include "probe.h"
 
 static pool *p = NULL;
 
+/* A tree of nested directories, such that the paths below have ten
+ * components (counting the root): /tmp/explain-path.d/c1/.../c6/<leaf>.
+ */
+static const char *tree_root = "/tmp/explain-path.d";
+static const char *tree_dirs[] = {
+  "/tmp/explain-path.d",
+  "/tmp/explain-path.d/c1",
+  "/tmp/explain-path.d/c1/c2",
+  "/tmp/explain-path.d/c1/c2/c3",
+  "/tmp/explain-path.d/c1/c2/c3/c4",
+  "/tmp/explain-path.d/c1/c2/c3/c4/c5",
+  "/tmp/explain-path.d/c1/c2/c3/c4/c5/c6",
+  "/tmp/explain-path.d/fake",
+  NULL
+};
+static const char *tree_file = "/tmp/explain-path.d/c1/c2/c3/c4/c5/c6/file";
+
+/* Missing leaf */
+static const char *tree_enoent_leaf =
+  "/tmp/explain-path.d/c1/c2/c3/c4/c5/c6/missing";
+
+/* Missing seventh component */
+static const char *tree_enoent_dir =
+  "/tmp/explain-path.d/c1/c2/c3/missing/c5/c6/file";
+
+/* File used as a directory, at the final parent */
+static const char *tree_enotdir = "/tmp/explain-path.d/c1/c2/c3/c4/c5/file/x";
+
+#define TREE_NCOMPONENTS	10
+
+/* Mount point for the in-memory filesystem. */
+static const char *fake_root = "/tmp/explain-path.d/fake";
+
+static void tree_create(void) {
+  register unsigned int i;
+  int fd;
+
+  for (i = 0; tree_dirs[i] != NULL; i++) {
+    (void) mkdir(tree_dirs[i], 0755);
+  }
+
+  fd = open(tree_file, O_WRONLY|O_CREAT, 0644);
+  if (fd >= 0) {
+    (void) close(fd);
+  }
+
+  fd = open("/tmp/explain-path.d/c1/c2/c3/c4/c5/file", O_WRONLY|O_CREAT, 0644);
+  if (fd >= 0) {
+    (void) close(fd);
+  }
+}
+
+static void tree_remove(void) {
+  register int i;
+
+  (void) unlink(tree_file);
+  (void) unlink("/tmp/explain-path.d/c1/c2/c3/c4/c5/file");
+
+  for (i = (sizeof(tree_dirs) / sizeof(char *)) - 2; i >= 0; i--) {
+    (void) rmdir(tree_dirs[i]);
+  }
+
+  (void) rmdir(tree_root);
+}
+
 static void set_up(void) {
   if (p == NULL) {
     p = make_sub_pool(NULL);
   }
+
+  init_fs();
+  tree_create();
+  explain_probe_init(p);
 }
 
 static void tear_down(void) {
+  tests_fakefs_unmount();
+  tests_fsio_shims_disable();
+  explain_path_set_budget(0);
+  explain_path_reset_resume();
+  explain_path_clear_failure();
+  explain_probe_free(p);
+  tree_remove();
+
   if (p) {
     destroy_pool(p);
     p = NULL;
@@ -57,6 +136,512 @@ START_TEST (path_error_params_test) {
 }
 END_TEST
 
+/* These bounds lock in the number of probes made by each walk strategy, so
+ * that refactoring cannot silently reintroduce e.g. quadratic walks.
+ */
+
+START_TEST (path_error_fsio_probe_count_test) {
+  int res;
+  const char *desc;
+  const struct tests_fsio_counts *counts;
+
+  res = tests_fsio_shims_enable();
+  ck_assert_msg(res == 0, "Failed to enable FSIO shims: %s", strerror(errno));
+  counts = tests_fsio_get_counts();
+
+  /* Via FSIO, each component is probed at most once. */
+  desc = explain_path_error(p, ENOENT, tree_enoent_leaf, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'",
+    tree_enoent_leaf);
+  ck_assert_msg(counts->lstat <= TREE_NCOMPONENTS,
+    "Expected at most %u lstat(2) probes, got %u", TREE_NCOMPONENTS,
+    counts->lstat);
+  ck_assert_msg(counts->stat == 0, "Expected no stat(2) probes, got %u",
+    counts->stat);
+
+  /* The walk stops at the first missing component. */
+  tests_fsio_reset_counts();
+  desc = explain_path_error(p, ENOENT, tree_enoent_dir, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'",
+    tree_enoent_dir);
+  ck_assert_msg(counts->lstat <= 7, "Expected at most 7 lstat(2) probes, got %u",
+    counts->lstat);
+
+  tests_fsio_reset_counts();
+  desc = explain_path_error(p, ENOTDIR, tree_enotdir, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain ENOTDIR for '%s'",
+    tree_enotdir);
+  ck_assert_msg(counts->lstat <= TREE_NCOMPONENTS - 1,
+    "Expected at most %u lstat(2) probes, got %u", TREE_NCOMPONENTS - 1,
+    counts->lstat);
+
+  /* EACCES on the leaf also probes its parent directory, once more. */
+  tests_fsio_reset_counts();
+  desc = explain_path_error(p, EACCES, tree_file, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", tree_file);
+  ck_assert_msg(counts->lstat <= TREE_NCOMPONENTS + 1,
+    "Expected at most %u lstat(2) probes, got %u", TREE_NCOMPONENTS + 1,
+    counts->lstat);
+
+  tests_fsio_shims_disable();
+}
+END_TEST
+
+START_TEST (path_error_probe_count_test) {
+  const char *desc;
+  unsigned long flags, nprobes, nsyscalls, start_nprobes, start_nsyscalls;
+
+  flags = explain_probe_get_flags();
+
+  if (flags & EXPLAIN_PROBE_FL_USE_OPENAT2) {
+    /* Classifying a missing leaf needs only the parent, and the leaf. */
+    explain_probe_get_counts(&start_nprobes, &start_nsyscalls);
+    desc = explain_path_error(p, ENOENT, tree_enoent_leaf, 0, 0);
+    ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'",
+      tree_enoent_leaf);
+    explain_probe_get_counts(&nprobes, &nsyscalls);
+    ck_assert_msg(nprobes - start_nprobes <= 2,
+      "Expected at most 2 probes, got %lu", nprobes - start_nprobes);
+
+    /* A missing directory is found by binary search. */
+    explain_probe_get_counts(&start_nprobes, &start_nsyscalls);
+    desc = explain_path_error(p, ENOENT, tree_enoent_dir, 0, 0);
+    ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'",
+      tree_enoent_dir);
+    explain_probe_get_counts(&nprobes, &nsyscalls);
+    ck_assert_msg(nprobes - start_nprobes <= 5,
+      "Expected at most 5 probes, got %lu", nprobes - start_nprobes);
+  }
+
+  if (flags & EXPLAIN_PROBE_FL_USE_IO_URING) {
+    /* With batching, the whole walk costs a single io_uring_enter(2). */
+    explain_probe_set_flags(flags & ~EXPLAIN_PROBE_FL_USE_OPENAT2);
+
+    explain_probe_get_counts(&start_nprobes, &start_nsyscalls);
+    desc = explain_path_error(p, ENOENT, tree_enoent_leaf, 0, 0);
+    ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'",
+      tree_enoent_leaf);
+    explain_probe_get_counts(&nprobes, &nsyscalls);
+    ck_assert_msg(nprobes - start_nprobes <= TREE_NCOMPONENTS,
+      "Expected at most %u probes, got %lu", TREE_NCOMPONENTS,
+      nprobes - start_nprobes);
+    ck_assert_msg(nsyscalls - start_nsyscalls <= 1,
+      "Expected at most 1 syscall, got %lu", nsyscalls - start_nsyscalls);
+  }
+
+  /* Serially, each component is probed at most once. */
+  explain_probe_set_flags(0);
+
+  explain_probe_get_counts(&start_nprobes, &start_nsyscalls);
+  desc = explain_path_error(p, ENOENT, tree_enoent_leaf, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'",
+    tree_enoent_leaf);
+  explain_probe_get_counts(&nprobes, &nsyscalls);
+  ck_assert_msg(nprobes - start_nprobes <= TREE_NCOMPONENTS,
+    "Expected at most %u probes, got %lu", TREE_NCOMPONENTS,
+    nprobes - start_nprobes);
+  ck_assert_msg(nsyscalls - start_nsyscalls <= TREE_NCOMPONENTS,
+    "Expected at most %u syscalls, got %lu", TREE_NCOMPONENTS,
+    nsyscalls - start_nsyscalls);
+
+  explain_probe_set_flags(flags);
+}
+END_TEST
+
+START_TEST (path_error_home_check_test) {
+  int res;
+  const char *desc;
+  unsigned long nprobes, nsyscalls, start_nprobes, start_nsyscalls;
+
+  res = explain_probe_check_home(p);
+  ck_assert_msg(res < 0, "Failed to handle missing home handle");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  /* Only a home directory on the system filesystem gets a handle. */
+  res = explain_platform_set_home(p, fake_root);
+  ck_assert_msg(res < 0, "Failed to handle home on fake filesystem");
+  ck_assert_msg(errno == ENOSYS, "Expected ENOSYS (%d), got %s (%d)", ENOSYS,
+    strerror(errno), errno);
+
+  res = explain_platform_set_home(p, tree_dirs[3]);
+  ck_assert_msg(res == 0, "Failed to set home '%s': %s", tree_dirs[3],
+    strerror(errno));
+
+  /* The home directory is checked once, and counted as a probe. */
+  explain_probe_get_counts(&start_nprobes, &start_nsyscalls);
+  res = explain_probe_check_home(p);
+  ck_assert_msg(res == 0, "Failed to check home: %s", strerror(errno));
+  explain_probe_get_counts(&nprobes, &nsyscalls);
+  ck_assert_msg(nprobes - start_nprobes == 1, "Expected 1 probe, got %lu",
+    nprobes - start_nprobes);
+
+  explain_probe_get_counts(&start_nprobes, &start_nsyscalls);
+  desc = explain_path_error(p, ENOENT, tree_enoent_leaf, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'",
+    tree_enoent_leaf);
+  res = explain_probe_check_home(p);
+  ck_assert_msg(res == 0, "Failed to check home: %s", strerror(errno));
+  explain_probe_get_counts(&nprobes, &nsyscalls);
+  ck_assert_msg(nprobes - start_nprobes <= TREE_NCOMPONENTS,
+    "Expected at most %u probes, got %lu", TREE_NCOMPONENTS,
+    nprobes - start_nprobes);
+
+  /* Once unchecked, e.g. by the next command, it is checked again. */
+  explain_platform_uncheck_home();
+  explain_probe_get_counts(&start_nprobes, &start_nsyscalls);
+  res = explain_probe_check_home(p);
+  ck_assert_msg(res == 0, "Failed to check home: %s", strerror(errno));
+  explain_probe_get_counts(&nprobes, &nsyscalls);
+  ck_assert_msg(nprobes - start_nprobes == 1, "Expected 1 probe, got %lu",
+    nprobes - start_nprobes);
+
+  explain_platform_free(p);
+}
+END_TEST
+
+START_TEST (path_error_fakefs_eacces_test) {
+  int res;
+  const char *desc, *path;
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a", NULL), 0700, 0, 0);
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a/b", NULL), 0755, 0, 0);
+  path = pdircat(p, fake_root, "a/b/file", NULL);
+  tests_fakefs_add_file(path, 0644, 0, 0);
+
+  /* The tests may run as root, but the fake filesystem can still deny
+   * search permission.
+   */
+  tests_fakefs_set_user(1000, 1000);
+
+  desc = explain_path_error(p, EACCES, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path);
+  ck_assert_msg(strstr(desc, "not searchable") != NULL,
+    "Expected unsearchable directory, got '%s'", desc);
+
+  /* Injected errors are reported as such, i.e. not explained. */
+  tests_fakefs_set_user(0, 0);
+  res = tests_fakefs_set_errno(pdircat(p, fake_root, "a/b", NULL), EIO);
+  ck_assert_msg(res == 0, "Failed to inject EIO: %s", strerror(errno));
+
+  desc = explain_path_error(p, ENOENT, pdircat(p, path, "missing", NULL),
+    0, 0);
+  ck_assert_msg(desc == NULL, "Expected unexplained EIO, got '%s'", desc);
+}
+END_TEST
+
+START_TEST (path_error_fakefs_symlink_test) {
+  int res;
+  const char *desc, *path;
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a", NULL), 0755, 0, 0);
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a/b", NULL), 0755, 0, 0);
+  tests_fakefs_add_symlink(pdircat(p, fake_root, "link", NULL), "a");
+
+  path = pdircat(p, fake_root, "link/b/missing", NULL);
+  desc = explain_path_error(p, ENOENT, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'", path);
+  ck_assert_msg(strstr(desc, "file '") != NULL,
+    "Expected missing file, got '%s'", desc);
+
+  /* A dangling symlink, used as a directory. */
+  tests_fakefs_add_symlink(pdircat(p, fake_root, "dangling", NULL), "nope");
+
+  path = pdircat(p, fake_root, "dangling/missing", NULL);
+  desc = explain_path_error(p, ENOENT, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'", path);
+  ck_assert_msg(strstr(desc, "does not exist") != NULL,
+    "Expected missing file, got '%s'", desc);
+}
+END_TEST
+
+START_TEST (path_error_terse_test) {
+  int res;
+  const char *desc, *path;
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a", NULL), 0755, 0, 0);
+  path = pdircat(p, fake_root, "a/file", NULL);
+  tests_fakefs_add_file(path, 0600, 0, 0);
+
+  desc = explain_path_error(p, EACCES, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path);
+  ck_assert_msg(strstr(desc, "parent directory") != NULL,
+    "Expected parent directory details, got '%s'", desc);
+
+  /* Terse explanations skip looking up the parent directory; the full path
+   * is walked again, rather than resumed.
+   */
+  explain_path_reset_resume();
+  tests_fakefs_reset_nops();
+  desc = explain_path_error(p, EACCES, path, EXPLAIN_PATH_FL_TERSE, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path);
+  ck_assert_msg(strstr(desc, "parent directory") == NULL,
+    "Expected no parent directory details, got '%s'", desc);
+  ck_assert_msg(tests_fakefs_get_nops() == 3,
+    "Expected 3 probes, got %u", tests_fakefs_get_nops());
+}
+END_TEST
+
+START_TEST (path_error_budget_test) {
+  int res;
+  const char *desc, *path;
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a", NULL), 0755, 0, 0);
+  path = pdircat(p, fake_root, "a/file", NULL);
+  tests_fakefs_add_file(path, 0600, 0, 0);
+
+  /* Paths deeper than the budget are not walked at all. */
+  explain_path_set_budget(2);
+  tests_fakefs_reset_nops();
+  desc = explain_path_error(p, EACCES, path, 0, 0);
+  ck_assert_msg(desc == NULL, "Expected no explanation, got '%s'", desc);
+  ck_assert_msg(errno == EAGAIN, "Expected EAGAIN (%d), got %s (%d)", EAGAIN,
+    strerror(errno), errno);
+  ck_assert_msg(tests_fakefs_get_nops() == 0,
+    "Expected no probes, got %u", tests_fakefs_get_nops());
+
+  explain_path_set_budget(0);
+  desc = explain_path_error(p, EACCES, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path);
+}
+END_TEST
+
+START_TEST (path_error_resume_test) {
+  int res;
+  const char *desc, *path, *path2, *path3;
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a", NULL), 0755, 0, 0);
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a/b", NULL), 0755, 0, 0);
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a/b/c", NULL), 0755, 0, 0);
+  path = pdircat(p, fake_root, "a/b/c/file", NULL);
+  tests_fakefs_add_file(path, 0600, 0, 0);
+  path2 = pdircat(p, fake_root, "a/b/c/file2", NULL);
+  tests_fakefs_add_file(path2, 0600, 0, 0);
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a/b/d", NULL), 0755, 0, 0);
+  path3 = pdircat(p, fake_root, "a/b/d/file", NULL);
+  tests_fakefs_add_file(path3, 0600, 0, 0);
+
+  desc = explain_path_error(p, EACCES, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path);
+
+  /* The next failure in the same directory only probes that directory,
+   * and the final component.
+   */
+  tests_fakefs_reset_nops();
+  desc = explain_path_error(p, EACCES, path2, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path2);
+  ck_assert_msg(tests_fakefs_get_nops() == 2,
+    "Expected 2 probes, got %u", tests_fakefs_get_nops());
+
+  /* A failure in a sibling directory resumes from their common parent. */
+  tests_fakefs_reset_nops();
+  desc = explain_path_error(p, EACCES, path3, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path3);
+  ck_assert_msg(tests_fakefs_get_nops() == 3,
+    "Expected 3 probes, got %u", tests_fakefs_get_nops());
+
+  /* Nor for a different effective UID, which may not search the same
+   * directories.
+   */
+  if (getuid() == PR_ROOT_UID &&
+      seteuid(1000) == 0) {
+    tests_fakefs_reset_nops();
+    desc = explain_path_error(p, EACCES, path3, 0, 0);
+    (void) seteuid(PR_ROOT_UID);
+    ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path3);
+    ck_assert_msg(tests_fakefs_get_nops() > 3,
+      "Expected full walk, got %u probes", tests_fakefs_get_nops());
+  }
+
+  /* Nothing is resumed once forgotten. */
+  explain_path_reset_resume();
+  tests_fakefs_reset_nops();
+  desc = explain_path_error(p, EACCES, path2, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path2);
+  ck_assert_msg(tests_fakefs_get_nops() > 2,
+    "Expected full walk, got %u probes", tests_fakefs_get_nops());
+}
+END_TEST
+
+START_TEST (path_error_failure_test) {
+  int idx, res;
+  unsigned int nprefixes, reason;
+  const char *desc, *dir, *subdir, *failed, *path;
+
+  res = explain_path_get_failure(NULL, NULL, NULL);
+  ck_assert_msg(res < 0, "Failed to handle null arguments");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  dir = pdircat(p, fake_root, "a", NULL);
+  tests_fakefs_add_dir(dir, 0700, 0, 0);
+  subdir = pdircat(p, dir, "b", NULL);
+  tests_fakefs_add_dir(subdir, 0755, 0, 0);
+  path = pdircat(p, subdir, "file", NULL);
+  tests_fakefs_add_file(path, 0644, 0, 0);
+  (void) explain_path_get_prefixes(p, path, &nprefixes);
+
+  /* The directory whose lookup was denied is the failing component. */
+  tests_fakefs_set_user(1000, 1000);
+  desc = explain_path_error(p, EACCES, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path);
+
+  res = explain_path_get_failure(&idx, &failed, &reason);
+  ck_assert_msg(res == 0, "Failed to get failure: %s", strerror(errno));
+  ck_assert_msg(reason == EXPLAIN_REASON_DIR_NOT_SEARCHABLE,
+    "Expected unsearchable directory, got reason %u", reason);
+  ck_assert_msg(idx == (int) nprefixes - 2, "Expected index %u, got %d",
+    nprefixes - 2, idx);
+  ck_assert_msg(strcmp(failed, subdir) == 0, "Expected '%s', got '%s'",
+    subdir, failed);
+
+  /* Otherwise, the directory which cannot be written. */
+  tests_fakefs_set_user(0, 0);
+  explain_path_reset_resume();
+  desc = explain_path_error(p, EACCES, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path);
+
+  res = explain_path_get_failure(&idx, &failed, &reason);
+  ck_assert_msg(res == 0, "Failed to get failure: %s", strerror(errno));
+  ck_assert_msg(reason == EXPLAIN_REASON_DIR_NOT_WRITABLE,
+    "Expected unwritable directory, got reason %u", reason);
+  ck_assert_msg(idx == (int) nprefixes - 2, "Expected index %u, got %d",
+    nprefixes - 2, idx);
+  ck_assert_msg(strcmp(failed, subdir) == 0, "Expected '%s', got '%s'",
+    subdir, failed);
+
+  /* A missing file is the failing component itself. */
+  path = pdircat(p, subdir, "missing", NULL);
+  desc = explain_path_error(p, ENOENT, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'", path);
+
+  res = explain_path_get_failure(&idx, &failed, &reason);
+  ck_assert_msg(res == 0, "Failed to get failure: %s", strerror(errno));
+  ck_assert_msg(reason == EXPLAIN_REASON_NO_SUCH_FILE,
+    "Expected missing file, got reason %u", reason);
+  ck_assert_msg(idx == (int) nprefixes - 1, "Expected index %u, got %d",
+    nprefixes - 1, idx);
+  ck_assert_msg(strcmp(failed, path) == 0, "Expected '%s', got '%s'", path,
+    failed);
+
+  explain_path_clear_failure();
+  res = explain_path_get_failure(&idx, &failed, &reason);
+  ck_assert_msg(res < 0, "Failed to clear failure");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+}
+END_TEST
+
+START_TEST (path_prewarm_test) {
+  int res;
+  const char *desc, *path;
+
+  res = explain_path_prewarm(NULL, NULL);
+  ck_assert_msg(res < 0, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  res = tests_fakefs_mount(p, fake_root, 0);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  tests_fakefs_add_dir(pdircat(p, fake_root, "a", NULL), 0755, 0, 0);
+  path = pdircat(p, fake_root, "a/file", NULL);
+  tests_fakefs_add_file(path, 0600, 0, 0);
+
+  /* Every directory in the chain is probed, once. */
+  tests_fakefs_reset_nops();
+  res = explain_path_prewarm(p, pdircat(p, fake_root, "a", NULL));
+  ck_assert_msg(res == 5, "Expected 5 directories, got %d", res);
+  ck_assert_msg(tests_fakefs_get_nops() == 2,
+    "Expected 2 probes, got %u", tests_fakefs_get_nops());
+
+  /* The explanation then resumes its walk from the prewarmed directory. */
+  tests_fakefs_reset_nops();
+  desc = explain_path_error(p, EACCES, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path);
+  ck_assert_msg(tests_fakefs_get_nops() == 2,
+    "Expected 2 probes, got %u", tests_fakefs_get_nops());
+  ck_assert_msg(strstr(desc, "owned by UID 0") != NULL,
+    "Expected owner, got '%s'", desc);
+}
+END_TEST
+
+START_TEST (path_error_fakefs_scale_test) {
+  register unsigned int i, j;
+  int res;
+  const char *desc, *dir, *path;
+  unsigned int depth = 64;
+
+  /* 100 directories of 1000 files each, plus a deep chain of directories. */
+  res = tests_fakefs_mount(p, fake_root, 100200);
+  ck_assert_msg(res == 0, "Failed to mount fake filesystem: %s",
+    strerror(errno));
+
+  for (i = 0; i < 100; i++) {
+    dir = pdircat(p, fake_root, psprintf(p, "d%u", i), NULL);
+    res = tests_fakefs_add_dir(dir, 0755, 0, 0);
+    ck_assert_msg(res == 0, "Failed to add '%s': %s", dir, strerror(errno));
+
+    for (j = 0; j < 1000; j++) {
+      res = tests_fakefs_add_file(pdircat(p, dir, psprintf(p, "f%u", j), NULL),
+        0644, 0, 0);
+      ck_assert_msg(res == 0, "Failed to add file: %s", strerror(errno));
+    }
+  }
+
+  dir = fake_root;
+  for (i = 0; i < depth; i++) {
+    dir = pdircat(p, dir, "deep", NULL);
+    res = tests_fakefs_add_dir(dir, 0755, 0, 0);
+    ck_assert_msg(res == 0, "Failed to add '%s': %s", dir, strerror(errno));
+  }
+
+  /* Each fake component is probed at most once. */
+  tests_fakefs_reset_nops();
+  path = pdircat(p, dir, "missing", NULL);
+  desc = explain_path_error(p, ENOENT, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain ENOENT for '%s'", path);
+  ck_assert_msg(tests_fakefs_get_nops() <= depth + 2,
+    "Expected at most %u probes, got %u", depth + 2, tests_fakefs_get_nops());
+
+  tests_fakefs_reset_nops();
+  path = pdircat(p, fake_root, "d99/f999", NULL);
+  desc = explain_path_error(p, EACCES, path, 0, 0);
+  ck_assert_msg(desc != NULL, "Failed to explain EACCES for '%s'", path);
+  ck_assert_msg(tests_fakefs_get_nops() <= 4,
+    "Expected at most 4 probes, got %u", tests_fakefs_get_nops());
+}
+END_TEST
+
 Suite *tests_get_path_suite(void) {
   Suite *suite;
   TCase *testcase;
@@ -67,6 +652,17 @@ Suite *tests_get_path_suite(void) {
   tcase_add_checked_fixture(testcase, set_up, tear_down);
 
   tcase_add_test(testcase, path_error_params_test);
+  tcase_add_test(testcase, path_error_fsio_probe_count_test);
+  tcase_add_test(testcase, path_error_probe_count_test);
+  tcase_add_test(testcase, path_error_home_check_test);
+  tcase_add_test(testcase, path_error_fakefs_eacces_test);
+  tcase_add_test(testcase, path_error_fakefs_symlink_test);
+  tcase_add_test(testcase, path_error_terse_test);
+  tcase_add_test(testcase, path_error_budget_test);
+  tcase_add_test(testcase, path_error_resume_test);
+  tcase_add_test(testcase, path_error_failure_test);
+  tcase_add_test(testcase, path_prewarm_test);
+  tcase_add_test(testcase, path_error_fakefs_scale_test);
 
 /* XXX Tests to add:
  *  ENOENT (component, name)
@@ -26,6 +26,8 @@
 
 #include "tests.h"
 
+#include <sys/resource.h>
+
 static pool *p = NULL;
 
 static void set_up(void) {
@@ -35,6 +37,8 @@ static void set_up(void) {
 }
 
 static void tear_down(void) {
+  explain_platform_warm_free();
+
   if (p) {
     destroy_pool(p);
     p = NULL;
@@ -170,6 +174,269 @@ START_TEST (platform_open_max_test) {
 }
 END_TEST
 
+START_TEST (platform_root_fd_test) {
+  int fd;
+  const char *path;
+  struct stat st, root_st;
+
+  explain_platform_init(p);
+
+  /* Not chrooted, thus the handle is on "/". */
+  fd = explain_platform_root_fd();
+  ck_assert_msg(fd >= 0, "Failed to get root handle: %s", strerror(errno));
+  ck_assert_msg(fstat(fd, &st) == 0, "Failed to stat root handle: %s",
+    strerror(errno));
+  ck_assert_msg(stat("/", &root_st) == 0, "Failed to stat '/': %s",
+    strerror(errno));
+  ck_assert_msg(st.st_ino == root_st.st_ino, "Expected handle on '/'");
+
+  path = "/tmp";
+  pr_event_generate("core.chroot", path);
+
+  /* Not chrooted yet, thus the handle is not yet valid. */
+  fd = explain_platform_root_fd();
+  ck_assert_msg(fd < 0, "Failed to handle missing chroot");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  session.chroot_path = path;
+  fd = explain_platform_root_fd();
+  ck_assert_msg(fd >= 0, "Failed to get root handle: %s", strerror(errno));
+  ck_assert_msg(fstat(fd, &st) == 0, "Failed to stat root handle: %s",
+    strerror(errno));
+  ck_assert_msg(stat(path, &root_st) == 0, "Failed to stat '%s': %s", path,
+    strerror(errno));
+  ck_assert_msg(st.st_ino == root_st.st_ino, "Expected handle on '%s'", path);
+  session.chroot_path = NULL;
+
+  explain_platform_free(p);
+}
+END_TEST
+
+START_TEST (platform_home_fd_test) {
+  int fd, res;
+  const char *home_path = NULL, *path;
+  struct stat st;
+
+  explain_platform_init(p);
+
+  res = explain_platform_set_home(NULL, NULL);
+  ck_assert_msg(res < 0, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  fd = explain_platform_home_fd(&home_path);
+  ck_assert_msg(fd < 0, "Failed to handle missing home handle");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  path = "/tmp/explain-home.d/none";
+  res = explain_platform_set_home(p, path);
+  ck_assert_msg(res < 0, "Failed to handle missing home '%s'", path);
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  path = "/tmp/explain-home.d";
+  (void) rmdir(path);
+  (void) rmdir("/tmp/explain-home.d.old");
+  ck_assert_msg(mkdir(path, 0755) == 0, "Failed to create '%s': %s", path,
+    strerror(errno));
+
+  res = explain_platform_set_home(p, path);
+  ck_assert_msg(res == 0, "Failed to set home '%s': %s", path,
+    strerror(errno));
+
+  /* Not usable until checked. */
+  fd = explain_platform_home_fd(&home_path);
+  ck_assert_msg(fd < 0, "Failed to handle unchecked home handle");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  res = explain_platform_get_home(&home_path);
+  ck_assert_msg(res == EXPLAIN_PLATFORM_HOME_UNCHECKED, "Expected %d, got %d",
+    EXPLAIN_PLATFORM_HOME_UNCHECKED, res);
+  ck_assert_msg(home_path != NULL, "Expected home path, got null");
+  ck_assert_msg(strcmp(home_path, path) == 0, "Expected '%s', got '%s'",
+    path, home_path);
+
+  ck_assert_msg(stat(path, &st) == 0, "Failed to stat '%s': %s", path,
+    strerror(errno));
+  res = explain_platform_check_home(&st);
+  ck_assert_msg(res == 0, "Failed to check home: %s", strerror(errno));
+
+  res = explain_platform_get_home(NULL);
+  ck_assert_msg(res == EXPLAIN_PLATFORM_HOME_VALID, "Expected %d, got %d",
+    EXPLAIN_PLATFORM_HOME_VALID, res);
+
+  fd = explain_platform_home_fd(&home_path);
+  ck_assert_msg(fd >= 0, "Failed to get home handle: %s", strerror(errno));
+  ck_assert_msg(home_path != NULL, "Expected home path, got null");
+  ck_assert_msg(strcmp(home_path, path) == 0, "Expected '%s', got '%s'",
+    path, home_path);
+
+  explain_platform_uncheck_home();
+  fd = explain_platform_home_fd(&home_path);
+  ck_assert_msg(fd < 0, "Failed to uncheck home handle");
+
+  /* Replace the home directory; the handle is now stale.  Keep the old
+   * directory around, so that its inode is not reused.
+   */
+  ck_assert_msg(rename(path, "/tmp/explain-home.d.old") == 0,
+    "Failed to rename '%s': %s", path, strerror(errno));
+  ck_assert_msg(mkdir(path, 0755) == 0, "Failed to create '%s': %s", path,
+    strerror(errno));
+
+  ck_assert_msg(stat(path, &st) == 0, "Failed to stat '%s': %s", path,
+    strerror(errno));
+  res = explain_platform_check_home(&st);
+  ck_assert_msg(res < 0, "Failed to handle replaced home");
+  ck_assert_msg(errno == ESTALE, "Expected ESTALE (%d), got %s (%d)", ESTALE,
+    strerror(errno), errno);
+
+  res = explain_platform_get_home(NULL);
+  ck_assert_msg(res == EXPLAIN_PLATFORM_HOME_STALE, "Expected %d, got %d",
+    EXPLAIN_PLATFORM_HOME_STALE, res);
+
+  fd = explain_platform_home_fd(&home_path);
+  ck_assert_msg(fd < 0, "Failed to handle replaced home handle");
+
+  (void) rmdir(path);
+  (void) rmdir("/tmp/explain-home.d.old");
+
+  /* A home path which no longer resolves is stale, too. */
+  explain_platform_uncheck_home();
+  res = explain_platform_check_home(NULL);
+  ck_assert_msg(res < 0, "Failed to handle removed home");
+  ck_assert_msg(errno == ESTALE, "Expected ESTALE (%d), got %s (%d)", ESTALE,
+    strerror(errno), errno);
+
+  explain_platform_free(p);
+
+  res = explain_platform_get_home(NULL);
+  ck_assert_msg(res < 0, "Failed to close home handle");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+}
+END_TEST
+
+START_TEST (platform_open_file_test) {
+  int fd;
+  const char *dir_path = "/tmp/explain-open.d";
+  const char *path = "/tmp/explain-open.d/file";
+  struct stat st;
+
+  (void) unlink(path);
+  (void) unlink("/tmp/explain-open.d/link");
+  (void) rmdir(dir_path);
+
+  fd = explain_platform_open_file(NULL, O_RDWR, 0600);
+  ck_assert_msg(fd < 0, "Failed to handle null path");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  ck_assert_msg(mkdir(dir_path, 0777) == 0, "Failed to create '%s': %s",
+    dir_path, strerror(errno));
+  ck_assert_msg(chmod(dir_path, 0777) == 0, "Failed to chmod '%s': %s",
+    dir_path, strerror(errno));
+
+  fd = explain_platform_open_file(path, O_RDWR, 0600);
+  ck_assert_msg(fd < 0, "Failed to refuse world-writable directory");
+  ck_assert_msg(errno == EPERM, "Expected EPERM (%d), got %s (%d)", EPERM,
+    strerror(errno), errno);
+
+  ck_assert_msg(chmod(dir_path, 0755) == 0, "Failed to chmod '%s': %s",
+    dir_path, strerror(errno));
+
+  fd = explain_platform_open_file(path, O_RDWR, 0600);
+  ck_assert_msg(fd >= 0, "Failed to open '%s': %s", path, strerror(errno));
+  (void) close(fd);
+
+  ck_assert_msg(stat(path, &st) == 0, "Failed to stat '%s': %s", path,
+    strerror(errno));
+  ck_assert_msg((st.st_mode & 07777) == 0600, "Expected mode 0600, got %04o",
+    (unsigned int) (st.st_mode & 07777));
+
+  /* An existing file has its mode reset. */
+  ck_assert_msg(chmod(path, 0666) == 0, "Failed to chmod '%s': %s", path,
+    strerror(errno));
+  fd = explain_platform_open_file(path, O_RDWR, 0600);
+  ck_assert_msg(fd >= 0, "Failed to open '%s': %s", path, strerror(errno));
+  (void) close(fd);
+
+  ck_assert_msg(stat(path, &st) == 0, "Failed to stat '%s': %s", path,
+    strerror(errno));
+  ck_assert_msg((st.st_mode & 07777) == 0600, "Expected mode 0600, got %04o",
+    (unsigned int) (st.st_mode & 07777));
+
+  /* Neither symlinks nor hard links are followed. */
+  ck_assert_msg(symlink(path, "/tmp/explain-open.d/link") == 0,
+    "Failed to symlink '%s': %s", path, strerror(errno));
+  fd = explain_platform_open_file("/tmp/explain-open.d/link", O_RDWR, 0600);
+  ck_assert_msg(fd < 0, "Failed to refuse symlink");
+  (void) unlink("/tmp/explain-open.d/link");
+
+  ck_assert_msg(link(path, "/tmp/explain-open.d/link") == 0,
+    "Failed to link '%s': %s", path, strerror(errno));
+  fd = explain_platform_open_file("/tmp/explain-open.d/link", O_RDWR, 0600);
+  ck_assert_msg(fd < 0, "Failed to refuse hard link");
+  ck_assert_msg(errno == EPERM, "Expected EPERM (%d), got %s (%d)", EPERM,
+    strerror(errno), errno);
+
+  (void) unlink("/tmp/explain-open.d/link");
+  (void) unlink(path);
+  (void) rmdir(dir_path);
+}
+END_TEST
+
+START_TEST (platform_warm_test) {
+  int res;
+  long limit, expected;
+  array_header *paths;
+  struct rlimit rlim;
+
+  res = explain_platform_warm(NULL, NULL);
+  ck_assert_msg(res < 0, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  paths = make_array(p, 1, sizeof(char *));
+  *((char **) push_array(paths)) = pstrdup(p, "/tmp");
+
+  res = explain_platform_warm(p, paths);
+  ck_assert_msg(res == 0, "Failed to look up platform limits: %s",
+    strerror(errno));
+
+  explain_platform_init(p);
+
+  expected = sysconf(_SC_OPEN_MAX);
+  limit = explain_platform_open_max(p);
+  ck_assert_msg(limit == expected, "Expected %ld, got %ld", expected, limit);
+
+  /* Sessions may have different resource limits than the daemon. */
+  if (getrlimit(RLIMIT_NOFILE, &rlim) == 0 &&
+      rlim.rlim_cur > 64) {
+    struct rlimit lowered;
+
+    lowered.rlim_cur = 64;
+    lowered.rlim_max = rlim.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &lowered) == 0) {
+      limit = explain_platform_open_max(p);
+      (void) setrlimit(RLIMIT_NOFILE, &rlim);
+      ck_assert_msg(limit == 64, "Expected 64, got %ld", limit);
+    }
+  }
+
+  /* The filesystem limits for a session root are those looked up already. */
+  pr_event_generate("core.chroot", "/tmp");
+
+  expected = pathconf("/tmp", _PC_NAME_MAX);
+  limit = explain_platform_name_max(p, "/tmp");
+  ck_assert_msg(limit == expected, "Expected %ld, got %ld", expected, limit);
+
+  explain_platform_free(p);
+}
+END_TEST
+
 Suite *tests_get_platform_suite(void) {
   Suite *suite;
   TCase *testcase;
@@ -185,6 +452,10 @@ Suite *tests_get_platform_suite(void) {
   tcase_add_test(testcase, platform_no_trunc_test);
   tcase_add_test(testcase, platform_path_max_test);
   tcase_add_test(testcase, platform_open_max_test);
+  tcase_add_test(testcase, platform_root_fd_test);
+  tcase_add_test(testcase, platform_home_fd_test);
+  tcase_add_test(testcase, platform_open_file_test);
+  tcase_add_test(testcase, platform_warm_test);
 
   suite_add_tcase(suite, testcase);
   return suite;
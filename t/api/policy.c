@@ -0,0 +1,292 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Policy API tests. */
+
+#include "tests.h"
+
+static pool *p = NULL;
+
+static void set_up(void) {
+  if (p == NULL) {
+    p = make_sub_pool(NULL);
+  }
+
+  explain_policy_init(p);
+}
+
+static void tear_down(void) {
+  explain_policy_free();
+
+  if (p) {
+    destroy_pool(p);
+    p = NULL;
+  }
+}
+
+static server_rec *make_server(const char *name) {
+  server_rec *s;
+
+  s = pcalloc(p, sizeof(server_rec));
+  s->pool = p;
+  s->ServerName = name;
+  return s;
+}
+
+START_TEST (policy_params_test) {
+  const struct explain_policy *policy;
+  int res;
+
+  policy = explain_policy_compile(NULL, NULL);
+  ck_assert_msg(policy == NULL, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  policy = explain_policy_get(NULL);
+  ck_assert_msg(policy == NULL, "Failed to handle null server");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+
+  res = explain_policy_explains(NULL, EXPLAIN_SYSCALL_STAT);
+  ck_assert_msg(res == FALSE, "Expected FALSE for null policy, got %d", res);
+
+  res = explain_policy_get_syscall_id(NULL);
+  ck_assert_msg(res < 0, "Failed to handle null name");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  res = explain_policy_get_syscall_id("stat");
+  ck_assert_msg(res == EXPLAIN_SYSCALL_STAT, "Expected %d, got %d",
+    EXPLAIN_SYSCALL_STAT, res);
+
+  /* Names must match in full. */
+  res = explain_policy_get_syscall_id("sta");
+  ck_assert_msg(res < 0, "Failed to handle partial name");
+  ck_assert_msg(errno == ENOENT, "Expected ENOENT (%d), got %s (%d)", ENOENT,
+    strerror(errno), errno);
+}
+END_TEST
+
+START_TEST (policy_defaults_test) {
+  const struct explain_policy *policy;
+  server_rec *s;
+  int res;
+
+  s = make_server("default");
+  policy = explain_policy_compile(p, s);
+  ck_assert_msg(policy != NULL, "Failed to compile policy: %s",
+    strerror(errno));
+
+  ck_assert_msg(policy->engine == TRUE, "Expected engine on");
+  ck_assert_msg(policy->verbosity == PR_ERROR_FORMAT_USE_DETAILED,
+    "Expected detailed verbosity, got %u", policy->verbosity);
+  ck_assert_msg(policy->probe_budget == 0, "Expected no probe budget, got %u",
+    policy->probe_budget);
+  ck_assert_msg(policy->cache_max_entries == EXPLAIN_CACHE_DEFAULT_MAX_ENTRIES,
+    "Expected %u cache entries, got %u", EXPLAIN_CACHE_DEFAULT_MAX_ENTRIES,
+    policy->cache_max_entries);
+
+  res = explain_policy_explains(policy, EXPLAIN_SYSCALL_UNLINK);
+  ck_assert_msg(res == TRUE, "Expected unlink(2) to be explained");
+
+  ck_assert_msg(explain_policy_get(s) == policy,
+    "Failed to get compiled policy");
+}
+END_TEST
+
+START_TEST (policy_vhost_test) {
+  const struct explain_policy *policy, *policy2;
+  server_rec *s, *s2;
+  config_rec *c;
+  int res;
+
+  s = make_server("busy");
+
+  c = add_config_param_set(&(s->conf), "ExplainEngine", 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(int));
+  *((int *) c->argv[0]) = FALSE;
+
+  c = add_config_param_set(&(s->conf), "ExplainProbeBudget", 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[0]) = 4;
+
+  s2 = make_server("quiet");
+
+  c = add_config_param_set(&(s2->conf), "ExplainVerbosity", 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[0]) = PR_ERROR_FORMAT_USE_TERSE;
+
+  c = add_config_param_set(&(s2->conf), "ExplainSyscalls", 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(unsigned long));
+  *((unsigned long *) c->argv[0]) =
+    EXPLAIN_POLICY_SYSCALL(EXPLAIN_SYSCALL_CHROOT);
+
+  c = add_config_param_set(&(s2->conf), "ExplainOptions", 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(unsigned long));
+  *((unsigned long *) c->argv[0]) = EXPLAIN_OPT_NO_CACHE;
+
+  policy = explain_policy_compile(p, s);
+  ck_assert_msg(policy != NULL, "Failed to compile policy: %s",
+    strerror(errno));
+  policy2 = explain_policy_compile(p, s2);
+  ck_assert_msg(policy2 != NULL, "Failed to compile policy: %s",
+    strerror(errno));
+
+  /* Turning off one server does not affect the other. */
+  res = explain_policy_explains(policy, EXPLAIN_SYSCALL_CHROOT);
+  ck_assert_msg(res == FALSE, "Expected chroot(2) to not be explained");
+  ck_assert_msg(policy->probe_budget == 4, "Expected probe budget 4, got %u",
+    policy->probe_budget);
+
+  res = explain_policy_explains(policy2, EXPLAIN_SYSCALL_CHROOT);
+  ck_assert_msg(res == TRUE, "Expected chroot(2) to be explained");
+  res = explain_policy_explains(policy2, EXPLAIN_SYSCALL_STAT);
+  ck_assert_msg(res == FALSE, "Expected stat(2) to not be explained");
+  ck_assert_msg(policy2->verbosity == PR_ERROR_FORMAT_USE_TERSE,
+    "Expected terse verbosity, got %u", policy2->verbosity);
+  ck_assert_msg(policy2->cache_max_entries == 0,
+    "Expected caching disabled, got %u entries", policy2->cache_max_entries);
+
+  /* Compiling again replaces the previous policy. */
+  ck_assert_msg(explain_policy_compile(p, s) == policy,
+    "Expected recompiled policy to be reused");
+  ck_assert_msg(explain_policy_get(s2) == policy2,
+    "Failed to get compiled policy");
+}
+END_TEST
+
+START_TEST (policy_limits_test) {
+  const struct explain_policy *policy;
+  server_rec *s;
+  config_rec *c;
+
+  s = make_server("limited");
+
+  c = add_config_param_set(&(s->conf), "ExplainRateLimit", 5, NULL, NULL,
+    NULL, NULL, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[0]) = 10;
+  c->argv[1] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[1]) = 60;
+  c->argv[2] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[2]) = 3;
+  c->argv[3] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[3]) = 100;
+  c->argv[4] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[4]) = 300;
+
+  c = add_config_param_set(&(s->conf), "ExplainAdaptiveVerbosity", 4, NULL,
+    NULL, NULL, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(int));
+  *((int *) c->argv[0]) = TRUE;
+  c->argv[1] = palloc(c->pool, sizeof(unsigned long));
+  *((unsigned long *) c->argv[1]) = 5000;
+  c->argv[2] = palloc(c->pool, sizeof(double));
+  *((double *) c->argv[2]) = 2.5;
+  c->argv[3] = palloc(c->pool, sizeof(unsigned int));
+  *((unsigned int *) c->argv[3]) = 50;
+
+  policy = explain_policy_compile(p, s);
+  ck_assert_msg(policy != NULL, "Failed to compile policy: %s",
+    strerror(errno));
+
+  ck_assert_msg(policy->ratelimit == TRUE, "Expected rate limiting");
+  ck_assert_msg(policy->ratelimit_rate == 10, "Expected rate 10, got %u",
+    policy->ratelimit_rate);
+  ck_assert_msg(policy->ratelimit_rate_secs == 60,
+    "Expected rate secs 60, got %u", policy->ratelimit_rate_secs);
+  ck_assert_msg(policy->ratelimit_burst == 3, "Expected burst 3, got %u",
+    policy->ratelimit_burst);
+  ck_assert_msg(policy->ratelimit_sample == 100, "Expected sample 100, got %u",
+    policy->ratelimit_sample);
+  ck_assert_msg(policy->ratelimit_summary_secs == 300,
+    "Expected summary secs 300, got %u", policy->ratelimit_summary_secs);
+
+  ck_assert_msg(policy->adaptive == TRUE, "Expected adaptive verbosity");
+  ck_assert_msg(policy->adapt_max_usecs == 5000,
+    "Expected max usecs 5000, got %lu", policy->adapt_max_usecs);
+  ck_assert_msg(policy->adapt_max_loadavg > 2.4 &&
+    policy->adapt_max_loadavg < 2.6, "Expected max loadavg 2.5, got %f",
+    policy->adapt_max_loadavg);
+  ck_assert_msg(policy->adapt_max_sessions == 50,
+    "Expected max sessions 50, got %u", policy->adapt_max_sessions);
+
+  s = make_server("unlimited");
+  policy = explain_policy_compile(p, s);
+  ck_assert_msg(policy != NULL, "Failed to compile policy: %s",
+    strerror(errno));
+  ck_assert_msg(policy->ratelimit == FALSE, "Expected no rate limiting");
+  ck_assert_msg(policy->adaptive == FALSE, "Expected no adaptive verbosity");
+}
+END_TEST
+
+START_TEST (policy_engine_inherit_test) {
+  const struct explain_policy *policy;
+  server_rec *s;
+  config_rec *c;
+
+  main_server = make_server("main");
+  c = add_config_param_set(&(main_server->conf), "ExplainEngine", 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(int));
+  *((int *) c->argv[0]) = FALSE;
+
+  /* A vhost which does not set ExplainEngine follows the main server. */
+  s = make_server("inherits");
+  policy = explain_policy_compile(p, s);
+  ck_assert_msg(policy != NULL, "Failed to compile policy: %s",
+    strerror(errno));
+  ck_assert_msg(policy->engine == FALSE, "Expected engine off");
+
+  s = make_server("overrides");
+  c = add_config_param_set(&(s->conf), "ExplainEngine", 1, NULL);
+  c->argv[0] = palloc(c->pool, sizeof(int));
+  *((int *) c->argv[0]) = TRUE;
+
+  policy = explain_policy_compile(p, s);
+  ck_assert_msg(policy != NULL, "Failed to compile policy: %s",
+    strerror(errno));
+  ck_assert_msg(policy->engine == TRUE, "Expected engine on");
+
+  main_server = NULL;
+}
+END_TEST
+
+Suite *tests_get_policy_suite(void) {
+  Suite *suite;
+  TCase *testcase;
+
+  suite = suite_create("policy");
+  testcase = tcase_create("base");
+
+  tcase_add_checked_fixture(testcase, set_up, tear_down);
+
+  tcase_add_test(testcase, policy_params_test);
+  tcase_add_test(testcase, policy_defaults_test);
+  tcase_add_test(testcase, policy_vhost_test);
+  tcase_add_test(testcase, policy_limits_test);
+  tcase_add_test(testcase, policy_engine_inherit_test);
+
+  suite_add_tcase(suite, testcase);
+  return suite;
+}
@@ -0,0 +1,175 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Rate limiting API tests. */
+
+#include "tests.h"
+
+static pool *p = NULL;
+
+static void set_up(void) {
+  if (p == NULL) {
+    p = make_sub_pool(NULL);
+  }
+}
+
+static void tear_down(void) {
+  explain_ratelimit_free();
+
+  if (p) {
+    destroy_pool(p);
+    p = NULL;
+  }
+}
+
+START_TEST (ratelimit_params_test) {
+  register unsigned int i;
+  int res;
+  array_header *lines;
+
+  res = explain_ratelimit_init(NULL, 0, 0, 0, 0, 0);
+  ck_assert_msg(res < 0, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  lines = explain_ratelimit_summarize(NULL, FALSE);
+  ck_assert_msg(lines == NULL, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  /* A zero rate disables the limits. */
+  res = explain_ratelimit_init(p, 0, 0, 0, 0, 0);
+  ck_assert_msg(res == 0, "Failed to disable rate limits: %s",
+    strerror(errno));
+
+  for (i = 0; i < 100; i++) {
+    res = explain_ratelimit_admit(p, EXPLAIN_SYSCALL_STAT, ENOENT, "/foo");
+    ck_assert_msg(res == TRUE, "Expected admission #%u", i+1);
+  }
+}
+END_TEST
+
+START_TEST (ratelimit_burst_test) {
+  register unsigned int i;
+  int res;
+  unsigned long nadmitted = 0, nsuppressed = 0;
+  array_header *lines;
+  const char *line;
+
+  /* Effectively no refill, during the test. */
+  res = explain_ratelimit_init(p, 1, 3600, 3, 0, 3600);
+  ck_assert_msg(res == 0, "Failed to init rate limits: %s", strerror(errno));
+
+  for (i = 0; i < 3; i++) {
+    res = explain_ratelimit_admit(p, EXPLAIN_SYSCALL_WRITE, ENOSPC,
+      "/data/a/file");
+    ck_assert_msg(res == TRUE, "Expected admission #%u", i+1);
+  }
+
+  for (i = 0; i < 5; i++) {
+    res = explain_ratelimit_admit(p, EXPLAIN_SYSCALL_WRITE, ENOSPC,
+      i % 2 ? "/data/b/file" : "/data/a/other");
+    ck_assert_msg(res == FALSE, "Expected suppression #%u", i+1);
+  }
+
+  /* Other errnos have their own buckets. */
+  res = explain_ratelimit_admit(p, EXPLAIN_SYSCALL_WRITE, EIO, "/data");
+  ck_assert_msg(res == TRUE, "Expected admission for EIO");
+
+  explain_ratelimit_get_counts(&nadmitted, NULL, &nsuppressed);
+  ck_assert_msg(nadmitted == 4, "Expected 4 admitted, got %lu", nadmitted);
+  ck_assert_msg(nsuppressed == 5, "Expected 5 suppressed, got %lu",
+    nsuppressed);
+
+  /* Not yet due. */
+  lines = explain_ratelimit_summarize(p, FALSE);
+  ck_assert_msg(lines->nelts == 0, "Expected no summaries, got %u",
+    lines->nelts);
+
+  lines = explain_ratelimit_summarize(p, TRUE);
+  ck_assert_msg(lines->nelts == 1, "Expected 1 summary, got %u",
+    lines->nelts);
+  line = ((char **) lines->elts)[0];
+  ck_assert_msg(strncmp(line, "5 further write(2) errors", 25) == 0,
+    "Unexpected summary '%s'", line);
+  ck_assert_msg(strstr(line, " on /data suppressed in ") != NULL,
+    "Expected common prefix in summary '%s'", line);
+
+  /* Summarized counts are reset. */
+  lines = explain_ratelimit_summarize(p, TRUE);
+  ck_assert_msg(lines->nelts == 0, "Expected no summaries, got %u",
+    lines->nelts);
+}
+END_TEST
+
+START_TEST (ratelimit_sample_test) {
+  register unsigned int i;
+  int res;
+  unsigned long nadmitted = 0, nsampled = 0, nsuppressed = 0;
+  array_header *lines;
+  const char *line;
+
+  res = explain_ratelimit_init(p, 1, 3600, 1, 4, 0);
+  ck_assert_msg(res == 0, "Failed to init rate limits: %s", strerror(errno));
+
+  for (i = 0; i < 9; i++) {
+    (void) explain_ratelimit_admit(NULL, EXPLAIN_SYSCALL_OPEN, EACCES,
+      "/foo/bar");
+  }
+
+  /* The first in the burst, then every fourth over the limit. */
+  explain_ratelimit_get_counts(&nadmitted, &nsampled, &nsuppressed);
+  ck_assert_msg(nadmitted == 1, "Expected 1 admitted, got %lu", nadmitted);
+  ck_assert_msg(nsampled == 2, "Expected 2 sampled, got %lu", nsampled);
+  ck_assert_msg(nsuppressed == 6, "Expected 6 suppressed, got %lu",
+    nsuppressed);
+
+  /* With a zero interval, summaries are always due. */
+  lines = explain_ratelimit_summarize(p, FALSE);
+  ck_assert_msg(lines->nelts == 1, "Expected 1 summary, got %u",
+    lines->nelts);
+  line = ((char **) lines->elts)[0];
+  ck_assert_msg(strstr(line, " on /foo/bar ") != NULL,
+    "Expected path in summary '%s'", line);
+  ck_assert_msg(strstr(line, "(2 sampled)") != NULL,
+    "Expected sample count in summary '%s'", line);
+}
+END_TEST
+
+Suite *tests_get_ratelimit_suite(void) {
+  Suite *suite;
+  TCase *testcase;
+
+  suite = suite_create("ratelimit");
+  testcase = tcase_create("base");
+
+  tcase_add_checked_fixture(testcase, set_up, tear_down);
+
+  tcase_add_test(testcase, ratelimit_params_test);
+  tcase_add_test(testcase, ratelimit_burst_test);
+  tcase_add_test(testcase, ratelimit_sample_test);
+
+  suite_add_tcase(suite, testcase);
+  return suite;
+}
@@ -0,0 +1,260 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+
+/* Statistics API tests. */
+
+#include "tests.h"
+
+static pool *p = NULL;
+
+static void set_up(void) {
+  if (p == NULL) {
+    p = make_sub_pool(NULL);
+  }
+
+  explain_stats_init(p);
+}
+
+static void tear_down(void) {
+  explain_stats_free(p);
+
+  if (p) {
+    destroy_pool(p);
+    p = NULL;
+  }
+}
+
+START_TEST (stats_syscall_name_test) {
+  const char *name;
+
+  name = explain_stats_syscall_name(EXPLAIN_SYSCALL_MAX);
+  ck_assert_msg(name == NULL, "Failed to handle invalid syscall ID");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  name = explain_stats_syscall_name(EXPLAIN_SYSCALL_LSTAT);
+  ck_assert_msg(name != NULL, "Failed to get name: %s", strerror(errno));
+  ck_assert_msg(strcmp(name, "lstat(2)") == 0,
+    "Expected 'lstat(2)', got '%s'", name);
+
+  name = explain_stats_syscall_name(EXPLAIN_SYSCALL_WRITE);
+  ck_assert_msg(name != NULL, "Failed to get name: %s", strerror(errno));
+  ck_assert_msg(strcmp(name, "write(2)") == 0,
+    "Expected 'write(2)', got '%s'", name);
+}
+END_TEST
+
+START_TEST (stats_end_test) {
+  const struct explain_stats *stats;
+
+  stats = explain_stats_get();
+  ck_assert_msg(stats != NULL, "Failed to get stats");
+  ck_assert_msg(stats->explanations == 0, "Expected 0 explanations, got %lu",
+    (unsigned long) stats->explanations);
+
+  explain_stats_begin();
+  explain_stats_end(EXPLAIN_SYSCALL_LSTAT, ENOENT, "explained");
+
+  explain_stats_begin();
+  explain_stats_end(EXPLAIN_SYSCALL_LSTAT, ENOENT, NULL);
+
+  /* Out-of-range errnos are counted, but in the catch-all bucket. */
+  explain_stats_begin();
+  explain_stats_end(EXPLAIN_SYSCALL_CHROOT, EXPLAIN_STATS_MAX_ERRNO + 1,
+    "explained");
+
+  /* Invalid syscall IDs are ignored. */
+  explain_stats_begin();
+  explain_stats_end(EXPLAIN_SYSCALL_MAX, ENOENT, "explained");
+
+  ck_assert_msg(stats->explanations == 3, "Expected 3 explanations, got %lu",
+    (unsigned long) stats->explanations);
+  ck_assert_msg(stats->unexplained == 1, "Expected 1 unexplained, got %lu",
+    (unsigned long) stats->unexplained);
+  ck_assert_msg(stats->errnos[EXPLAIN_SYSCALL_LSTAT][ENOENT] == 2,
+    "Expected 2 lstat(2) ENOENTs, got %lu",
+    (unsigned long) stats->errnos[EXPLAIN_SYSCALL_LSTAT][ENOENT]);
+  ck_assert_msg(stats->errnos[EXPLAIN_SYSCALL_CHROOT][0] == 1,
+    "Expected 1 chroot(2) catch-all, got %lu",
+    (unsigned long) stats->errnos[EXPLAIN_SYSCALL_CHROOT][0]);
+  ck_assert_msg(stats->probe_counts[0] == 3,
+    "Expected 3 probe-less explanations, got %lu",
+    (unsigned long) stats->probe_counts[0]);
+
+  explain_stats_reset();
+  ck_assert_msg(stats->explanations == 0, "Expected 0 explanations, got %lu",
+    (unsigned long) stats->explanations);
+}
+END_TEST
+
+START_TEST (stats_text_test) {
+  array_header *lines;
+  const char *line;
+
+  lines = explain_stats_text(NULL);
+  ck_assert_msg(lines == NULL, "Failed to handle null pool");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  lines = explain_stats_text(p);
+  ck_assert_msg(lines != NULL, "Failed to get text: %s", strerror(errno));
+  ck_assert_msg(lines->nelts == 1, "Expected 1 line, got %u", lines->nelts);
+
+  explain_stats_begin();
+  explain_stats_end(EXPLAIN_SYSCALL_UNLINK, EACCES, "explained");
+
+  lines = explain_stats_text(p);
+  ck_assert_msg(lines != NULL, "Failed to get text: %s", strerror(errno));
+  ck_assert_msg(lines->nelts == 4, "Expected 4 lines, got %u", lines->nelts);
+
+  line = ((char **) lines->elts)[1];
+  ck_assert_msg(strncmp(line, "unlink(2) errno ", 16) == 0,
+    "Expected unlink(2) errno line, got '%s'", line);
+
+  line = ((char **) lines->elts)[2];
+  ck_assert_msg(strncmp(line, "unlink(2) latency (usecs): ", 27) == 0,
+    "Expected unlink(2) latency line, got '%s'", line);
+}
+END_TEST
+
+START_TEST (stats_open_test) {
+  int fd, res;
+  pid_t pid;
+  const char *dir_path = "/tmp/explain-stats.d";
+  const char *path = "/tmp/explain-stats.d/stats.dat";
+  const struct explain_stats *stats;
+  struct explain_stats_region region;
+  struct stat st;
+
+  (void) unlink(path);
+  (void) rmdir(dir_path);
+  ck_assert_msg(mkdir(dir_path, 0755) == 0, "Failed to create '%s': %s",
+    dir_path, strerror(errno));
+
+  explain_stats_begin();
+  explain_stats_end(EXPLAIN_SYSCALL_STAT, ENOENT, "explained");
+
+  res = explain_stats_open(p, NULL);
+  ck_assert_msg(res == 0, "Failed to open anonymous region: %s",
+    strerror(errno));
+
+  /* Counters collected so far carry over into the region. */
+  stats = explain_stats_get();
+  ck_assert_msg(stats->explanations == 1, "Expected 1 explanation, got %lu",
+    (unsigned long) stats->explanations);
+
+  res = explain_stats_open(p, path);
+  ck_assert_msg(res == 0, "Failed to open '%s': %s", path, strerror(errno));
+
+  ck_assert_msg(stat(path, &st) == 0, "Failed to stat '%s': %s", path,
+    strerror(errno));
+  ck_assert_msg((st.st_mode & 07777) == 0600, "Expected mode 0600, got %04o",
+    (unsigned int) (st.st_mode & 07777));
+
+  stats = explain_stats_get();
+  ck_assert_msg(stats->explanations == 1, "Expected 1 explanation, got %lu",
+    (unsigned long) stats->explanations);
+
+  /* Counts from child processes are visible in the parent. */
+  pid = fork();
+  ck_assert_msg(pid >= 0, "Failed to fork: %s", strerror(errno));
+  if (pid == 0) {
+    explain_stats_begin();
+    explain_stats_end(EXPLAIN_SYSCALL_STAT, EACCES, "explained");
+    _exit(0);
+  }
+
+  (void) waitpid(pid, NULL, 0);
+  ck_assert_msg(stats->explanations == 2, "Expected 2 explanations, got %lu",
+    (unsigned long) stats->explanations);
+  ck_assert_msg(stats->errnos[EXPLAIN_SYSCALL_STAT][EACCES] == 1,
+    "Expected 1 stat(2) EACCES, got %lu",
+    (unsigned long) stats->errnos[EXPLAIN_SYSCALL_STAT][EACCES]);
+
+  /* External readers see the same counters, via the file. */
+  fd = open(path, O_RDONLY);
+  ck_assert_msg(fd >= 0, "Failed to open '%s': %s", path, strerror(errno));
+  res = read(fd, &region, sizeof(region));
+  (void) close(fd);
+  ck_assert_msg(res == sizeof(region), "Expected %lu bytes, read %d",
+    (unsigned long) sizeof(region), res);
+  ck_assert_msg(region.magic == EXPLAIN_STATS_MAGIC, "Unexpected magic %lx",
+    (unsigned long) region.magic);
+  ck_assert_msg(region.size == sizeof(region), "Unexpected size %lu",
+    (unsigned long) region.size);
+  ck_assert_msg(region.stats.explanations == 2,
+    "Expected 2 explanations, got %lu",
+    (unsigned long) region.stats.explanations);
+
+  res = explain_stats_close();
+  ck_assert_msg(res == 0, "Failed to close region: %s", strerror(errno));
+
+  stats = explain_stats_get();
+  ck_assert_msg(stats->explanations == 2, "Expected 2 explanations, got %lu",
+    (unsigned long) stats->explanations);
+
+  explain_stats_reset();
+  (void) unlink(path);
+  (void) rmdir(dir_path);
+}
+END_TEST
+
+START_TEST (stats_scratch_pool_test) {
+  pool *tmp_pool;
+  char *ptr;
+
+  tmp_pool = explain_stats_scratch_pool(p);
+  ck_assert_msg(tmp_pool != NULL, "Failed to create scratch pool: %s",
+    strerror(errno));
+
+  ptr = palloc(tmp_pool, 100);
+  ck_assert_msg(ptr != NULL, "Failed to allocate from scratch pool");
+
+  /* Explanations may outgrow the first block. */
+  ptr = pcalloc(tmp_pool, EXPLAIN_STATS_SCRATCH_POOL_SZ * 2);
+  ck_assert_msg(ptr != NULL, "Failed to allocate from scratch pool");
+
+  destroy_pool(tmp_pool);
+}
+END_TEST
+
+Suite *tests_get_stats_suite(void) {
+  Suite *suite;
+  TCase *testcase;
+
+  suite = suite_create("stats");
+  testcase = tcase_create("base");
+
+  tcase_add_checked_fixture(testcase, set_up, tear_down);
+
+  tcase_add_test(testcase, stats_syscall_name_test);
+  tcase_add_test(testcase, stats_end_test);
+  tcase_add_test(testcase, stats_text_test);
+  tcase_add_test(testcase, stats_open_test);
+  tcase_add_test(testcase, stats_scratch_pool_test);
+
+  suite_add_tcase(suite, testcase);
+  return suite;
+}
@@ -182,10 +182,35 @@ int pr_log_writefile(int fd, const char *name, const char *fmt, ...) {
   return 0;
 }
 
+static unsigned int scoreboard_nentries = 0, scoreboard_idx = 0;
+static pr_scoreboard_entry_t scoreboard_entry;
+
+int pr_rewind_scoreboard(void) {
+  scoreboard_idx = 0;
+  return 0;
+}
+
+pr_scoreboard_entry_t *pr_scoreboard_entry_read(void) {
+  if (scoreboard_idx >= scoreboard_nentries) {
+    return NULL;
+  }
+
+  scoreboard_idx++;
+  return &scoreboard_entry;
+}
+
+int pr_restore_scoreboard(void) {
+  return 0;
+}
+
 int pr_scoreboard_entry_update(pid_t pid, ...) {
   return 0;
 }
 
+void tests_scoreboard_set_nentries(unsigned int nentries) {
+  scoreboard_nentries = nentries;
+}
+
 void pr_session_disconnect(module *m, int reason_code, const char *details) {
 }
 
@@ -203,6 +228,76 @@ int pr_session_set_protocol(const char *proto) {
 void pr_signals_handle(void) {
 }
 
+/* FSIO counting shims */
+
+static pr_fs_t *shim_fs = NULL;
+static char *shim_fs_name = NULL;
+static int (*shim_lstat)(pr_fs_t *, const char *, struct stat *) = NULL;
+static int (*shim_stat)(pr_fs_t *, const char *, struct stat *) = NULL;
+static struct tests_fsio_counts shim_counts;
+
+/* Any name other than "system" makes the probing layer defer to FSIO. */
+static char shim_name[] = "testsuite";
+
+static int shim_fsio_lstat(pr_fs_t *fs, const char *path, struct stat *st) {
+  shim_counts.lstat++;
+  return (shim_lstat)(fs, path, st);
+}
+
+static int shim_fsio_stat(pr_fs_t *fs, const char *path, struct stat *st) {
+  shim_counts.stat++;
+  return (shim_stat)(fs, path, st);
+}
+
+int tests_fsio_shims_enable(void) {
+  pr_fs_t *fs;
+
+  if (shim_fs != NULL) {
+    errno = EEXIST;
+    return -1;
+  }
+
+  fs = pr_get_fs("/", NULL);
+  if (fs == NULL) {
+    errno = ENOENT;
+    return -1;
+  }
+
+  /* Cached results would bypass our shims. */
+  pr_fs_statcache_reset();
+
+  shim_fs = fs;
+  shim_fs_name = fs->fs_name;
+  shim_lstat = fs->lstat;
+  shim_stat = fs->stat;
+
+  fs->fs_name = shim_name;
+  fs->lstat = shim_fsio_lstat;
+  fs->stat = shim_fsio_stat;
+
+  tests_fsio_reset_counts();
+  return 0;
+}
+
+void tests_fsio_shims_disable(void) {
+  if (shim_fs == NULL) {
+    return;
+  }
+
+  shim_fs->fs_name = shim_fs_name;
+  shim_fs->lstat = shim_lstat;
+  shim_fs->stat = shim_stat;
+  shim_fs = NULL;
+}
+
+const struct tests_fsio_counts *tests_fsio_get_counts(void) {
+  return &shim_counts;
+}
+
+void tests_fsio_reset_counts(void) {
+  memset(&shim_counts, 0, sizeof(shim_counts));
+}
+
 /* Module-specific stubs */
 
 module explain_module = {
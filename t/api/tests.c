@@ -30,9 +30,18 @@ struct testsuite_info {
 };
 
 static struct testsuite_info suites[] = {
+  { "adapt",		tests_get_adapt_suite },
+  { "batch",		tests_get_batch_suite },
+  { "cache",		tests_get_cache_suite },
+  { "caps",		tests_get_caps_suite },
   { "generic",		tests_get_generic_suite },
+  { "journal",		tests_get_journal_suite },
   { "platform",		tests_get_platform_suite },
   { "path",		tests_get_path_suite },
+  { "policy",		tests_get_policy_suite },
+  { "ratelimit",	tests_get_ratelimit_suite },
+  { "stats",		tests_get_stats_suite },
+  { "token",		tests_get_token_suite },
 
   { NULL, NULL }
 };
@@ -29,8 +29,15 @@
 
 #include "mod_explain.h"
 
+#include "adapt.h"
+#include "cache.h"
+#include "caps.h"
 #include "generic.h"
 #include "platform.h"
+#include "policy.h"
+#include "ratelimit.h"
+#include "stats.h"
+#include "token.h"
 
 #ifdef HAVE_CHECK_H
 # include <check.h>
@@ -38,9 +45,55 @@
 # error "Missing Check installation; necessary for ProFTPD testsuite"
 #endif
 
+Suite *tests_get_adapt_suite(void);
+Suite *tests_get_batch_suite(void);
+Suite *tests_get_cache_suite(void);
+Suite *tests_get_caps_suite(void);
 Suite *tests_get_generic_suite(void);
+Suite *tests_get_journal_suite(void);
 Suite *tests_get_platform_suite(void);
 Suite *tests_get_path_suite(void);
+Suite *tests_get_policy_suite(void);
+Suite *tests_get_ratelimit_suite(void);
+Suite *tests_get_stats_suite(void);
+Suite *tests_get_token_suite(void);
+
+/* Counting shims for the FSIO handlers of the root filesystem.  While
+ * enabled, all path probes are made via FSIO (the fast paths only apply to
+ * the "system" filesystem), and counted.
+ */
+struct tests_fsio_counts {
+  unsigned int lstat;
+  unsigned int stat;
+};
+
+int tests_fsio_shims_enable(void);
+void tests_fsio_shims_disable(void);
+const struct tests_fsio_counts *tests_fsio_get_counts(void);
+void tests_fsio_reset_counts(void);
+
+/* In-memory FSIO backend, mounted at the given path, sized for the given
+ * number of nodes.  The identity set via tests_fakefs_set_user() is used for
+ * search permission checks; by default, there are none.  Injected errnos are
+ * returned for any lookup through the given node, and injected latency is
+ * added to every operation.  Touching a node bumps its ctime, as does adding
+ * an entry to a directory.
+ */
+int tests_fakefs_mount(pool *p, const char *path, unsigned int nnodes);
+int tests_fakefs_unmount(void);
+int tests_fakefs_add_dir(const char *path, mode_t mode, uid_t uid, gid_t gid);
+int tests_fakefs_add_file(const char *path, mode_t mode, uid_t uid,
+  gid_t gid);
+int tests_fakefs_add_symlink(const char *path, const char *target);
+int tests_fakefs_set_errno(const char *path, int xerrno);
+int tests_fakefs_touch(const char *path);
+void tests_fakefs_set_latency(unsigned long usecs);
+void tests_fakefs_set_user(uid_t uid, gid_t gid);
+unsigned int tests_fakefs_get_nops(void);
+void tests_fakefs_reset_nops(void);
+
+/* Sets the number of entries the stubbed scoreboard reports. */
+void tests_scoreboard_set_nentries(unsigned int nentries);
 
 extern volatile unsigned int recvd_signal_flags;
 extern pid_t mpid;
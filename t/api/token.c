@@ -0,0 +1,199 @@
+/*
+ * ProFTPD - mod_explain testsuite
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Tokenizer API tests. */
+
+#include "tests.h"
+
+static pool *p = NULL;
+
+static int default_impl = -1;
+
+static void set_up(void) {
+  if (p == NULL) {
+    p = make_sub_pool(NULL);
+  }
+
+  default_impl = explain_token_get_impl();
+}
+
+static void tear_down(void) {
+  (void) explain_token_set_impl(default_impl);
+
+  if (p) {
+    destroy_pool(p);
+    p = NULL;
+  }
+}
+
+START_TEST (token_params_test) {
+  int res;
+  struct explain_token tokens[4];
+
+  res = explain_token_scan(NULL, 0, 0, NULL, 0, NULL);
+  ck_assert_msg(res < 0, "Failed to handle null path");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  res = explain_token_scan("/a", 2, 0, NULL, 0, NULL);
+  ck_assert_msg(res < 0, "Failed to handle null tokens");
+  ck_assert_msg(errno == EINVAL, "Expected EINVAL (%d), got %s (%d)", EINVAL,
+    strerror(errno), errno);
+
+  res = explain_token_scan("/a/b/c", 6, 0, tokens, 2, NULL);
+  ck_assert_msg(res < 0, "Failed to handle too few tokens");
+  ck_assert_msg(errno == ENOSPC, "Expected ENOSPC (%d), got %s (%d)", ENOSPC,
+    strerror(errno), errno);
+
+  res = explain_token_set_impl(-1);
+  ck_assert_msg(res < 0, "Failed to handle unknown implementation");
+  ck_assert_msg(errno == ENOSYS, "Expected ENOSYS (%d), got %s (%d)", ENOSYS,
+    strerror(errno), errno);
+
+  res = explain_token_set_impl(EXPLAIN_TOKEN_IMPL_SCALAR);
+  ck_assert_msg(res == 0, "Failed to use scalar implementation: %s",
+    strerror(errno));
+}
+END_TEST
+
+START_TEST (token_scan_test) {
+  int res;
+  unsigned int flags = 0;
+  const char *path;
+  struct explain_token tokens[8];
+
+  path = "//foo/./bar//../bazquux/";
+  res = explain_token_scan(path, strlen(path), 6, tokens, 8, &flags);
+  ck_assert_msg(res == 5, "Expected 5 components, got %d", res);
+
+  ck_assert_msg(tokens[0].offset == 2 && tokens[0].len == 3,
+    "Expected 'foo' at 2, got %lu bytes at %lu",
+    (unsigned long) tokens[0].len, (unsigned long) tokens[0].offset);
+  ck_assert_msg(tokens[1].flags == EXPLAIN_TOKEN_FL_DOT,
+    "Expected '.' flagged, got %#x", tokens[1].flags);
+  ck_assert_msg(tokens[2].offset == 8 && tokens[2].len == 3,
+    "Expected 'bar' at 8, got %lu bytes at %lu",
+    (unsigned long) tokens[2].len, (unsigned long) tokens[2].offset);
+  ck_assert_msg(tokens[3].flags == EXPLAIN_TOKEN_FL_DOTDOT,
+    "Expected '..' flagged, got %#x", tokens[3].flags);
+  ck_assert_msg(tokens[4].len == 7 &&
+    tokens[4].flags == EXPLAIN_TOKEN_FL_TOO_LONG,
+    "Expected too-long 'bazquux', got %lu bytes, flags %#x",
+    (unsigned long) tokens[4].len, tokens[4].flags);
+
+  ck_assert_msg(flags == (EXPLAIN_TOKEN_FL_DOT|EXPLAIN_TOKEN_FL_DOTDOT|
+    EXPLAIN_TOKEN_FL_TOO_LONG), "Expected all flags, got %#x", flags);
+
+  /* Without a maximum, no name is too long; names merely starting with dots
+   * are not flagged.
+   */
+  path = "/..foo/.bar";
+  res = explain_token_scan(path, strlen(path), 0, tokens, 8, &flags);
+  ck_assert_msg(res == 2, "Expected 2 components, got %d", res);
+  ck_assert_msg(flags == 0, "Expected no flags, got %#x", flags);
+
+  res = explain_token_scan("/", 1, 0, tokens, 8, &flags);
+  ck_assert_msg(res == 0, "Expected no components, got %d", res);
+}
+END_TEST
+
+START_TEST (token_impls_test) {
+  register unsigned int i, j;
+  int impl;
+
+  /* Every supported implementation must agree with the scalar one, for
+   * paths whose separators fall on either side of the vector boundaries.
+   */
+  for (i = 1; i < 200; i++) {
+    char *path;
+    size_t path_len;
+    struct explain_token expected[128], tokens[128];
+    unsigned int expected_flags = 0, flags = 0;
+    int expected_ntokens, ntokens;
+
+    path_len = i;
+    path = pcalloc(p, path_len + 1);
+    for (j = 0; j < path_len; j++) {
+      /* Mix in runs of separators, and dot names. */
+      if (j % 7 == 0 ||
+          j % 11 == 0 ||
+          (i % 5 == 0 && j % 13 == 1)) {
+        path[j] = '/';
+
+      } else if (j % 3 == 0) {
+        path[j] = '.';
+
+      } else {
+        path[j] = 'a' + (j % 26);
+      }
+    }
+
+    (void) explain_token_set_impl(EXPLAIN_TOKEN_IMPL_SCALAR);
+    expected_ntokens = explain_token_scan(path, path_len, 4, expected, 128,
+      &expected_flags);
+    ck_assert_msg(expected_ntokens >= 0, "Failed to scan '%s': %s", path,
+      strerror(errno));
+
+    for (impl = EXPLAIN_TOKEN_IMPL_SCALAR + 1; impl < EXPLAIN_TOKEN_IMPL_MAX;
+        impl++) {
+      if (explain_token_set_impl(impl) < 0) {
+        continue;
+      }
+
+      ntokens = explain_token_scan(path, path_len, 4, tokens, 128, &flags);
+      ck_assert_msg(ntokens == expected_ntokens,
+        "%s: expected %d components of '%s', got %d",
+        explain_token_get_impl_name(impl), expected_ntokens, path, ntokens);
+      ck_assert_msg(flags == expected_flags,
+        "%s: expected flags %#x for '%s', got %#x",
+        explain_token_get_impl_name(impl), expected_flags, path, flags);
+
+      for (j = 0; j < (unsigned int) ntokens; j++) {
+        ck_assert_msg(tokens[j].offset == expected[j].offset &&
+          tokens[j].len == expected[j].len &&
+          tokens[j].flags == expected[j].flags,
+          "%s: component #%u of '%s' differs",
+          explain_token_get_impl_name(impl), j, path);
+      }
+    }
+  }
+}
+END_TEST
+
+Suite *tests_get_token_suite(void) {
+  Suite *suite;
+  TCase *testcase;
+
+  suite = suite_create("token");
+  testcase = tcase_create("base");
+
+  tcase_add_checked_fixture(testcase, set_up, tear_down);
+
+  tcase_add_test(testcase, token_params_test);
+  tcase_add_test(testcase, token_scan_test);
+  tcase_add_test(testcase, token_impls_test);
+
+  suite_add_tcase(suite, testcase);
+  return suite;
+}
@@ -0,0 +1,525 @@
+/*
+ * ProFTPD - mod_explain benchmarks
+ * Copyright (c) 2026 TJ Saunders <tj@castaglia.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Explainer microbenchmarks.
+ *
+ * Generates a directory tree of configurable depth and width (by default on
+ * tmpfs, i.e. /dev/shm), then times explanations of errors on paths in that
+ * tree, for each of the available probing backends.  Tunables are read from
+ * the environment:
+ *
+ *  EXPLAIN_BENCH_DIR         Directory in which to create the tree
+ *  EXPLAIN_BENCH_DEPTH       Number of nested directories
+ *  EXPLAIN_BENCH_WIDTH       Number of sibling directories at each level
+ *  EXPLAIN_BENCH_ITERATIONS  Number of explanations per case
+ *  EXPLAIN_BENCH_LATENCY     Injected latency (usecs) per op, for the
+ *                            in-memory filesystem cases
+ *
+ * The probes and syscalls reported are those made by the probing layer,
+ * i.e. the filesystem lookups; pool bytes are those allocated out of the
+ * explanation's pool.
+ */
+
+#include "tests.h"
+#include "path.h"
+#include "probe.h"
+#include "chroot.h"
+#include "lstat.h"
+#include "stat.h"
+#include "unlink.h"
+#include "token.h"
+
+#define BENCH_DEFAULT_DEPTH		8
+#define BENCH_DEFAULT_WIDTH		4
+#define BENCH_DEFAULT_ITERATIONS	2000
+
+/* Each explanation gets a pool with a single block this large, so that the
+ * bytes allocated can be measured by pointer arithmetic.
+ */
+#define BENCH_POOL_BLOCK_SZ		(256 * 1024)
+
+struct bench_tree {
+  const char *root;
+
+  /* Everything created, in creation order, for removal. */
+  array_header *paths;
+
+  const char *deep_dir;
+  const char *deep_file;
+};
+
+struct bench_case {
+  const char *name;
+  int xerrno;
+  const char *path;
+  const char *(*explain)(pool *p, struct bench_case *bc);
+
+  /* Zero means detailed. */
+  unsigned int verbosity;
+};
+
+struct bench_backend {
+  const char *name;
+  unsigned long flags;
+};
+
+static struct bench_backend bench_backends[] = {
+  { "serial",	0 },
+  { "statx",	EXPLAIN_PROBE_FL_USE_STATX },
+  { "io_uring",	EXPLAIN_PROBE_FL_USE_STATX|EXPLAIN_PROBE_FL_USE_IO_URING },
+  { "openat2",	EXPLAIN_PROBE_FL_USE_STATX|EXPLAIN_PROBE_FL_USE_IO_URING|EXPLAIN_PROBE_FL_USE_OPENAT2 },
+
+  { NULL, 0 }
+};
+
+static struct bench_backend bench_fakefs_backend = { "fakefs", 0 };
+
+static unsigned int bench_getenv_uint(const char *name,
+    unsigned int default_val) {
+  const char *val;
+  unsigned long num;
+  char *endp = NULL;
+
+  val = getenv(name);
+  if (val == NULL) {
+    return default_val;
+  }
+
+  num = strtoul(val, &endp, 10);
+  if (endp == val ||
+      *endp != '\0' ||
+      num == 0) {
+    fprintf(stderr, "Ignoring invalid %s value '%s'\n", name, val);
+    return default_val;
+  }
+
+  return (unsigned int) num;
+}
+
+static const char *bench_get_dir(void) {
+  const char *dir;
+  struct stat st;
+
+  dir = getenv("EXPLAIN_BENCH_DIR");
+  if (dir != NULL) {
+    return dir;
+  }
+
+  if (stat("/dev/shm", &st) == 0 &&
+      S_ISDIR(st.st_mode)) {
+    return "/dev/shm";
+  }
+
+  return "/tmp";
+}
+
+static int bench_tree_add(pool *p, struct bench_tree *tree, const char *path,
+    int dir) {
+  int res;
+
+  if (dir == TRUE) {
+    res = mkdir(path, 0755);
+
+  } else {
+    res = open(path, O_WRONLY|O_CREAT|O_EXCL, 0644);
+    if (res >= 0) {
+      (void) close(res);
+      res = 0;
+    }
+  }
+
+  if (res < 0) {
+    fprintf(stderr, "Error creating '%s': %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  *((const char **) push_array(tree->paths)) = pstrdup(p, path);
+  return 0;
+}
+
+static void bench_tree_destroy(struct bench_tree *tree) {
+  register int i;
+  const char **paths;
+
+  paths = tree->paths->elts;
+  for (i = tree->paths->nelts - 1; i >= 0; i--) {
+    if (rmdir(paths[i]) < 0 &&
+        errno == ENOTDIR) {
+      (void) unlink(paths[i]);
+    }
+  }
+
+  (void) rmdir(tree->root);
+}
+
+/* Each level has `width` sibling directories, and a file; the walk descends
+ * through the last sibling, so that lookups in each directory have some
+ * entries to skip past.
+ */
+static struct bench_tree *bench_tree_create(pool *p, const char *base,
+    unsigned int depth, unsigned int width) {
+  register unsigned int i, j;
+  struct bench_tree *tree;
+  char *root, *dir;
+
+  root = pdircat(p, base, "mod_explain-bench.XXXXXX", NULL);
+  if (mkdtemp(root) == NULL) {
+    fprintf(stderr, "Error creating '%s': %s\n", root, strerror(errno));
+    return NULL;
+  }
+
+  tree = pcalloc(p, sizeof(struct bench_tree));
+  tree->root = root;
+  tree->paths = make_array(p, depth * (width + 1), sizeof(char *));
+
+  dir = root;
+  for (i = 0; i < depth; i++) {
+    char *subdir = NULL;
+
+    for (j = 0; j < width; j++) {
+      subdir = pdircat(p, dir, psprintf(p, "d%u.%u", i, j), NULL);
+      if (bench_tree_add(p, tree, subdir, TRUE) < 0) {
+        bench_tree_destroy(tree);
+        return NULL;
+      }
+    }
+
+    if (bench_tree_add(p, tree, pdircat(p, dir, "file", NULL), FALSE) < 0) {
+      bench_tree_destroy(tree);
+      return NULL;
+    }
+
+    dir = subdir;
+  }
+
+  tree->deep_dir = dir;
+  tree->deep_file = pdircat(p, dir, "file", NULL);
+  if (bench_tree_add(p, tree, tree->deep_file, FALSE) < 0) {
+    bench_tree_destroy(tree);
+    return NULL;
+  }
+
+  return tree;
+}
+
+/* Mirrors the shape of the on-disk tree in the in-memory filesystem, mounted
+ * beneath the on-disk tree.  Returns the deepest directory.
+ */
+static const char *bench_fakefs_create(pool *p, struct bench_tree *tree,
+    unsigned int depth, unsigned int width) {
+  register unsigned int i, j;
+  const char *mount_path, *dir;
+
+  mount_path = pdircat(p, tree->root, "fake", NULL);
+  if (bench_tree_add(p, tree, mount_path, TRUE) < 0) {
+    return NULL;
+  }
+
+  if (tests_fakefs_mount(p, mount_path, depth * (width + 1) + 2) < 0) {
+    fprintf(stderr, "Error mounting fake filesystem at '%s': %s\n",
+      mount_path, strerror(errno));
+    return NULL;
+  }
+
+  dir = mount_path;
+  for (i = 0; i < depth; i++) {
+    const char *subdir = NULL;
+
+    for (j = 0; j < width; j++) {
+      subdir = pdircat(p, dir, psprintf(p, "d%u.%u", i, j), NULL);
+      (void) tests_fakefs_add_dir(subdir, 0755, 0, 0);
+    }
+
+    (void) tests_fakefs_add_file(pdircat(p, dir, "file", NULL), 0600, 0, 0);
+    dir = subdir;
+  }
+
+  (void) tests_fakefs_add_file(pdircat(p, dir, "file", NULL), 0600, 0, 0);
+
+  /* Explain as an unprivileged user, even when running as root. */
+  tests_fakefs_set_user(1000, 1000);
+  return dir;
+}
+
+static unsigned int bench_get_verbosity(struct bench_case *bc) {
+  return bc->verbosity != 0 ? bc->verbosity : PR_ERROR_FORMAT_USE_DETAILED;
+}
+
+static const char *bench_explain_path(pool *p, struct bench_case *bc) {
+  int flags = 0;
+
+  if (bench_get_verbosity(bc) == PR_ERROR_FORMAT_USE_TERSE) {
+    flags |= EXPLAIN_PATH_FL_TERSE;
+  }
+
+  return explain_path_error(p, bc->xerrno, bc->path, flags, 0);
+}
+
+static const char *bench_explain_generic(pool *p, struct bench_case *bc) {
+  return explain_describe_generic(p, bc->xerrno, "read");
+}
+
+static const char *bench_explain_chroot(pool *p, struct bench_case *bc) {
+  const char *args = NULL;
+
+  return explain_chroot_error(p, bc->xerrno, bc->path,
+    bench_get_verbosity(bc), &args);
+}
+
+static const char *bench_explain_lstat(pool *p, struct bench_case *bc) {
+  const char *args = NULL;
+  struct stat st;
+
+  return explain_lstat_error(p, bc->xerrno, bc->path, &st,
+    bench_get_verbosity(bc), &args);
+}
+
+static const char *bench_explain_stat(pool *p, struct bench_case *bc) {
+  const char *args = NULL;
+  struct stat st;
+
+  return explain_stat_error(p, bc->xerrno, bc->path, &st,
+    bench_get_verbosity(bc), &args);
+}
+
+static const char *bench_explain_unlink(pool *p, struct bench_case *bc) {
+  const char *args = NULL;
+
+  return explain_unlink_error(p, bc->xerrno, bc->path,
+    bench_get_verbosity(bc), &args);
+}
+
+static const char *bench_tokenize(pool *p, struct bench_case *bc) {
+  size_t path_len;
+  struct explain_token *tokens;
+  unsigned int max_tokens;
+
+  path_len = strlen(bc->path);
+  max_tokens = (path_len + 1) / 2;
+  tokens = palloc(p, sizeof(struct explain_token) * max_tokens);
+
+  if (explain_token_scan(bc->path, path_len, NAME_MAX, tokens, max_tokens,
+      NULL) < 0) {
+    return NULL;
+  }
+
+  return bc->path;
+}
+
+static uint64_t bench_now_nsecs(void) {
+  struct timespec ts;
+
+  (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static void bench_run(pool *p, struct bench_backend *backend,
+    struct bench_case *bc, unsigned int iterations) {
+  register unsigned int i;
+  uint64_t nsecs = 0, pool_bytes = 0;
+  unsigned long nprobes, nsyscalls, start_nprobes, start_nsyscalls;
+  unsigned int unexplained = 0;
+
+  explain_probe_get_counts(&start_nprobes, &start_nsyscalls);
+
+  for (i = 0; i < iterations; i++) {
+    pool *tmp_pool;
+    const char *explained;
+    char *start_ptr, *end_ptr;
+    uint64_t start_nsecs;
+
+    tmp_pool = pr_pool_create_sz(p, BENCH_POOL_BLOCK_SZ);
+    start_ptr = palloc(tmp_pool, 1);
+
+    start_nsecs = bench_now_nsecs();
+    explained = (bc->explain)(tmp_pool, bc);
+    nsecs += (bench_now_nsecs() - start_nsecs);
+
+    if (explained == NULL) {
+      unexplained++;
+    }
+
+    /* If the explanation outgrew the first block, this undercounts; the
+     * block is sized so that that should not happen.
+     */
+    end_ptr = palloc(tmp_pool, 1);
+    if (end_ptr > start_ptr &&
+        (size_t) (end_ptr - start_ptr) < BENCH_POOL_BLOCK_SZ) {
+      pool_bytes += (end_ptr - start_ptr);
+    }
+
+    destroy_pool(tmp_pool);
+  }
+
+  explain_probe_get_counts(&nprobes, &nsyscalls);
+  nprobes -= start_nprobes;
+  nsyscalls -= start_nsyscalls;
+
+  printf("%-24s %-9s %10.0f ns %8.2f probes %8.2f syscalls %8.0f bytes%s\n",
+    bc->name, backend->name, (double) nsecs / iterations,
+    (double) nprobes / iterations, (double) nsyscalls / iterations,
+    (double) pool_bytes / iterations,
+    unexplained > 0 ? " (unexplained)" : "");
+}
+
+int main(int argc, char *argv[]) {
+  register unsigned int i, j;
+  pool *bench_pool;
+  struct bench_tree *tree;
+  unsigned int depth, width, iterations, latency;
+  unsigned long avail_flags;
+  const char *missing, *notdir, *toolong, *fake_dir;
+  char name[NAME_MAX * 2];
+
+  depth = bench_getenv_uint("EXPLAIN_BENCH_DEPTH", BENCH_DEFAULT_DEPTH);
+  width = bench_getenv_uint("EXPLAIN_BENCH_WIDTH", BENCH_DEFAULT_WIDTH);
+  iterations = bench_getenv_uint("EXPLAIN_BENCH_ITERATIONS",
+    BENCH_DEFAULT_ITERATIONS);
+  latency = bench_getenv_uint("EXPLAIN_BENCH_LATENCY", 0);
+
+  bench_pool = make_sub_pool(NULL);
+  explain_platform_init(bench_pool);
+  explain_probe_init(bench_pool);
+  avail_flags = explain_probe_get_flags();
+
+  tree = bench_tree_create(bench_pool, bench_get_dir(), depth, width);
+  if (tree == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  memset(name, 'n', sizeof(name) - 1);
+  name[sizeof(name) - 1] = '\0';
+
+  missing = pdircat(bench_pool, tree->deep_dir, "missing", NULL);
+  notdir = pdircat(bench_pool, tree->deep_file, "missing", NULL);
+  toolong = pdircat(bench_pool, tree->deep_dir, name, NULL);
+
+  {
+    struct bench_case cases[] = {
+      { "path ENOENT",		ENOENT,		missing, bench_explain_path },
+      { "path ENOTDIR",		ENOTDIR,	notdir,	bench_explain_path },
+      { "path EACCES",		EACCES,		tree->deep_file,
+        bench_explain_path },
+      { "path ENAMETOOLONG",	ENAMETOOLONG,	toolong, bench_explain_path },
+      { "generic EIO",		EIO,		NULL, bench_explain_generic },
+      { "generic ENOSPC",	ENOSPC,		NULL, bench_explain_generic },
+      { "chroot(2) ENOENT",	ENOENT,		missing, bench_explain_chroot },
+      { "lstat(2) ENOENT",	ENOENT,		missing, bench_explain_lstat },
+      { "stat(2) ENOTDIR",	ENOTDIR,	notdir,	bench_explain_stat },
+      { "unlink(2) EACCES",	EACCES,		tree->deep_file,
+        bench_explain_unlink },
+
+      /* The same failures, explained for the less verbose formats. */
+      { "path EACCES terse",	EACCES,		tree->deep_file,
+        bench_explain_path, PR_ERROR_FORMAT_USE_TERSE },
+      { "unlink(2) EACCES terse", EACCES,	tree->deep_file,
+        bench_explain_unlink, PR_ERROR_FORMAT_USE_TERSE },
+      { "unlink(2) EACCES min",	EACCES,		tree->deep_file,
+        bench_explain_unlink, PR_ERROR_FORMAT_USE_MINIMAL },
+      { "lstat(2) ENOENT terse",	ENOENT,		missing,
+        bench_explain_lstat, PR_ERROR_FORMAT_USE_TERSE },
+      { "lstat(2) ENOENT min",	ENOENT,		missing,
+        bench_explain_lstat, PR_ERROR_FORMAT_USE_MINIMAL },
+
+      { NULL, 0, NULL, NULL, 0 }
+    };
+
+    printf("# depth %u, width %u, %u iterations, in %s\n", depth, width,
+      iterations, tree->root);
+
+    for (i = 0; cases[i].name != NULL; i++) {
+      for (j = 0; bench_backends[j].name != NULL; j++) {
+        if ((bench_backends[j].flags & avail_flags) !=
+            bench_backends[j].flags) {
+          continue;
+        }
+
+        explain_probe_set_flags(bench_backends[j].flags);
+        bench_run(bench_pool, &(bench_backends[j]), &(cases[i]), iterations);
+      }
+    }
+  }
+
+  /* The path tokenizer, for each implementation supported by the CPU, on
+   * the longest paths we can make.
+   */
+  {
+    int impl;
+    char *long_path;
+    struct bench_case bc = { "token scan", 0, NULL, bench_tokenize };
+
+    long_path = pcalloc(bench_pool, PR_TUNABLE_PATH_MAX + 1);
+    for (i = 0; i + 16 < PR_TUNABLE_PATH_MAX; i += 16) {
+      memcpy(long_path + i, "/component-name.", 16);
+    }
+    bc.path = long_path;
+
+    for (impl = 0; impl < EXPLAIN_TOKEN_IMPL_MAX; impl++) {
+      struct bench_backend tokenizer;
+
+      if (explain_token_set_impl(impl) < 0) {
+        continue;
+      }
+
+      tokenizer.name = explain_token_get_impl_name(impl);
+      tokenizer.flags = 0;
+      bench_run(bench_pool, &tokenizer, &bc, iterations);
+    }
+  }
+
+  fake_dir = bench_fakefs_create(bench_pool, tree, depth, width);
+  if (fake_dir != NULL) {
+    struct bench_case cases[] = {
+      { "fakefs path ENOENT",	ENOENT,
+        pdircat(bench_pool, fake_dir, "missing", NULL), bench_explain_path },
+      { "fakefs path EACCES",	EACCES,
+        pdircat(bench_pool, fake_dir, "file", NULL), bench_explain_path },
+      { "fakefs path EACCES terse", EACCES,
+        pdircat(bench_pool, fake_dir, "file", NULL), bench_explain_path,
+        PR_ERROR_FORMAT_USE_TERSE },
+
+      { NULL, 0, NULL, NULL, 0 }
+    };
+
+    if (latency > 0) {
+      printf("# in-memory filesystem, %u usecs per op\n", latency);
+      tests_fakefs_set_latency(latency);
+    }
+
+    for (i = 0; cases[i].name != NULL; i++) {
+      bench_run(bench_pool, &bench_fakefs_backend, &(cases[i]), iterations);
+    }
+
+    tests_fakefs_unmount();
+  }
+
+  explain_probe_set_flags(avail_flags);
+  bench_tree_destroy(tree);
+
+  explain_probe_free(bench_pool);
+  explain_platform_free(bench_pool);
+  destroy_pool(bench_pool);
+
+  return EXIT_SUCCESS;
+}
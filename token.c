@@ -0,0 +1,307 @@
+/*
+ * ProFTPD - mod_explain: path tokenization
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Splitting paths into components is done once per walk; for long paths,
+ * we find the separators 16 or 32 bytes at a time, using the SSE2 or AVX2
+ * byte comparisons (as supported by the CPU), and compute each component's
+ * length, and flags, as we go.
+ */
+
+#include "token.h"
+
+#if defined(HAVE_X86_SIMD)
+# include <immintrin.h>
+#endif /* HAVE_X86_SIMD */
+
+struct token_state {
+  const char *path;
+  unsigned long name_max;
+  struct explain_token *tokens;
+  unsigned int max_tokens;
+  unsigned int ntokens;
+  unsigned int flags;
+};
+
+typedef int (*token_scan_fn)(struct token_state *, size_t);
+
+static int token_impl = -1;
+static token_scan_fn token_scanner = NULL;
+
+static const char *trace_channel = "explain.token";
+
+/* Records the component from start up to (but not including) end. */
+static inline int token_emit(struct token_state *ts, size_t start,
+    size_t end) {
+  struct explain_token *token;
+  size_t len;
+
+  len = end - start;
+  if (len == 0) {
+    return 0;
+  }
+
+  if (ts->ntokens == ts->max_tokens) {
+    errno = ENOSPC;
+    return -1;
+  }
+
+  token = &(ts->tokens[ts->ntokens++]);
+  token->offset = start;
+  token->len = len;
+  token->flags = 0;
+
+  if (ts->path[start] == '.') {
+    if (len == 1) {
+      token->flags |= EXPLAIN_TOKEN_FL_DOT;
+
+    } else if (len == 2 &&
+               ts->path[start+1] == '.') {
+      token->flags |= EXPLAIN_TOKEN_FL_DOTDOT;
+    }
+  }
+
+  if (ts->name_max > 0 &&
+      len > ts->name_max) {
+    token->flags |= EXPLAIN_TOKEN_FL_TOO_LONG;
+  }
+
+  ts->flags |= token->flags;
+  return 0;
+}
+
+/* Scans the bytes from offset up to path_len, one at a time; start is the
+ * beginning of the current component.
+ */
+static int token_scan_tail(struct token_state *ts, size_t offset,
+    size_t start, size_t path_len) {
+  register size_t i;
+
+  for (i = offset; i < path_len; i++) {
+    if (ts->path[i] == '/') {
+      if (token_emit(ts, start, i) < 0) {
+        return -1;
+      }
+
+      start = i + 1;
+    }
+  }
+
+  return token_emit(ts, start, path_len);
+}
+
+static int token_scan_scalar(struct token_state *ts, size_t path_len) {
+  return token_scan_tail(ts, 0, 0, path_len);
+}
+
+#if defined(HAVE_X86_SIMD)
+/* Emits the components ended by the separators in mask, a bitmap of the
+ * bytes starting at offset.
+ */
+static inline int token_emit_mask(struct token_state *ts, size_t offset,
+    unsigned int mask, size_t *start) {
+  while (mask != 0) {
+    size_t pos;
+
+    pos = offset + __builtin_ctz(mask);
+    if (token_emit(ts, *start, pos) < 0) {
+      return -1;
+    }
+
+    *start = pos + 1;
+    mask &= (mask - 1);
+  }
+
+  return 0;
+}
+
+__attribute__((target("sse2")))
+static int token_scan_sse2(struct token_state *ts, size_t path_len) {
+  size_t offset = 0, start = 0;
+  __m128i seps;
+
+  seps = _mm_set1_epi8('/');
+
+  for (; offset + 16 <= path_len; offset += 16) {
+    __m128i chunk;
+    unsigned int mask;
+
+    chunk = _mm_loadu_si128((const __m128i *) (ts->path + offset));
+    mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, seps));
+    if (token_emit_mask(ts, offset, mask, &start) < 0) {
+      return -1;
+    }
+  }
+
+  return token_scan_tail(ts, offset, start, path_len);
+}
+
+__attribute__((target("avx2")))
+static int token_scan_avx2(struct token_state *ts, size_t path_len) {
+  size_t offset = 0, start = 0;
+  __m256i seps;
+
+  seps = _mm256_set1_epi8('/');
+
+  for (; offset + 32 <= path_len; offset += 32) {
+    __m256i chunk;
+    unsigned int mask;
+
+    chunk = _mm256_loadu_si256((const __m256i *) (ts->path + offset));
+    mask = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk,
+      seps));
+    if (token_emit_mask(ts, offset, mask, &start) < 0) {
+      return -1;
+    }
+  }
+
+  return token_scan_tail(ts, offset, start, path_len);
+}
+#endif /* HAVE_X86_SIMD */
+
+static int token_impl_supported(int impl) {
+#if defined(HAVE_X86_SIMD)
+  __builtin_cpu_init();
+#endif /* HAVE_X86_SIMD */
+
+  switch (impl) {
+    case EXPLAIN_TOKEN_IMPL_SCALAR:
+      return TRUE;
+
+#if defined(HAVE_X86_SIMD)
+    case EXPLAIN_TOKEN_IMPL_SSE2:
+      return __builtin_cpu_supports("sse2") ? TRUE : FALSE;
+
+    case EXPLAIN_TOKEN_IMPL_AVX2:
+      return __builtin_cpu_supports("avx2") ? TRUE : FALSE;
+#endif /* HAVE_X86_SIMD */
+
+    default:
+      break;
+  }
+
+  return FALSE;
+}
+
+static token_scan_fn token_impl_scanner(int impl) {
+  switch (impl) {
+#if defined(HAVE_X86_SIMD)
+    case EXPLAIN_TOKEN_IMPL_SSE2:
+      return token_scan_sse2;
+
+    case EXPLAIN_TOKEN_IMPL_AVX2:
+      return token_scan_avx2;
+#endif /* HAVE_X86_SIMD */
+
+    default:
+      break;
+  }
+
+  return token_scan_scalar;
+}
+
+static void token_select_impl(void) {
+  int impl;
+
+  for (impl = EXPLAIN_TOKEN_IMPL_MAX - 1; impl > 0; impl--) {
+    if (token_impl_supported(impl) == TRUE) {
+      break;
+    }
+  }
+
+  token_impl = impl;
+  token_scanner = token_impl_scanner(impl);
+
+  pr_trace_msg(trace_channel, 9, "using %s path tokenizer",
+    explain_token_get_impl_name(impl));
+}
+
+int explain_token_scan(const char *path, size_t path_len,
+    unsigned long name_max, struct explain_token *tokens,
+    unsigned int max_tokens, unsigned int *flags) {
+  struct token_state ts;
+
+  if (path == NULL ||
+      tokens == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (token_scanner == NULL) {
+    token_select_impl();
+  }
+
+  ts.path = path;
+  ts.name_max = name_max;
+  ts.tokens = tokens;
+  ts.max_tokens = max_tokens;
+  ts.ntokens = 0;
+  ts.flags = 0;
+
+  if ((token_scanner)(&ts, path_len) < 0) {
+    return -1;
+  }
+
+  if (flags != NULL) {
+    *flags = ts.flags;
+  }
+
+  return (int) ts.ntokens;
+}
+
+int explain_token_get_impl(void) {
+  if (token_scanner == NULL) {
+    token_select_impl();
+  }
+
+  return token_impl;
+}
+
+const char *explain_token_get_impl_name(int impl) {
+  switch (impl) {
+    case EXPLAIN_TOKEN_IMPL_SCALAR:
+      return "scalar";
+
+    case EXPLAIN_TOKEN_IMPL_SSE2:
+      return "SSE2";
+
+    case EXPLAIN_TOKEN_IMPL_AVX2:
+      return "AVX2";
+
+    default:
+      break;
+  }
+
+  return "unknown";
+}
+
+int explain_token_set_impl(int impl) {
+  if (token_impl_supported(impl) == FALSE) {
+    errno = ENOSYS;
+    return -1;
+  }
+
+  token_impl = impl;
+  token_scanner = token_impl_scanner(impl);
+  return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * ProFTPD - mod_explain: path tokenization
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_TOKEN_H
+#define MOD_EXPLAIN_TOKEN_H
+
+#include "mod_explain.h"
+
+struct explain_token {
+  /* Offset of the component within the path, and its length. */
+  size_t offset;
+  size_t len;
+  unsigned int flags;
+};
+
+#define EXPLAIN_TOKEN_FL_DOT		0x001
+#define EXPLAIN_TOKEN_FL_DOTDOT		0x002
+#define EXPLAIN_TOKEN_FL_TOO_LONG	0x004
+
+/* Tokenizer implementations */
+#define EXPLAIN_TOKEN_IMPL_SCALAR	0
+#define EXPLAIN_TOKEN_IMPL_SSE2		1
+#define EXPLAIN_TOKEN_IMPL_AVX2		2
+#define EXPLAIN_TOKEN_IMPL_MAX		3
+
+/* Splits the given path into its components, in a single pass over its
+ * bytes.  Empty components (i.e. from repeated separators) are skipped.  Each
+ * component is flagged if it is "." or "..", or if it is longer than
+ * name_max (if non-zero).  The flags of all of the components are OR'd into
+ * flags, if provided.  Returns the number of components, or -1 on error (with
+ * ENOSPC if there are more than max_tokens).  A path of path_len bytes has at
+ * most (path_len + 1) / 2 components.
+ */
+int explain_token_scan(const char *path, size_t path_len,
+  unsigned long name_max, struct explain_token *tokens,
+  unsigned int max_tokens, unsigned int *flags);
+
+/* By default, the fastest implementation supported by the CPU is used. */
+int explain_token_get_impl(void);
+const char *explain_token_get_impl_name(int impl);
+
+/* Returns -1, with ENOSYS, if the implementation is not supported. */
+int explain_token_set_impl(int impl);
+
+#endif /* MOD_EXPLAIN_TOKEN_H */
@@ -23,8 +23,60 @@
  */
 
 #include "unlink.h"
+#include "caps.h"
 #include "generic.h"
 #include "path.h"
+#include "probe.h"
+
+/* In a sticky directory, only the owner of the file, the owner of the
+ * directory, or a process with CAP_FOWNER may remove the file.
+ */
+static const char *describe_sticky_eperm(pool *p, const char *syscall,
+    const char *path) {
+  const char *dir_path, *explained = "";
+  char *ptr;
+  struct stat dir_st, st;
+  uid_t euid;
+
+  ptr = strrchr(path, '/');
+  if (ptr == NULL) {
+    dir_path = ".";
+
+  } else if (ptr == path) {
+    dir_path = "/";
+
+  } else {
+    dir_path = pstrndup(p, path, ptr - path);
+  }
+
+  if (explain_probe_lstat(p, dir_path, &dir_st) < 0 ||
+      explain_probe_lstat(p, path, &st) < 0) {
+    return NULL;
+  }
+
+  euid = geteuid();
+  if (!(dir_st.st_mode & S_ISVTX) ||
+      st.st_uid == euid ||
+      dir_st.st_uid == euid) {
+    return NULL;
+  }
+
+  /* Root may still lack CAP_FOWNER, e.g. in a container; without it, root
+   * is as bound by the sticky bit as anyone else.
+   */
+  if (euid == PR_ROOT_UID) {
+    explained = explain_caps_describe_eperm(p, syscall, EXPLAIN_CAP_FOWNER);
+    if (explained == NULL) {
+      return NULL;
+    }
+
+    explained = pstrcat(p, ", and ", explained, NULL);
+  }
+
+  return pstrcat(p, "directory '", dir_path, "' has the sticky bit set, "
+    "and neither the directory nor '", path, "' is owned by the process",
+    explained, NULL);
+}
 
 static const char *get_args(pool *p, const char *path) {
   const char *args;
@@ -34,19 +86,27 @@ static const char *get_args(pool *p, const char *path) {
 }
 
 const char *explain_unlink_error(pool *p, int xerrno, const char *path,
-    const char **args) {
+    unsigned int verbosity, const char **args) {
   const char *explained = NULL, *syscall = "unlink(2)";
   int path_flags = EXPLAIN_PATH_FL_WANT_UNLINK;
 
   *args = get_args(p, path);
 
   switch (xerrno) {
+    case EPERM:
+      if (verbosity != PR_ERROR_FORMAT_USE_MINIMAL) {
+        explained = describe_sticky_eperm(p, syscall, path);
+        if (explained != NULL) {
+          break;
+        }
+      }
+
     case EACCES:
     case ENOENT:
     case ELOOP:
     case ENAMETOOLONG:
-    case EPERM:
-      explained = explain_path_error(p, xerrno, path, path_flags, S_IFREG);
+      explained = explain_path_describe(p, xerrno, syscall, path,
+        path_flags, S_IFREG, verbosity);
       break;
 
     default:
@@ -0,0 +1,56 @@
+/*
+ * ProFTPD - mod_explain: USDT probes
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+#ifndef MOD_EXPLAIN_USDT_H
+#define MOD_EXPLAIN_USDT_H
+
+#include "mod_explain.h"
+
+/* Statically defined tracing probes, for use with e.g. perf(1) or bpftrace:
+ *
+ *  mod_explain:explainer__dispatch(syscall_id, errno)
+ *  mod_explain:explanation__start(syscall_id, errno)
+ *  mod_explain:explanation__end(syscall_id, errno, explained)
+ *  mod_explain:path__component(index, count, path, errno)
+ *
+ * When compiled out (the default), these cost nothing; when compiled in,
+ * each is a single nop until a tracer attaches.
+ */
+
+#if defined(EXPLAIN_USE_SDT)
+# include <sys/sdt.h>
+
+# define EXPLAIN_USDT2(name, a1, a2) \
+    DTRACE_PROBE2(mod_explain, name, a1, a2)
+# define EXPLAIN_USDT3(name, a1, a2, a3) \
+    DTRACE_PROBE3(mod_explain, name, a1, a2, a3)
+# define EXPLAIN_USDT4(name, a1, a2, a3, a4) \
+    DTRACE_PROBE4(mod_explain, name, a1, a2, a3, a4)
+#else
+# define EXPLAIN_USDT2(name, a1, a2)
+# define EXPLAIN_USDT3(name, a1, a2, a3)
+# define EXPLAIN_USDT4(name, a1, a2, a3, a4)
+#endif /* EXPLAIN_USE_SDT */
+
+#endif /* MOD_EXPLAIN_USDT_H */
@@ -0,0 +1,882 @@
+/*
+ * ProFTPD - mod_explain: offline explainer
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Explains, after the fact, the failures recorded in ExplainJournal files
+ * or in text logs, using all of the available cores.
+ *
+ * The records are sorted by identity and path, and split into chunks of
+ * records sharing an identity; each chunk is explained as one batch, so
+ * that the directories its paths share are probed once.  The chunks are
+ * dealt out, in order, to one worker process per core; a worker takes
+ * chunks from the front of its own run, and once that is exhausted, steals
+ * them from the back of the longest remaining run.  Thus each worker mostly
+ * explains neighbouring paths, keeping its caches warm, while none sit
+ * idle.  Processes, rather than threads, are used since each worker assumes
+ * the identity of the records it explains, as a session would.
+ *
+ * Those caches (the probe memo and the path resume chain) are per worker,
+ * and are not shared: their results depend on the identity of the worker,
+ * which changes between chunks, and the records are already ordered so that
+ * a worker's own caches see most of the reuse.
+ */
+
+#include "mod_explain.h"
+#include "batch.h"
+#include "journal.h"
+#include "path.h"
+#include "platform.h"
+#include "policy.h"
+#include "probe.h"
+#include "stats.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#if defined(HAVE___ATOMIC)
+# define deque_load(ptr)	__atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+# define deque_cas(ptr, old, new) \
+    __atomic_compare_exchange_n((ptr), (old), (new), FALSE, \
+      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+/* Without atomics, there is only ever the one worker. */
+# define deque_load(ptr)	*(ptr)
+# define deque_cas(ptr, old, new)	(*(ptr) = (new), TRUE)
+#endif /* HAVE___ATOMIC */
+
+#define FTPEXPLAIN_CHUNK_SIZE		256
+#define FTPEXPLAIN_MAX_WORKERS		256
+#define FTPEXPLAIN_OUTPUT_BUFSZ		(64 * 1024)
+
+static const char *program = "ftpexplain";
+
+struct ftpexplain_input {
+  const char *path;
+  int is_journal;
+};
+
+struct ftpexplain_record {
+  unsigned int syscall_id;
+  int xerrno;
+  uid_t uid;
+  gid_t gid;
+  const char *path;
+
+  /* Where the record came from: the input, and the line number (for text
+   * logs) or sequence number (for journals) within it.
+   */
+  unsigned int input_idx;
+  unsigned long lineno;
+};
+
+struct ftpexplain_chunk {
+  unsigned int start;
+  unsigned int count;
+};
+
+/* A worker's run of chunk indices, [head, tail), packed into one word so
+ * that the owner (taking from the head) and thieves (taking from the tail)
+ * can each claim a chunk with a single compare-and-swap.  Padded to a cache
+ * line, so that workers do not contend on each others' runs.
+ */
+struct ftpexplain_deque {
+  uint64_t range;
+  char pad[56];
+};
+
+struct ftpexplain_worker_stats {
+  unsigned long nchunks;
+  unsigned long nstolen;
+  unsigned long nrecords;
+  unsigned long nexplained;
+  char pad[32];
+};
+
+/* Shared by all of the workers, via an anonymous shared mapping. */
+struct ftpexplain_shared {
+  struct ftpexplain_deque deques[FTPEXPLAIN_MAX_WORKERS];
+  struct ftpexplain_worker_stats stats[FTPEXPLAIN_MAX_WORKERS];
+};
+
+static array_header *inputs = NULL;
+static array_header *records = NULL;
+static array_header *chunks = NULL;
+static struct ftpexplain_shared *shared = NULL;
+static unsigned int nworkers = 1;
+static unsigned int verbosity = PR_ERROR_FORMAT_USE_DETAILED;
+static unsigned long nskipped = 0;
+
+/* Worker-local output buffer, written out a chunk at a time. */
+static char *output_buf = NULL;
+static size_t output_len = 0;
+
+static const struct {
+  const char *name;
+  int xerrno;
+} errno_names[] = {
+  { "EPERM",		EPERM },
+  { "ENOENT",		ENOENT },
+  { "EIO",		EIO },
+  { "EBADF",		EBADF },
+  { "EACCES",		EACCES },
+  { "EBUSY",		EBUSY },
+  { "EEXIST",		EEXIST },
+  { "EXDEV",		EXDEV },
+  { "ENOTDIR",		ENOTDIR },
+  { "EISDIR",		EISDIR },
+  { "EINVAL",		EINVAL },
+  { "ENFILE",		ENFILE },
+  { "EMFILE",		EMFILE },
+  { "ENOSPC",		ENOSPC },
+  { "EROFS",		EROFS },
+  { "ENAMETOOLONG",	ENAMETOOLONG },
+  { "ENOTEMPTY",	ENOTEMPTY },
+  { "ELOOP",		ELOOP },
+#if defined(EDQUOT)
+  { "EDQUOT",		EDQUOT },
+#endif /* EDQUOT */
+  { NULL, 0 }
+};
+
+static void show_usage(int exit_code) {
+  fprintf(stdout, "usage: %s [-h] [-j workers] [-v verbosity] file ...\n",
+    program);
+  fprintf(stdout, "\nEach file is either an ExplainJournal file, or a text "
+    "log of records, one per\nline, of the form:\n\n"
+    "  syscall errno uid gid path\n\n"
+    "e.g. \"stat ENOENT 1000 1000 /srv/ftp/incoming/file.txt\".  A file "
+    "of \"-\" reads\nsuch records from stdin.  The verbosity is one of "
+    "\"detailed\" (the default),\n\"terse\" or \"minimal\".\n");
+  exit(exit_code);
+}
+
+static int parse_errno(const char *text) {
+  register unsigned int i;
+  char *ptr = NULL;
+  long xerrno;
+
+  for (i = 0; errno_names[i].name != NULL; i++) {
+    if (strcasecmp(errno_names[i].name, text) == 0) {
+      return errno_names[i].xerrno;
+    }
+  }
+
+  xerrno = strtol(text, &ptr, 10);
+  if (ptr == NULL ||
+      *ptr != '\0' ||
+      xerrno <= 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return (int) xerrno;
+}
+
+static int parse_id(const char *text, unsigned long *id) {
+  char *ptr = NULL;
+
+  *id = strtoul(text, &ptr, 10);
+  if (ptr == NULL ||
+      *ptr != '\0') {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return 0;
+}
+
+static struct ftpexplain_record *add_record(pool *p, unsigned int syscall_id,
+    int xerrno, uid_t uid, gid_t gid, const char *path,
+    unsigned int input_idx, unsigned long lineno) {
+  struct ftpexplain_record *record;
+
+  record = push_array(records);
+  record->syscall_id = syscall_id;
+  record->xerrno = xerrno;
+  record->uid = uid;
+  record->gid = gid;
+  record->path = pstrdup(p, path);
+  record->input_idx = input_idx;
+  record->lineno = lineno;
+
+  return record;
+}
+
+/* Parses a "syscall errno uid gid path" line; the path is the remainder of
+ * the line, and so may contain spaces.
+ */
+static int parse_line(pool *p, char *line, unsigned int input_idx,
+    unsigned long lineno) {
+  register unsigned int i;
+  char *fields[4], *ptr;
+  int syscall_id, xerrno;
+  unsigned long uid, gid;
+  size_t len;
+
+  len = strlen(line);
+  while (len > 0 &&
+         (line[len-1] == '\n' || line[len-1] == '\r')) {
+    line[--len] = '\0';
+  }
+
+  ptr = line;
+  for (i = 0; i < 4; i++) {
+    while (*ptr == ' ' || *ptr == '\t') {
+      ptr++;
+    }
+
+    if (*ptr == '\0' ||
+        (i == 0 && *ptr == '#')) {
+      /* Blank lines, and comments, are ignored. */
+      if (i == 0) {
+        return 0;
+      }
+
+      errno = EINVAL;
+      return -1;
+    }
+
+    fields[i] = ptr;
+    ptr += strcspn(ptr, " \t");
+    if (*ptr == '\0') {
+      errno = EINVAL;
+      return -1;
+    }
+
+    *ptr++ = '\0';
+  }
+
+  while (*ptr == ' ' || *ptr == '\t') {
+    ptr++;
+  }
+
+  if (*ptr == '\0') {
+    errno = EINVAL;
+    return -1;
+  }
+
+  syscall_id = explain_policy_get_syscall_id(fields[0]);
+  xerrno = parse_errno(fields[1]);
+  if (syscall_id < 0 ||
+      xerrno < 0 ||
+      parse_id(fields[2], &uid) < 0 ||
+      parse_id(fields[3], &gid) < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  (void) add_record(p, (unsigned int) syscall_id, xerrno, (uid_t) uid,
+    (gid_t) gid, ptr, input_idx, lineno);
+  return 1;
+}
+
+static int read_text(pool *p, FILE *fh, unsigned int input_idx) {
+  char line[PR_TUNABLE_PATH_MAX + 256];
+  unsigned long lineno = 0;
+  const struct ftpexplain_input *input;
+
+  input = &(((struct ftpexplain_input *) inputs->elts)[input_idx]);
+
+  while (fgets(line, sizeof(line), fh) != NULL) {
+    lineno++;
+
+    if (parse_line(p, line, input_idx, lineno) < 0) {
+      fprintf(stderr, "%s: %s:%lu: ignoring malformed record\n", program,
+        input->path, lineno);
+      nskipped++;
+    }
+  }
+
+  return 0;
+}
+
+struct journal_reader {
+  pool *pool;
+  unsigned int input_idx;
+};
+
+static int read_journal_entry(const struct explain_journal_entry *entry,
+    void *user_data) {
+  struct journal_reader *reader;
+
+  reader = user_data;
+
+  /* Records whose paths were overwritten cannot be explained. */
+  if (entry->path[0] == '\0') {
+    nskipped++;
+    return 0;
+  }
+
+  (void) add_record(reader->pool, entry->record.syscall_id,
+    entry->record.xerrno, (uid_t) entry->record.uid,
+    (gid_t) entry->record.gid, entry->path, reader->input_idx, entry->seq);
+  return 0;
+}
+
+static int read_input(pool *p, const char *path) {
+  struct ftpexplain_input *input;
+  unsigned int input_idx;
+  uint32_t magic = 0;
+  struct stat st;
+  FILE *fh;
+  int res;
+
+  input_idx = inputs->nelts;
+  input = push_array(inputs);
+  input->path = path;
+  input->is_journal = FALSE;
+
+  if (strcmp(path, "-") == 0) {
+    return read_text(p, stdin, input_idx);
+  }
+
+  fh = fopen(path, "r");
+  if (fh == NULL) {
+    return -1;
+  }
+
+  if (fstat(fileno(fh), &st) == 0 &&
+      S_ISREG(st.st_mode) &&
+      fread(&magic, sizeof(magic), 1, fh) == 1 &&
+      magic == EXPLAIN_JOURNAL_MAGIC) {
+    struct journal_reader reader;
+    void *region;
+
+    region = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fileno(fh), 0);
+    if (region == MAP_FAILED) {
+      int xerrno = errno;
+
+      fclose(fh);
+      errno = xerrno;
+      return -1;
+    }
+
+    input->is_journal = TRUE;
+    reader.pool = p;
+    reader.input_idx = input_idx;
+
+    res = explain_journal_read(region, st.st_size, read_journal_entry,
+      &reader);
+    (void) munmap(region, st.st_size);
+    fclose(fh);
+
+    return res < 0 ? -1 : 0;
+  }
+
+  rewind(fh);
+  res = read_text(p, fh, input_idx);
+  fclose(fh);
+
+  return res;
+}
+
+static int record_cmp(const void *a, const void *b) {
+  const struct ftpexplain_record *ra, *rb;
+  int res;
+
+  ra = a;
+  rb = b;
+
+  if (ra->uid != rb->uid) {
+    return ra->uid < rb->uid ? -1 : 1;
+  }
+
+  if (ra->gid != rb->gid) {
+    return ra->gid < rb->gid ? -1 : 1;
+  }
+
+  res = strcmp(ra->path, rb->path);
+  if (res != 0) {
+    return res;
+  }
+
+  /* Keep the records for the same path in their original order. */
+  if (ra->input_idx != rb->input_idx) {
+    return ra->input_idx < rb->input_idx ? -1 : 1;
+  }
+
+  return ra->lineno < rb->lineno ? -1 : (ra->lineno > rb->lineno ? 1 : 0);
+}
+
+/* Splits the sorted records into chunks, each of a single identity. */
+static void make_chunks(pool *p) {
+  register unsigned int i;
+  struct ftpexplain_record *recs;
+  struct ftpexplain_chunk *chunk = NULL;
+
+  recs = records->elts;
+  chunks = make_array(p, (records->nelts / FTPEXPLAIN_CHUNK_SIZE) + 1,
+    sizeof(struct ftpexplain_chunk));
+
+  for (i = 0; i < records->nelts; i++) {
+    if (chunk == NULL ||
+        chunk->count == FTPEXPLAIN_CHUNK_SIZE ||
+        recs[i].uid != recs[chunk->start].uid ||
+        recs[i].gid != recs[chunk->start].gid) {
+      chunk = push_array(chunks);
+      chunk->start = i;
+      chunk->count = 0;
+    }
+
+    chunk->count++;
+  }
+}
+
+static void deque_init(struct ftpexplain_deque *dq, unsigned int head,
+    unsigned int tail) {
+  dq->range = ((uint64_t) tail << 32) | head;
+}
+
+static unsigned int deque_size(struct ftpexplain_deque *dq) {
+  uint64_t range;
+  unsigned int head, tail;
+
+  range = deque_load(&(dq->range));
+  head = (unsigned int) (range & 0xffffffff);
+  tail = (unsigned int) (range >> 32);
+
+  return tail > head ? tail - head : 0;
+}
+
+static int deque_take(struct ftpexplain_deque *dq, int from_tail,
+    unsigned int *chunk_idx) {
+  uint64_t range, next;
+
+  range = deque_load(&(dq->range));
+  do {
+    unsigned int head, tail;
+
+    head = (unsigned int) (range & 0xffffffff);
+    tail = (unsigned int) (range >> 32);
+    if (head >= tail) {
+      return -1;
+    }
+
+    if (from_tail) {
+      tail--;
+      *chunk_idx = tail;
+
+    } else {
+      *chunk_idx = head;
+      head++;
+    }
+
+    next = ((uint64_t) tail << 32) | head;
+  } while (!deque_cas(&(dq->range), &range, next));
+
+  return 0;
+}
+
+/* Claims the next chunk for the given worker: its own, if it has any left,
+ * otherwise one stolen from the worker with the most left.
+ */
+static int next_chunk(unsigned int worker_idx, unsigned int *chunk_idx) {
+  while (TRUE) {
+    register unsigned int i;
+    unsigned int victim_idx = 0, victim_size = 0;
+
+    if (deque_take(&(shared->deques[worker_idx]), FALSE, chunk_idx) == 0) {
+      return 0;
+    }
+
+    for (i = 1; i < nworkers; i++) {
+      unsigned int idx, size;
+
+      idx = (worker_idx + i) % nworkers;
+      size = deque_size(&(shared->deques[idx]));
+      if (size > victim_size) {
+        victim_idx = idx;
+        victim_size = size;
+      }
+    }
+
+    if (victim_size == 0) {
+      return -1;
+    }
+
+    if (deque_take(&(shared->deques[victim_idx]), TRUE, chunk_idx) == 0) {
+      shared->stats[worker_idx].nstolen++;
+      return 0;
+    }
+
+    /* Lost the race for that chunk; look again. */
+  }
+}
+
+static void output_flush(void) {
+  size_t written = 0;
+
+  while (written < output_len) {
+    ssize_t res;
+
+    res = write(STDOUT_FILENO, output_buf + written, output_len - written);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      break;
+    }
+
+    written += res;
+  }
+
+  output_len = 0;
+}
+
+static void output_record(pool *p, const struct ftpexplain_record *record,
+    const char *explained) {
+  const struct ftpexplain_input *input;
+  const char *line;
+  size_t len;
+
+  input = &(((struct ftpexplain_input *) inputs->elts)[record->input_idx]);
+
+  line = psprintf(p, "%s%c%lu: %s '%s' by UID %lu, GID %lu: %s: %s\n",
+    input->path, input->is_journal ? '#' : ':', record->lineno,
+    explain_stats_syscall_name(record->syscall_id), record->path,
+    (unsigned long) record->uid, (unsigned long) record->gid,
+    strerror(record->xerrno),
+    explained != NULL ? explained : "(not explained)");
+  len = strlen(line);
+
+  if (output_len + len > FTPEXPLAIN_OUTPUT_BUFSZ) {
+    output_flush();
+  }
+
+  if (len > FTPEXPLAIN_OUTPUT_BUFSZ) {
+    (void) write(STDOUT_FILENO, line, len);
+    return;
+  }
+
+  memcpy(output_buf + output_len, line, len);
+  output_len += len;
+}
+
+/* Assumes the identity, including the supplementary groups, of the user
+ * whose failures are to be explained.  Returns -1 if that is not possible,
+ * in which case those failures cannot be explained faithfully.
+ */
+static int set_identity(uid_t uid, gid_t gid) {
+  struct passwd *pw;
+  int res, xerrno;
+
+  if (getuid() != PR_ROOT_UID) {
+    if (uid != geteuid() ||
+        gid != getegid()) {
+      fprintf(stderr, "%s: cannot switch to UID %lu, GID %lu unless run "
+        "as root\n", program, (unsigned long) uid, (unsigned long) gid);
+      return -1;
+    }
+
+    session.uid = uid;
+    session.gid = gid;
+    return 0;
+  }
+
+  if (seteuid(PR_ROOT_UID) < 0) {
+    xerrno = errno;
+    fprintf(stderr, "%s: error regaining root privileges: %s\n", program,
+      strerror(xerrno));
+    return -1;
+  }
+
+  /* Users known only to ProFTPD's own auth modules (e.g. AuthUserFile) have
+   * no system entry from which to look up their supplementary groups.
+   */
+  pw = getpwuid(uid);
+  if (pw != NULL) {
+    res = initgroups(pw->pw_name, gid);
+
+  } else {
+    res = setgroups(1, &gid);
+  }
+
+  if (res < 0 ||
+      setegid(gid) < 0 ||
+      seteuid(uid) < 0) {
+    xerrno = errno;
+    fprintf(stderr, "%s: error switching to UID %lu, GID %lu: %s\n", program,
+      (unsigned long) uid, (unsigned long) gid, strerror(xerrno));
+    return -1;
+  }
+
+  session.uid = uid;
+  session.gid = gid;
+  return 0;
+}
+
+/* Outputs the records of a chunk which cannot be explained. */
+static void skip_chunk(pool *p, unsigned int worker_idx,
+    const struct ftpexplain_chunk *chunk) {
+  register unsigned int i;
+  pool *tmp_pool;
+  struct ftpexplain_record *recs;
+
+  recs = ((struct ftpexplain_record *) records->elts) + chunk->start;
+
+  tmp_pool = make_sub_pool(p);
+  pr_pool_tag(tmp_pool, "ftpexplain chunk pool");
+
+  for (i = 0; i < chunk->count; i++) {
+    output_record(tmp_pool, &(recs[i]), NULL);
+  }
+
+  output_flush();
+  destroy_pool(tmp_pool);
+
+  shared->stats[worker_idx].nchunks++;
+  shared->stats[worker_idx].nrecords += chunk->count;
+}
+
+static void explain_chunk(pool *p, unsigned int worker_idx,
+    const struct ftpexplain_chunk *chunk) {
+  register unsigned int i;
+  pool *tmp_pool;
+  struct ftpexplain_record *recs;
+  struct explain_batch_entry *entries;
+  int res;
+
+  recs = ((struct ftpexplain_record *) records->elts) + chunk->start;
+
+  tmp_pool = make_sub_pool(p);
+  pr_pool_tag(tmp_pool, "ftpexplain chunk pool");
+
+  entries = pcalloc(tmp_pool,
+    sizeof(struct explain_batch_entry) * chunk->count);
+  for (i = 0; i < chunk->count; i++) {
+    entries[i].syscall_id = recs[i].syscall_id;
+    entries[i].xerrno = recs[i].xerrno;
+    entries[i].path = recs[i].path;
+  }
+
+  res = explain_batch_explain(tmp_pool, entries, chunk->count, verbosity);
+  if (res > 0) {
+    shared->stats[worker_idx].nexplained += res;
+  }
+
+  for (i = 0; i < chunk->count; i++) {
+    output_record(tmp_pool, &(recs[i]), entries[i].explained);
+  }
+
+  output_flush();
+  destroy_pool(tmp_pool);
+
+  shared->stats[worker_idx].nchunks++;
+  shared->stats[worker_idx].nrecords += chunk->count;
+}
+
+static void run_worker(pool *p, unsigned int worker_idx) {
+  unsigned int chunk_idx;
+  struct ftpexplain_chunk *chunk;
+  struct ftpexplain_record *recs;
+  uid_t uid = (uid_t) -1;
+  gid_t gid = (gid_t) -1;
+  int have_identity = FALSE;
+
+  output_buf = palloc(p, FTPEXPLAIN_OUTPUT_BUFSZ);
+  recs = records->elts;
+
+  while (next_chunk(worker_idx, &chunk_idx) == 0) {
+    chunk = &(((struct ftpexplain_chunk *) chunks->elts)[chunk_idx]);
+
+    if (recs[chunk->start].uid != uid ||
+        recs[chunk->start].gid != gid) {
+      uid = recs[chunk->start].uid;
+      gid = recs[chunk->start].gid;
+      have_identity = (set_identity(uid, gid) == 0);
+
+      /* Prefixes validated under one identity say nothing of another. */
+      explain_path_reset_resume();
+    }
+
+    if (have_identity == FALSE) {
+      skip_chunk(p, worker_idx, chunk);
+      continue;
+    }
+
+    explain_chunk(p, worker_idx, chunk);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  register int i;
+  int c, res;
+  long ncpus;
+  unsigned int nchunks;
+  unsigned long nexplained = 0, nstolen = 0;
+  pool *p;
+
+  ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (ncpus > 0) {
+    nworkers = ncpus > FTPEXPLAIN_MAX_WORKERS ? FTPEXPLAIN_MAX_WORKERS :
+      (unsigned int) ncpus;
+  }
+
+  while ((c = getopt(argc, argv, "hj:v:")) != -1) {
+    switch (c) {
+      case 'h':
+        show_usage(0);
+        break;
+
+      case 'j':
+        nworkers = (unsigned int) strtoul(optarg, NULL, 10);
+        if (nworkers == 0 ||
+            nworkers > FTPEXPLAIN_MAX_WORKERS) {
+          fprintf(stderr, "%s: workers must be between 1 and %u\n", program,
+            FTPEXPLAIN_MAX_WORKERS);
+          return 1;
+        }
+        break;
+
+      case 'v':
+        if (strcasecmp(optarg, "minimal") == 0) {
+          verbosity = PR_ERROR_FORMAT_USE_MINIMAL;
+
+        } else if (strcasecmp(optarg, "terse") == 0) {
+          verbosity = PR_ERROR_FORMAT_USE_TERSE;
+
+        } else if (strcasecmp(optarg, "detailed") == 0) {
+          verbosity = PR_ERROR_FORMAT_USE_DETAILED;
+
+        } else {
+          fprintf(stderr, "%s: unknown verbosity '%s'\n", program, optarg);
+          return 1;
+        }
+        break;
+
+      default:
+        show_usage(1);
+    }
+  }
+
+  if (optind >= argc) {
+    show_usage(1);
+  }
+
+#if !defined(HAVE___ATOMIC)
+  nworkers = 1;
+#endif /* !HAVE___ATOMIC */
+
+  init_pools();
+  init_fs();
+
+  p = make_sub_pool(permanent_pool);
+  pr_pool_tag(p, "ftpexplain pool");
+
+  inputs = make_array(p, argc - optind, sizeof(struct ftpexplain_input));
+  records = make_array(p, 1024, sizeof(struct ftpexplain_record));
+
+  for (i = optind; i < argc; i++) {
+    if (read_input(p, argv[i]) < 0) {
+      fprintf(stderr, "%s: error reading '%s': %s\n", program, argv[i],
+        strerror(errno));
+      return 1;
+    }
+  }
+
+  if (records->nelts == 0) {
+    fprintf(stderr, "%s: no records to explain\n", program);
+    return 0;
+  }
+
+  qsort(records->elts, records->nelts, sizeof(struct ftpexplain_record),
+    record_cmp);
+  make_chunks(p);
+  nchunks = chunks->nelts;
+
+  if (nworkers > nchunks) {
+    nworkers = nchunks;
+  }
+
+  shared = mmap(NULL, sizeof(struct ftpexplain_shared),
+    PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    fprintf(stderr, "%s: error mapping shared region: %s\n", program,
+      strerror(errno));
+    return 1;
+  }
+
+  memset(shared, 0, sizeof(struct ftpexplain_shared));
+  for (i = 0; i < (int) nworkers; i++) {
+    deque_init(&(shared->deques[i]),
+      (unsigned int) (((uint64_t) nchunks * i) / nworkers),
+      (unsigned int) (((uint64_t) nchunks * (i + 1)) / nworkers));
+  }
+
+  /* Anything common to every worker is set up once, before forking. */
+  explain_platform_init(p);
+  explain_probe_init(p);
+
+  /* Anything buffered now would otherwise be written by every worker. */
+  fflush(stdout);
+  fflush(stderr);
+
+  if (nworkers == 1) {
+    run_worker(p, 0);
+
+  } else {
+    pid_t *pids;
+
+    pids = pcalloc(p, sizeof(pid_t) * nworkers);
+    for (i = 0; i < (int) nworkers; i++) {
+      pids[i] = fork();
+      if (pids[i] < 0) {
+        fprintf(stderr, "%s: error starting worker: %s\n", program,
+          strerror(errno));
+
+        /* The chunks of any unstarted workers are stolen by the others. */
+        break;
+      }
+
+      if (pids[i] == 0) {
+        run_worker(p, i);
+        _exit(0);
+      }
+    }
+
+    if (i == 0) {
+      run_worker(p, 0);
+    }
+
+    while (i-- > 0) {
+      while (waitpid(pids[i], &res, 0) < 0 &&
+             errno == EINTR) {
+      }
+    }
+  }
+
+  for (i = 0; i < (int) nworkers; i++) {
+    nexplained += shared->stats[i].nexplained;
+    nstolen += shared->stats[i].nstolen;
+  }
+
+  fprintf(stderr, "%s: explained %lu of %u records (%lu skipped), in %u "
+    "chunks, with %u workers (%lu chunks stolen)\n", program, nexplained,
+    records->nelts, nskipped, nchunks, nworkers, nstolen);
+
+  (void) munmap(shared, sizeof(struct ftpexplain_shared));
+  destroy_pool(p);
+
+  return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * ProFTPD - mod_explain: journal reader
+ * Copyright (c) 2026 TJ Saunders
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA.
+ *
+ * As a special exemption, TJ Saunders and other respective copyright holders
+ * give permission to link this program with OpenSSL, and distribute the
+ * resulting executable, without including the source code for OpenSSL in the
+ * source distribution.
+ */
+
+/* Prints the records of an ExplainJournal file, oldest first. */
+
+#include "mod_explain.h"
+#include "journal.h"
+#include "stats.h"
+
+#include <sys/mman.h>
+
+static const char *program = "ftpjournal";
+
+struct journal_opts {
+  /* Only print records from this process, if non-zero. */
+  pid_t pid;
+
+  /* Only print this many of the most recent records, if non-zero. */
+  unsigned long count;
+  unsigned long skip;
+};
+
+static void show_usage(int exit_code) {
+  fprintf(stdout, "usage: %s [-h] [-n count] [-p pid] journal\n", program);
+  exit(exit_code);
+}
+
+static int count_entry(const struct explain_journal_entry *entry,
+    void *user_data) {
+  struct journal_opts *opts;
+
+  opts = user_data;
+  if (opts->pid == 0 ||
+      (pid_t) entry->record.pid == opts->pid) {
+    opts->skip++;
+  }
+
+  return 0;
+}
+
+static int print_entry(const struct explain_journal_entry *entry,
+    void *user_data) {
+  struct journal_opts *opts;
+  const struct explain_journal_record *record;
+  time_t secs;
+  struct tm *tm;
+  char ts[32];
+
+  opts = user_data;
+  record = &(entry->record);
+
+  if (opts->pid != 0 &&
+      (pid_t) record->pid != opts->pid) {
+    return 0;
+  }
+
+  if (opts->skip > 0) {
+    opts->skip--;
+    return 0;
+  }
+
+  secs = (time_t) (record->timestamp / 1000000);
+  tm = gmtime(&secs);
+  if (tm == NULL ||
+      strftime(ts, sizeof(ts), "%Y-%m-%d %H:%M:%S", tm) == 0) {
+    snprintf(ts, sizeof(ts), "%lu", (unsigned long) secs);
+  }
+
+  fprintf(stdout, "%s.%06lu #%lu pid %lu uid %lu gid %lu %s: %s (%d):",
+    ts, (unsigned long) (record->timestamp % 1000000),
+    (unsigned long) entry->seq, (unsigned long) record->pid,
+    (unsigned long) record->uid, (unsigned long) record->gid,
+    explain_stats_syscall_name(record->syscall_id), strerror(record->xerrno),
+    record->xerrno);
+
+  if (record->reason != EXPLAIN_REASON_UNKNOWN) {
+    fprintf(stdout, " %s at component %d,",
+      explain_journal_reason_name(record->reason), record->component_idx);
+  }
+
+  fprintf(stdout, " %lu usecs: %s\n", (unsigned long) record->usecs,
+    entry->path[0] != '\0' ? entry->path : "(path overwritten)");
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  int c, fd, res;
+  const char *path;
+  struct journal_opts opts;
+  struct stat st;
+  void *region;
+
+  memset(&opts, 0, sizeof(opts));
+
+  while ((c = getopt(argc, argv, "hn:p:")) != -1) {
+    switch (c) {
+      case 'h':
+        show_usage(0);
+        break;
+
+      case 'n':
+        opts.count = strtoul(optarg, NULL, 10);
+        break;
+
+      case 'p':
+        opts.pid = (pid_t) strtol(optarg, NULL, 10);
+        break;
+
+      default:
+        show_usage(1);
+    }
+  }
+
+  if (optind + 1 != argc) {
+    show_usage(1);
+  }
+
+  path = argv[optind];
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "%s: error opening '%s': %s\n", program, path,
+      strerror(errno));
+    return 1;
+  }
+
+  if (fstat(fd, &st) < 0) {
+    fprintf(stderr, "%s: error checking '%s': %s\n", program, path,
+      strerror(errno));
+    (void) close(fd);
+    return 1;
+  }
+
+  region = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (region == MAP_FAILED) {
+    fprintf(stderr, "%s: error mapping '%s': %s\n", program, path,
+      strerror(errno));
+    (void) close(fd);
+    return 1;
+  }
+
+  (void) close(fd);
+
+  if (opts.count > 0) {
+    /* Records may be appended between the passes; this only affects which
+     * of the most recent records are printed.
+     */
+    res = explain_journal_read(region, st.st_size, count_entry, &opts);
+    if (res >= 0) {
+      opts.skip = opts.skip > opts.count ? opts.skip - opts.count : 0;
+    }
+  }
+
+  res = explain_journal_read(region, st.st_size, print_entry, &opts);
+  if (res < 0) {
+    fprintf(stderr, "%s: '%s' is not an ExplainJournal file\n", program,
+      path);
+  }
+
+  (void) munmap(region, st.st_size);
+  return res < 0 ? 1 : 0;
+}